@@ -5,7 +5,11 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "hash.h"
 #include "objlist.h"
@@ -27,34 +31,54 @@ float RandomUniform(void)
 }
 #endif
 
-int GenerateAnnealPartition(int left, int right, int level)
-/* tries to find a balanced partition, as far as leaf cell usage */
+/* Multi-start annealing:  if AnnealStarts > 1, each partition is	*/
+/* annealed by AnnealStarts independent chains and the one with the	*/
+/* fewest cut nodes is kept.  Chains run on up to AnnealThreads threads	*/
+/* (0 = one per processor).  Each chain has its own random stream,	*/
+/* seeded from the default stream, so the result does not depend on	*/
+/* the number of threads.						*/
+int AnnealStarts = 1;
+int AnnealThreads = 0;
+
+/* state of one annealing chain */
+struct annealchain {
+  int *perm;			/* leaf order, indexed as 'permutation' */
+  int *lnodes;			/* node usage of the left partition */
+  int *rnodes;			/* node usage of the right partition */
+  struct randomstate *rs;	/* random stream; NULL for the default */
+  int verbose;			/* print progress (calling thread only) */
+  int cost;			/* cut nodes of the final partition */
+};
+
+#define ChainRandom(ch, max) \
+	(((ch)->rs == NULL) ? Random(max) : RandomState((ch)->rs, max))
+#define ChainUniform(ch) \
+	(((ch)->rs == NULL) ? RandomUniform() : RandomStateUniform((ch)->rs))
+
+static int ChainFanout(int *nodes)
+/* returns number of pins of a partition whose node usage is 'nodes' */
 {
-  int i;
-  int IncludedElements, partition;
-  int ChangesMade, Iterations;
-  int leftfanout, rightfanout;
-  float T;
-
-  level++;  /* just to keep to compiler from whining about unused parameter */
-
-  IncludedElements = (right - left) / 2;
-  partition = left + IncludedElements - 1;
+  int i, ports;
 
-  /* don't actually use {left,right}fanout, but need to 
-     initialize leftnodes and rightnodes arrays */
+  ports = 0;
+  for (i = 1; i <= Nodes; i++)
+    if (nodes[i] && (nodes[i] < NodeUsage[i] || PortNodes[i])) ports++;
+  return(ports);
+}
 
-  leftfanout = PartitionFanout(left, partition, LEFT);
-  rightfanout = PartitionFanout(partition + 1, right, RIGHT);
+static void RunAnnealChain(struct annealchain *ch, int left, int right,
+			   int partition)
+/* anneal the partition (left..partition) (partition+1..right) of ch */
+{
+  int i, k1, k2, end1, end2;
+  int ChangesMade, Iterations;
+  int *perm, *leftnodes, *rightnodes;
+  float T;
 
-#if 0
-  /* someday, need an escape clause here */
-  if (leftfanout <= TreeFanout[level] && rightfanout <= TreeFanout[level])
-	  return(partition);
-#endif
+  perm = ch->perm;
+  leftnodes = ch->lnodes;
+  rightnodes = ch->rnodes;
 
-Printf("called generateannealpartition with left = %d, right = %d\n",left,right);
-  /* actually do the annealing now */
   T = 3.0;
   do {
     int el1, el2;
@@ -63,83 +87,240 @@ Printf("called generateannealpartition with left = %d, right = %d\n",left,right)
     Iterations = 0;
     ChangesMade = 0;
     do {
-      el1 = Random(partition - left + 1) + left;
-      el2 = Random(right - partition) + partition + 1;
+      el1 = ChainRandom(ch, partition - left + 1) + left;
+      el2 = ChainRandom(ch, right - partition) + partition + 1;
       Iterations++;
 
       delta = 0;
-      for (i = 1; i <= Nodes; i++) {
-	/* could do the following test with XOR */
-	if (CSTAR[permutation[el1]][i] == 0 && CSTAR[permutation[el2]][i] == 0)
-	  continue;
-	if (CSTAR[permutation[el1]][i] != 0 && CSTAR[permutation[el2]][i] != 0)
-	  continue;
-
-	/* only one of these is non-zero */
-	if (CSTAR[permutation[el1]][i] != 0) {
+      /* only nodes used by exactly one of el1 and el2 can change */
+      k1 = FIRSTCONN(perm[el1]);
+      end1 = ENDCONN(perm[el1]);
+      k2 = FIRSTCONN(perm[el2]);
+      end2 = ENDCONN(perm[el2]);
+      while (k1 < end1 || k2 < end2) {
+	if (k1 < end1 && k2 < end2 && Conn[k1].node == Conn[k2].node) {
+	  k1++;
+	  k2++;
+	}
+	else if (k2 == end2 || (k1 < end1 && Conn[k1].node < Conn[k2].node)) {
+	  i = Conn[k1].node;
 	  if (rightnodes[i] == 0) {
 	    /* things are not good unless all the fanout is captured in el1 */
-	    if (CSTAR[permutation[el1]][i] != leftnodes[i]) delta++;
+	    if (Conn[k1].usage != leftnodes[i]) delta++;
 	  }
 	  else {
 	    /* things are good if all fanout is captured in el1 */
-	    if (CSTAR[permutation[el1]][i] == leftnodes[i]) delta--;
+	    if (Conn[k1].usage == leftnodes[i]) delta--;
 	  }
+	  k1++;
 	}
 	else {
+	  i = Conn[k2].node;
 	  if (leftnodes[i] == 0) {
 	    /* things are not good unless all the fanout is captured in el2 */
-	    if (CSTAR[permutation[el2]][i] != rightnodes[i]) delta++;
+	    if (Conn[k2].usage != rightnodes[i]) delta++;
 	  }
 	  else {
 	    /* things are good if all fanout is captured in el2 */
-	    if (CSTAR[permutation[el2]][i] == rightnodes[i]) delta--;
+	    if (Conn[k2].usage == rightnodes[i]) delta--;
 	  }
+	  k2++;
 	}
       }
+if (ch->verbose) {
 DBUG_EXECUTE("place",
 Printf("\n");
-Printf("considering swapping %d and %d\n",permutation[el1],permutation[el2]);
+Printf("considering swapping %d and %d\n",perm[el1],perm[el2]);
 Printf("E1: "); 
-for (i = 1; i <= Nodes; i++) Printf("%2d ",CSTAR[permutation[el1]][i]);
+for (i = 1; i <= Nodes; i++) Printf("%2d ",ConnUsage(perm[el1],i));
 Printf("\nL:  ");
 for (i = 1; i <= Nodes; i++) Printf("%2d ",leftnodes[i]);
 Printf("\nE2: ");
-for (i = 1; i <= Nodes; i++) Printf("%2d ",CSTAR[permutation[el2]][i]);
+for (i = 1; i <= Nodes; i++) Printf("%2d ",ConnUsage(perm[el2],i));
 Printf("\nR:  ");
 for (i = 1; i <= Nodes; i++) Printf("%2d ",rightnodes[i]);
 Printf("\nC0: ");
-for (i = 1; i <= Nodes; i++) Printf("%2d ",CSTAR[0][i]);
+for (i = 1; i <= Nodes; i++) Printf("%2d ",NodeUsage[i]);
 Printf("\ndelta = %d\n", delta);
 );
+}
 
-      if (delta < 0 || exp(-delta / T) > RandomUniform()) {
+      if (delta < 0 || exp(-delta / T) > ChainUniform(ch)) {
 	int tmp;
 
 	if (delta < 0) ChangesMade++;
 	/* update the {left, right}nodes arrays */
-	for (i = 1; i <= Nodes; i++) {
-	   leftnodes[i] +=
-		 CSTAR[permutation[el2]][i] - CSTAR[permutation[el1]][i];
-	   rightnodes[i] -=
-		 CSTAR[permutation[el2]][i] - CSTAR[permutation[el1]][i];
-        }
+	for (k1 = FIRSTCONN(perm[el1]); k1 < end1; k1++) {
+	   leftnodes[Conn[k1].node] -= Conn[k1].usage;
+	   rightnodes[Conn[k1].node] += Conn[k1].usage;
+	}
+	for (k2 = FIRSTCONN(perm[el2]); k2 < end2; k2++) {
+	   leftnodes[Conn[k2].node] += Conn[k2].usage;
+	   rightnodes[Conn[k2].node] -= Conn[k2].usage;
+	}
 	/* now swap the elements */
+if (ch->verbose) {
 DBUG_EXECUTE("place",
         Printf("swapping elements %d and %d\n",
-	       permutation[el1],permutation[el2]);
+	       perm[el1],perm[el2]);
 	);
-	tmp = permutation[el1];
-	permutation[el1] = permutation[el2];
-	permutation[el2] = tmp;
+}
+	tmp = perm[el1];
+	perm[el1] = perm[el2];
+	perm[el2] = tmp;
       }
       
     } while (ChangesMade <= MAX_CHANGES_PER_ITER && 
 	    Iterations < MAX_SIM_ANNEAL_ITER);
     T = 0.90 * T;
+if (ch->verbose)
 Printf("decreasing T to %.2f after %d iterations.\n",T,Iterations);
   } while (ChangesMade > 0);
 
+  ch->cost = ChainFanout(leftnodes) + ChainFanout(rightnodes);
+}
+
+/* chains shared by the threads of one multi-start run */
+struct annealjob {
+  struct annealchain *chains;
+  int nchains;
+  int next;		/* next chain to run */
+  int left, right, partition;
+  pthread_mutex_t lock;
+};
+
+static void *AnnealWorker(void *arg)
+/* run chains of the job until none are left */
+{
+  struct annealjob *job = (struct annealjob *)arg;
+  int c;
+
+  while (1) {
+    pthread_mutex_lock(&job->lock);
+    c = job->next++;
+    pthread_mutex_unlock(&job->lock);
+    if (c >= job->nchains) break;
+    RunAnnealChain(job->chains + c, job->left, job->right, job->partition);
+  }
+  return(NULL);
+}
+
+static int MultiStartAnneal(int left, int right, int partition)
+/* anneal AnnealStarts copies of the current partition and leave the best
+   in 'permutation', 'leftnodes' and 'rightnodes'; returns 0 if out of
+   memory, in which case nothing has been changed */
+{
+  struct annealjob job;
+  struct annealchain *chains;
+  struct randomstate *streams;
+  pthread_t *threads;
+  int c, nthreads, started, best, ok;
+
+  nthreads = AnnealThreads;
+  if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads > AnnealStarts) nthreads = AnnealStarts;
+  if (nthreads < 1) nthreads = 1;
+
+  chains = CALLOC(AnnealStarts, sizeof(struct annealchain));
+  streams = CALLOC(AnnealStarts, sizeof(struct randomstate));
+  threads = CALLOC(nthreads, sizeof(pthread_t));
+  ok = (chains != NULL && streams != NULL && threads != NULL);
+  for (c = 0; ok && c < AnnealStarts; c++) {
+    chains[c].perm = CALLOC(Leaves + 1, sizeof(int));
+    chains[c].lnodes = CALLOC(Nodes + 1, sizeof(int));
+    chains[c].rnodes = CALLOC(Nodes + 1, sizeof(int));
+    if (chains[c].perm == NULL || chains[c].lnodes == NULL
+		|| chains[c].rnodes == NULL) {
+      ok = 0;
+      break;
+    }
+    memcpy(chains[c].perm, permutation, (Leaves + 1) * sizeof(int));
+    memcpy(chains[c].lnodes, leftnodes, (Nodes + 1) * sizeof(int));
+    memcpy(chains[c].rnodes, rightnodes, (Nodes + 1) * sizeof(int));
+    RandomStateSeed(streams + c, Random(714024) + 1);
+    chains[c].rs = streams + c;
+    chains[c].verbose = 0;
+  }
+
+  if (ok) {
+    job.chains = chains;
+    job.nchains = AnnealStarts;
+    job.next = 0;
+    job.left = left;
+    job.right = right;
+    job.partition = partition;
+    pthread_mutex_init(&job.lock, NULL);
+
+    /* the calling thread runs chains too */
+    started = 0;
+    for (c = 1; c < nthreads; c++)
+      if (pthread_create(threads + started, NULL, AnnealWorker, &job) == 0)
+	started++;
+    AnnealWorker(&job);
+    for (c = 0; c < started; c++) pthread_join(threads[c], NULL);
+    pthread_mutex_destroy(&job.lock);
+
+    /* keep the best chain; ties go to the lowest numbered start */
+    best = 0;
+    for (c = 1; c < AnnealStarts; c++)
+      if (chains[c].cost < chains[best].cost) best = c;
+    memcpy(permutation + left, chains[best].perm + left,
+	   (right - left + 1) * sizeof(int));
+    memcpy(leftnodes, chains[best].lnodes, (Nodes + 1) * sizeof(int));
+    memcpy(rightnodes, chains[best].rnodes, (Nodes + 1) * sizeof(int));
+    Printf("%d annealing starts on %d thread%s; best is start %d "
+	   "with %d cut pins.\n", AnnealStarts, started + 1,
+	   (started == 0) ? "" : "s", best, chains[best].cost);
+  }
+
+  if (chains != NULL) {
+    for (c = 0; c < AnnealStarts; c++) {
+      if (chains[c].perm != NULL) FREE(chains[c].perm);
+      if (chains[c].lnodes != NULL) FREE(chains[c].lnodes);
+      if (chains[c].rnodes != NULL) FREE(chains[c].rnodes);
+    }
+    FREE(chains);
+  }
+  if (streams != NULL) FREE(streams);
+  if (threads != NULL) FREE(threads);
+  return(ok);
+}
+
+int GenerateAnnealPartition(int left, int right, int level)
+/* tries to find a balanced partition, as far as leaf cell usage */
+{
+  struct annealchain chain;
+  int IncludedElements, partition;
+  int leftfanout, rightfanout;
+
+  level++;  /* just to keep to compiler from whining about unused parameter */
+
+  IncludedElements = (right - left) / 2;
+  partition = left + IncludedElements - 1;
+
+  /* don't actually use {left,right}fanout, but need to 
+     initialize leftnodes and rightnodes arrays */
+
+  leftfanout = PartitionFanout(left, partition, LEFT);
+  rightfanout = PartitionFanout(partition + 1, right, RIGHT);
+
+#if 0
+  /* someday, need an escape clause here */
+  if (leftfanout <= TreeFanout[level] && rightfanout <= TreeFanout[level])
+	  return(partition);
+#endif
+
+Printf("called generateannealpartition with left = %d, right = %d\n",left,right);
+  /* actually do the annealing now */
+  if (AnnealStarts > 1 && MultiStartAnneal(left, right, partition))
+    return(partition);
+
+  chain.perm = permutation;
+  chain.lnodes = leftnodes;
+  chain.rnodes = rightnodes;
+  chain.rs = NULL;
+  chain.verbose = 1;
+  RunAnnealChain(&chain, left, right, partition);
   return (partition);
 }
 
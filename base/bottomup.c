@@ -48,8 +48,8 @@ int Independent(int E1, int E2)
 
 int FanoutOK(int E1, int E2)
 {
-  int approxfanout;
-  int node;
+  int approxfanout, i;
+  unsigned long *b1, *b2;
 	
   CountFanoutOK++;
 
@@ -57,9 +57,10 @@ int FanoutOK(int E1, int E2)
   /* remember, the current PROTOCHIP requires allocation of 
      an output even for swallowed nodes */
 
+  b1 = PINBITS(E1);
+  b2 = PINBITS(E2);
   approxfanout = 0;
-  for (node = 1; node <= Nodes; node++)
-    if (C[E1][node] || C[E2][node]) approxfanout++;
+  for (i = 0; i < PinWords; i++) approxfanout += BitCount(b1[i] | b2[i]);
   if (approxfanout > TreeFanout[MAX(LEVEL(E1),LEVEL(E2)) + 1]) return(0);
   return(1);
 }
@@ -68,10 +69,13 @@ int FanoutOK(int E1, int E2)
 int Swallowed(int Parent, int Child)
 /* returns 1 if Child's fanout is contained in Parent's */
 {
-  int node;
+  int i;
+  unsigned long *child, *parent;
 
-  for (node = 1; node <= Nodes; node++) 
-    if (C[Child][node] && !(C[Parent][node])) return(0);
+  child = PINBITS(Child);
+  parent = PINBITS(Parent);
+  for (i = 0; i < PinWords; i++)
+    if (child[i] & ~parent[i]) return(0);
 
 #ifdef PLACE_DEBUG
   Printf("Element %d swallowed by %d\n",Child,Parent);
@@ -85,15 +89,22 @@ int Swallowed(int Parent, int Child)
 int SmallEnough(int E1, int E2)
 /* returns 1 if fanout(E1+E2) is less than MAX(fanout(E1),fanout(E2)) */
 {
-  int node;
+  int k1, k2;
   int fanout;
+  struct conn *cp;
 
   return(0); /* for now */
 
   fanout = 0;
-  for (node = 1; node <= Nodes; node++)
-    if (C[E1][node] || C[E2][node]) 
-      if (CSTAR[E1][node] + CSTAR[E2][node] < CSTAR[0][node]) fanout++;
+  for (k1 = FIRSTCONN(E1); k1 < ENDCONN(E1); k1++) {
+    cp = FindConn(E2, Conn[k1].node);
+    if ((Conn[k1].pin || (cp != NULL && cp->pin)) &&
+	Conn[k1].usage + (cp != NULL ? cp->usage : 0)
+	< NodeUsage[Conn[k1].node]) fanout++;
+  }
+  for (k2 = FIRSTCONN(E2); k2 < ENDCONN(E2); k2++)
+    if (Conn[k2].pin && FindConn(E1, Conn[k2].node) == NULL &&
+	Conn[k2].usage < NodeUsage[Conn[k2].node]) fanout++;
 
   return (fanout <= MAX(PINS(E1), PINS(E2)));
 
@@ -270,7 +281,6 @@ int DoAPass(int Level1, int Level2)
 	  found = NewN;
 	  goto done;
 	}
-	if (NewN >= MAX_ELEMENTS) return(MAX_ELEMENTS);
 	if (FatalError) goto done;
 	/* break; do not consider E1 or E2 any further */
       }
@@ -317,7 +327,6 @@ int DoAPass(int Level1, int Level2)
 	  found = NewN;
 	  goto done;
 	}
-	if (NewN >= MAX_ELEMENTS) return(MAX_ELEMENTS);
 	if (FatalError) goto done;
       }
     }
@@ -430,7 +439,6 @@ int DoAPass(int Level1, int Level2)
 	  found = NewN;
 	  goto done;
 	}
-	if (NewN >= MAX_ELEMENTS) return(MAX_ELEMENTS);
 	if (FatalError) goto done;
       }
     }
@@ -501,7 +509,6 @@ int ExhaustivePass(int Level)
 	  found = NewN;
 	  goto done;
 	}
-	if (NewN >= MAX_ELEMENTS) return(MAX_ELEMENTS);
 #if 0
 	if (Swallowed(E1,E2)) break;  /* works OK, but makes csrlntk 5 deep*/
 #endif
@@ -543,15 +550,17 @@ void PROLOG(FILE *f)
   junk = Leaves - 1;
   for (MinDoneLevel = 0; junk; MinDoneLevel++) junk = junk >> 1;
 
-  Fprintf(f,"MAX_ELEMENTS = %d, ",MAX_ELEMENTS);
   Fprintf(f,"MAX_LEAVES = %d, ",MAX_LEAVES);
-  Fprintf(f,"MAX_NODES = %d, ",MAX_NODES);
   Fprintf(f,"MAX_TREE_DEPTH = %d\n",MAX_TREE_DEPTH); 
 
-  Fprintf(f,"Matrix sizes: M = %ldK, MSTAR = %ldK, C = %ldK, CSTAR = %ldK\n",
-	  (long)sizeof(M)/1024,(long)sizeof(MSTAR)/1024,
-	  (long)sizeof(C)/1024, (long)sizeof(CSTAR)/1024);
-  totalsize = sizeof(M) + sizeof(MSTAR) + sizeof(C) + sizeof(CSTAR);
+  Fprintf(f,"Matrix sizes: M = %ldK, MSTAR = %ldK, C = %ldK (%d elements)\n",
+	  (long)(MaxElements * sizeof(*M))/1024,
+	  (long)(MaxElements * sizeof(*MSTAR))/1024,
+	  (long)(MaxConn * sizeof(struct conn)
+		+ MaxElements * PinWords * sizeof(unsigned long))/1024,
+	  MaxElements);
+  totalsize = MaxElements * (sizeof(*M) + sizeof(*MSTAR) + sizeof(int)
+	+ PinWords * sizeof(unsigned long)) + MaxConn * sizeof(struct conn);
 #ifdef EX_TREE_FOR_EXIST
   totalsize +=  sizeof(ex_array);
   Fprintf(f,"              ex_array = %ldK, total = %ldK\n",
@@ -604,7 +613,7 @@ void EmbedCell(char *cellname, char *filename)
   if (Exhaustive) {
     for (level1 = 0; level1 < MAX_TREE_DEPTH; level1++) {
       found = ExhaustivePass(level1);
-      if (found || FatalError) goto done;
+      if (found || FatalError || LimitReached) goto done;
     }
   }
   else {
@@ -615,13 +624,13 @@ void EmbedCell(char *cellname, char *filename)
       for (level1 = FillingLevel - 1; level1 >= 0 || found == -1; level1--){
 	if (found == -1) level1 = 0;
 	found = DoAPass(FillingLevel, level1);
-	if (found || FatalError) goto done;
+	if (found || FatalError || LimitReached) goto done;
 	/* now try to go up the ladder */
 	/* NewElements = 1; only do it if we added something in DoAPass */
 	for (level2 = FillingLevel + 1; 
 	     NewElements && level2 < MAX_TREE_DEPTH; level2++) {
 	  found = DoAPass(level2, level2);
-	  if (found || FatalError) goto done;
+	  if (found || FatalError || LimitReached) goto done;
 	}
       }
     }
@@ -637,13 +646,13 @@ void EmbedCell(char *cellname, char *filename)
 	if (found == -1) level1 = 0;
 	found = DoAPass(FillingLevel, level1);
 	if (NewElements) SomeNewElements = 1;
-	if (found || FatalError) goto done;
+	if (found || FatalError || LimitReached) goto done;
 	/* now try to go up the ladder */
 	NewElements = 1;
 	for (level2 = FillingLevel + 1; 
 	     NewElements && level2 < MAX_TREE_DEPTH; level2++) {
 	  found = DoAPass(level2, level2);
-	  if (found || FatalError) goto done;
+	  if (found || FatalError || LimitReached) goto done;
 	}
       }
     }
@@ -656,7 +665,10 @@ void EmbedCell(char *cellname, char *filename)
     Fprintf(outfile,"Internal Fatal Error\n");
     found = 0;
   }
-  if (found >= MAX_ELEMENTS) found = 0;
+  else if (LimitReached && !found) {
+    Fprintf(stdout,"No embedding found within %d elements\n",ElementLimit);
+    Fprintf(outfile,"No embedding found within %d elements\n",ElementLimit);
+  }
 	
   if (found) {
     struct nlist *tp;
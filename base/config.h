@@ -154,21 +154,40 @@ extern int open(char *path, int oflag, ...); /* HPUX has it in <sys/fcntl.h> */
 /* get random number functions, and any string functions we are missing */
 #include "pdutils.h"
 
-/* Casting of allocation functions */
-#ifdef TCL_NETGEN
-  #define CALLOC(a, s)	tcl_calloc(a, s)
-  #define MALLOC(s)	Tcl_Alloc(s)
-  #define FREE(a)	Tcl_Free((char *)a)
-  extern char *Tcl_Strdup(const char *);
-  #define STRDUP(a)	Tcl_Strdup((const char *)a)
-#else
-  #include <stdlib.h>
-  #define CALLOC(a, s)	calloc(a, s)
-  #define MALLOC(s)	malloc(s)
-  #define FREE(a)	free(a)
-  #define STRDUP(a)	strdup(a)
+/* Allocation functions.  All allocation goes through these macros.	*/
+/* In builds configured with --enable-memstats (MEMSTATS defined),	*/
+/* they record the size, category and file number of each block (see	*/
+/* memstats.c).  A source file selects the category of its own	*/
+/* allocations by defining MEMTAG before including this file, and	*/
+/* may tag individual allocations with MALLOCTAG() and CALLOCTAG().	*/
+
+#define MEM_OTHER	0
+#define MEM_CELL	1	/* cells and object lists */
+#define MEM_HASH	2	/* hash tables and buckets */
+#define MEM_STRING	3	/* strings from STRDUP() */
+#define MEM_PROPERTY	4	/* property records and values */
+#define MEM_COMPARE	5	/* comparison graph */
+#define MEM_PARSE	6	/* netlist reader buffers */
+#define MEM_NUMCLASSES	7
+
+#ifndef MEMTAG
+#define MEMTAG		MEM_OTHER
 #endif
 
+#include <stddef.h>
+#include <stdlib.h>
+extern void *MemAlloc(size_t size, int tag);
+extern void *MemCalloc(size_t nmemb, size_t size, int tag);
+extern void MemFree(void *ptr);
+extern char *MemStrdup(const char *s);
+
+#define CALLOC(a, s)		MemCalloc(a, s, MEMTAG)
+#define MALLOC(s)		MemAlloc(s, MEMTAG)
+#define CALLOCTAG(a, s, t)	MemCalloc(a, s, t)
+#define MALLOCTAG(s, t)		MemAlloc(s, t)
+#define FREE(a)			MemFree((void *)(a))
+#define STRDUP(a)		MemStrdup((const char *)(a))
+
 #ifndef TRUE
 #define TRUE 1
 #endif
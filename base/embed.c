@@ -331,8 +331,11 @@ struct ex_entry {
   struct ex_entry *next;
 };
 
+/* number of buckets in the exist hash table */
+#define EX_HASHSIZE 5000
+
 #if 1
-struct ex_entry *ex_tab[MAX_ELEMENTS];
+struct ex_entry *ex_tab[EX_HASHSIZE];
 #else
 #ifdef IBMPC
 struct ex_entry *ex_tab[4100];
@@ -366,7 +369,7 @@ static unsigned long lochash(unsigned long *mstar)
 #endif
 
 #if 1
-  hashval = hashval % (MAX_ELEMENTS - 1);
+  hashval = hashval % (EX_HASHSIZE - 1);
 #else
   hashval = (hashval >> 16) ^ (hashval & 0x0000FFFFL);
 #ifdef IBMPC
@@ -6,8 +6,6 @@
 /* #define MAX_ELEMENTS 20000 */
 /* #define MAX_NODES 72 */
 /* #define MAX_LEAVES 64 */
-#define MAX_ELEMENTS 5000
-#define MAX_NODES 150
 #define MAX_TREE_DEPTH 8
 /* #define MAX_LEAVES 256 */
 #define MAX_LEAVES (1<<MAX_TREE_DEPTH)
@@ -15,8 +13,6 @@
 /* #endif */ /* VMUNIX */
 
 #ifdef IBMPC
-#define MAX_ELEMENTS 100
-#define MAX_NODES 20
 #define MAX_LEAVES 16
 #define MAX_TREE_DEPTH 4
 #define BITS_PER_LONG 32
@@ -28,7 +24,8 @@
 
 /* abridged ownership and connectivity matrices */
 /* elements, nodes, leaves are indexed from 1 to N, nodes, leaves */
-extern unsigned short M[][7];
+/* rows of M and MSTAR are allocated as elements are added */
+extern int (*M)[7];
   /* height, L, R, SWALLOWED, PINS, LEAVES, USED */
 #define LEVEL(e)     (M[e][0])
 #define L(e)         (M[e][1])
@@ -38,14 +35,48 @@ extern unsigned short M[][7];
 #define LEAVES(e)    (M[e][5])
 #define USED(e)      (M[e][6])
 
-extern unsigned long MSTAR[MAX_ELEMENTS][(MAX_LEAVES / BITS_PER_LONG)  + 1];
+#define MSTARWORDS ((MAX_LEAVES / BITS_PER_LONG)  + 1)
+extern unsigned long (*MSTAR)[MSTARWORDS];
 #define SetPackedArrayBit(A,B) \
        (A [(B) / BITS_PER_LONG] |= (1L << ((B)%BITS_PER_LONG)))
 #define TestPackedArrayBit(A,B) \
        (A [(B) / BITS_PER_LONG] & (1L << ((B)%BITS_PER_LONG)))
 
-extern unsigned char C[MAX_ELEMENTS][MAX_NODES + 1];
-extern unsigned char CSTAR[MAX_ELEMENTS][MAX_NODES + 1];
+/* Sparse connectivity.  Element e connects to the nodes in entries	*/
+/* Conn[FIRSTCONN(e)] up to (not including) Conn[ENDCONN(e)], sorted	*/
+/* by node number.  "usage" is the number of leaf pins of e on the node	*/
+/* (formerly the CSTAR matrix) and "pin" is set if the node is a port	*/
+/* of e (formerly the C matrix).  Nodes that e does not touch have no	*/
+/* entry.  Row 0 is the whole cell:  every node, its total usage, and	*/
+/* "pin" set for the cell's ports.  Row 0 is also kept as the dense	*/
+/* arrays PortNodes[] and NodeUsage[], indexed by node.			*/
+
+struct conn {
+  int node;
+  int usage;
+  unsigned char pin;
+};
+
+extern struct conn *Conn;
+extern int *ConnStart;
+#define FIRSTCONN(e) (ConnStart[e])
+#define ENDCONN(e)   (ConnStart[(e) + 1])
+
+extern unsigned char *PortNodes;  /* PortNodes[n] == pin of node n in row 0 */
+extern int *NodeUsage;            /* NodeUsage[n] == usage of node n in row 0 */
+
+/* The pin flags of each row are also packed into PinWords words per	*/
+/* element, so that pin sets can be compared a word at a time.  Row 0	*/
+/* holds the ports of the cell.						*/
+extern unsigned long *PinBits;
+extern int PinWords;
+#define PINBITS(e) (PinBits + (e) * PinWords)
+
+#ifdef __GNUC__
+#define BitCount(w) __builtin_popcountl(w)
+#else
+extern int BitCount(unsigned long w);
+#endif
 
 extern int PackedLeaves;
 extern int CountExists;
@@ -69,10 +100,15 @@ extern struct embed *EmbeddingTree(struct nlist *tp, int E);
 extern void PrintEmbeddingTree(FILE *outfile, char *cellname, int flatten);
 
 
-/* different embedding strategies, found in random.c, anneal.c, greedy.c */
+/* different embedding strategies, found in random.c, anneal.c, greedy.c,
+   multilevel.c */
 extern int RandomPartition(int left, int right, int level);  /* random.c */
 extern int AnnealPartition(int left, int right, int level);  /* anneal.c */
+extern int AnnealStarts;   /* annealing chains per partition (anneal.c) */
+extern int AnnealThreads;  /* threads for the chains, 0 = one per processor */
 extern int GreedyPartition(int left, int right, int level);  /* greedy.c */
+extern int MultilevelPartition(int left, int right, int level);
+							 /* multilevel.c */
 extern void EmbedCell(char *cellname, char *filename);       /* bottomup.c */
 
 extern int GradientDescent(int left, int right, int partition);  /* place.c */
@@ -81,10 +117,11 @@ extern int GradientDescent(int left, int right, int partition);  /* place.c */
 extern int permutation[];
 extern int TopDownStartLevel;
 extern int TreeFanout[];
-extern int leftnodes[];
-extern int rightnodes[];
+extern int *leftnodes;
+extern int *rightnodes;
 
-enum EmbeddingStrategy {random_embedding, greedy, anneal, bottomup} ;
+enum EmbeddingStrategy {random_embedding, greedy, anneal, bottomup,
+			multilevel} ;
 
 extern void TopDownEmbedCell(char *cellname, char *filename, 
 			     enum EmbeddingStrategy strategy);
@@ -98,15 +135,10 @@ extern void TopDownEmbedCell(char *cellname, char *filename,
 
 #define IsLeaf(E) (L(E) == 0 && R(E) == 0)
 
-/* abridged ownership and connectivity matrices */
-/* elements, nodes, leaves are indexed from 1 to N, nodes, leaves */
-extern unsigned short M[MAX_ELEMENTS][7];  
-/* height, L, R, SWALLOWED, PINS, LEAVES, USED */
-
-extern unsigned long MSTAR[MAX_ELEMENTS][(MAX_LEAVES / BITS_PER_LONG)  + 1];
-
-extern unsigned char C[MAX_ELEMENTS][MAX_NODES + 1];
-extern unsigned char CSTAR[MAX_ELEMENTS][MAX_NODES + 1];
+/* allocated sizes of M, MSTAR, ConnStart (MaxElements) and Conn (MaxConn) */
+extern int MaxElements;
+extern int MaxConn;
+extern int ElementLimit;  /* most elements in one embedding, 0 = no limit */
 
 /* elements at level i must have TreeFanout[i] or fewer ports */
 extern int TreeFanout[MAX_TREE_DEPTH + 1];       /* tree fanout at each level */
@@ -131,6 +163,7 @@ extern int selectivelogging;
 extern int LogLevel1; /* automatically log if Level1 == LogLevel1 */
 extern int LogLevel2;
 extern int FatalError; /* internal error */
+extern int LimitReached; /* embedding stopped at ElementLimit */
 extern int Exhaustive; /* slow, methodical */
 extern int PlaceDebug; /* interactive debug */
 
@@ -169,4 +202,6 @@ extern void SetupLeafPinout(char *string);
 extern void PrintOwnership(FILE *outfile);
 extern void PrintC(FILE *outfile);
 extern void PrintCSTAR(FILE *outfile);
+extern struct conn *FindConn(int E, int node);
+extern int ConnUsage(int E, int node);
 extern void PrintE(FILE *outfile, int E);
@@ -18,6 +18,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* ext.c  --  Input/output routines for Berkeley .ext and .sim formats */
 
+#define MEMTAG MEM_PARSE	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -30,9 +31,31 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "netfile.h"
 #include "print.h"
 #include "hash.h"
+#include "timing.h"
 
 static int invlambda = 100;	/* Used in sim and prm files */
 
+/* Find the value of property "key" in the property record "ob" of an	*/
+/* instance of cell "tp".  Return NULL if the property is not present.	*/
+
+static struct valuelist *simPropValue(struct nlist *tp, struct objlist *ob,
+	char *key)
+{
+  struct property *kl;
+  struct valuelist *vl;
+  int i;
+
+  kl = (struct property *)HashLookup(key, &(tp->propdict));
+  if (kl == NULL) return NULL;
+
+  for (i = 0;; i++) {
+    vl = &(ob->instance.props[i]);
+    if (vl->type == PROP_ENDLIST) break;
+    if (PropertyLookup(tp, vl) == kl) return vl;
+  }
+  return NULL;
+}
+
 void extCell(char *name, int filenum)
 {
   struct nlist *tp, *tp2;
@@ -427,7 +450,10 @@ char *ReadExt(char *fname, int doflat, int *fnum)
       SkipNewLine(NULL);
     }
   }
-  CloseParseFile();
+  if (CloseNetlistFile(fname, *fnum, filenum) != 0) {
+    *fnum = -1;
+    return NULL;
+  }
   *fnum = filenum;
   return (CellDefInProgress) ? CurrentCell->name : NULL;
 }
@@ -436,12 +462,22 @@ char *ReadExt(char *fname, int doflat, int *fnum)
 
 char *ReadExtHier(char *fname, int *fnum)
 {
-   return ReadExt(fname, 0, fnum);
+   char *result;
+
+   StatStart(STAT_READ_EXT);
+   result = ReadExt(fname, 0, fnum);
+   StatStop(STAT_READ_EXT);
+   return result;
 }
 
 char *ReadExtFlat(char *fname, int *fnum)
 {
-   return ReadExt(fname, 1, fnum);
+   char *result;
+
+   StatStart(STAT_READ_EXT);
+   result = ReadExt(fname, 1, fnum);
+   StatStop(STAT_READ_EXT);
+   return result;
 }
 
 
@@ -550,13 +586,13 @@ void simCell(char *name, int filenum)
 	    l = 2;
 	    w = 4;
 	    if (ob2 && ob2->type == PROPERTY) {
-	       struct property *kl;
 	       struct valuelist *vl;
-	       kl = (struct property *)HashLookup("length", &(tp2->propdict));
-	       vl = (struct valuelist *)ob2->instance.name;
-	       l = 1.0e6 * vl[kl->idx].value.dval;	/* m -> um */
-	       kl = (struct property *)HashLookup("width", &(tp2->propdict));
-	       w = 1.0e6 * vl[kl->idx].value.dval;	/* m -> um */
+	       vl = simPropValue(tp2, ob2, "length");
+	       if (vl != NULL)
+	          l = 1.0e6 * vl->value.dval;	/* m -> um */
+	       vl = simPropValue(tp2, ob2, "width");
+	       if (vl != NULL)
+	          w = 1.0e6 * vl->value.dval;	/* m -> um */
 	    }
 	    FlushString(" %g %g\n", l, w);   
 	    break;
@@ -585,13 +621,11 @@ void simCell(char *name, int filenum)
 	      ob2 = ob2->next;  /* Skip dummy node on 3-terminal devices */
 
 	    if (ob2 && ob2->type == PROPERTY) {
-	       struct property *kl;
 	       struct valuelist *vl;
-	       kl = (struct property *)HashLookup("value", &(tp2->propdict));
-	       vl = (struct valuelist *)ob2->instance.name;
-	       if (tp2->class == CLASS_CAP)
-	          v = 1.0e15 * vl[kl->idx].value.dval;	/* F -> fF */
-	       else if (tp2->class == CLASS_RES)
+	       vl = simPropValue(tp2, ob2, "value");
+	       if ((vl != NULL) && (tp2->class == CLASS_CAP))
+	          v = 1.0e15 * vl->value.dval;	/* F -> fF */
+	       else if ((vl != NULL) && (tp2->class == CLASS_RES))
 		  v = vl->value.dval;		/* Ohms (no conversion) */
 	    }
 	    FlushString(" %g\n", v);   
@@ -908,7 +942,10 @@ char *ReadPrm(char *fname, int *fnum)
     DeleteProperties(&kvlist);
   }
   EndCell();
-  CloseParseFile();
+  if (CloseNetlistFile(fname, *fnum, filenum) != 0) {
+    *fnum = -1;
+    return NULL;
+  }
 
   tp = LookupCellFile(fname, filenum);
   if (tp) tp->flags |= CELL_TOP;
@@ -930,6 +967,7 @@ char *ReadSim(char *fname, int *fnum)
   struct nlist *tp;
   double simscale = 1.0;
 
+  StatStart(STAT_READ_SIM);
   if ((filenum = OpenParseFile(fname, *fnum)) < 0) {
     char name[MAX_STR_LEN];
 
@@ -937,6 +975,7 @@ char *ReadSim(char *fname, int *fnum)
     if (OpenParseFile(name, *fnum) < 0) {
       Printf("Error in sim file read: No file %s\n",name);
       *fnum = filenum;
+      StatStop(STAT_READ_SIM);
       return NULL;
     }    
   }
@@ -1230,11 +1269,16 @@ char *ReadSim(char *fname, int *fnum)
     DeleteProperties(&kvlist);
   }
   EndCell();
-  CloseParseFile();
+  if (CloseNetlistFile(fname, *fnum, filenum) != 0) {
+    *fnum = -1;
+    StatStop(STAT_READ_SIM);
+    return NULL;
+  }
 
   tp = LookupCellFile(fname, filenum);
   if (tp) tp->flags |= CELL_TOP;
 
   *fnum = filenum;
+  StatStop(STAT_READ_SIM);
   return fname;
 }
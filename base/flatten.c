@@ -21,6 +21,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
                  just particular classes of subcells
 */		 
 
+#define MEMTAG MEM_CELL	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -39,6 +40,8 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "objlist.h"
 #include "print.h"
 #include "netcmp.h"
+#include "timing.h"
+#include "memstats.h"
 
 extern struct hashdict spiceparams;
 
@@ -73,6 +76,13 @@ void flattenCell(char *name, int file)
   /* Placeholder cells must not be flattened */
   if (ThisCell->flags & CELL_PLACEHOLDER) return;
 
+  /* Library cells are read-only */
+  if (ThisCell->flags & CELL_LIBRARY) {
+    Printf("Cell %s (%d) is a library cell and cannot be flattened.\n",
+		name, file);
+    return;
+  }
+
   FreeNodeNames(ThisCell);
 
   ParentParams = ThisCell->cell;
@@ -103,6 +113,7 @@ void flattenCell(char *name, int file)
 			ChildCell->file);
 
       ChildObjList = CopyObjList(ChildCell->cell, 1);
+      StatCount(STAT_FLATTEN, 1);
 
       /* update node numbers in child to unique numbers */
       oldmax = 0;
@@ -238,7 +249,7 @@ void flattenCell(char *name, int file)
       NextObj = ParentParams;
     }				/* repeat until no more instances found */
   }
-  CacheNodeNames(ThisCell);
+  FreeNodeNames(ThisCell);
   ThisCell->dumped = 1;		/* indicate cell has been flattened */
 }
 
@@ -275,6 +286,7 @@ int flattenInstancesOf(char *name, int fnum, char *instance)
   int	notdone, rnodenum;
   char	tmpstr[1024];
   int	nextnode, oldmax, numflat = 0;
+  int	memfile;
 #if !OLDPREFIX
   int     prefixlength;
 #endif
@@ -301,6 +313,15 @@ int flattenInstancesOf(char *name, int fnum, char *instance)
     }
   }
 
+  /* Library cells are read-only */
+  if (ThisCell->flags & CELL_LIBRARY) {
+    Printf("Cell %s (%d) is a library cell and cannot be flattened.\n",
+		ThisCell->name, ThisCell->file);
+    return 0;
+  }
+
+  StatStart(STAT_FLATTEN);
+  memfile = MemSetFile(ThisCell->file);
   FreeNodeNames(ThisCell);
 
   ParentParams = ThisCell->cell;
@@ -680,16 +701,25 @@ int flattenInstancesOf(char *name, int fnum, char *instance)
      FREE(chknode);
   }
 
-  CacheNodeNames(ThisCell);
+  FreeNodeNames(ThisCell);
   ThisCell->dumped = 1;		/* indicate cell has been flattened */
+  MemSetFile(memfile);
+  StatCount(STAT_FLATTEN, (long)numflat);
+  StatStop(STAT_FLATTEN);
   return numflat;
 }
 
 
 void Flatten(char *name, int file)
 {
+    int memfile;
+
+    StatStart(STAT_FLATTEN);
+    memfile = MemSetFile(file);
     ClearDumpedList(); /* keep track of flattened cells */
     flattenCell(name, file);
+    MemSetFile(memfile);
+    StatStop(STAT_FLATTEN);
 }
 
 
@@ -727,10 +757,12 @@ void FlattenInstancesOf(char *model, int file)
       FlattenInstancesOf(model, Circuit2->file);
       return;
    }
+   StatStart(STAT_FLATTEN);
    ClearDumpedList(); /* keep track of flattened cells */
    model_to_flatten = strsave(model);
    RecurseCellFileHashTable(flattenoneentry, file);
    FREE(model_to_flatten);
+   StatStop(STAT_FLATTEN);
 }
 
 /*
@@ -892,7 +924,7 @@ void convertGlobalsOf(char *name, int fnum, char *instance)
       HashPtrInstall(newpin->name, newpin, &(ThisCell->objdict));
 
    }
-   CacheNodeNames(ThisCell);
+   FreeNodeNames(ThisCell);
 }
 
 /*
@@ -1041,8 +1073,8 @@ void ConvertGlobals(char *name, int filenum)
       }
    }
 
-   /* Regenerate the node name cache */
-   CacheNodeNames(ThisCell);
+   /* Node names are regenerated when next used */
+   FreeNodeNames(ThisCell);
 }
 
 /*------------------------------------------------------*/
@@ -1169,7 +1201,7 @@ struct nlist *uniquepins(struct hashlist *p, void *clientdata)
 	 }
       }
    }
-   if (modified) CacheNodeNames(ptr);
+   if (modified) FreeNodeNames(ptr);
 
    return NULL;
 }
@@ -1205,6 +1237,9 @@ int UniquePins(char *name, int filenum)
       return 0;
    }
 
+   /* Library cells are read-only */
+   if (ThisCell->flags & CELL_LIBRARY) return 0;
+
    maxnode = 0;
    for (ob = ThisCell->cell; ob != NULL; ob = ob->next) {
       if (ob->type != PORT) break;
@@ -1300,7 +1335,7 @@ int UniquePins(char *name, int filenum)
       }
    }
 
-   if (needscleanup) CacheNodeNames(ThisCell);
+   if (needscleanup) FreeNodeNames(ThisCell);
 
    FREE(nodecount);
    FREE(firstpin);
@@ -1486,6 +1521,9 @@ int CleanupPins(char *name, int filenum)
       return 0;
    }
 
+   /* Library cells are read-only */
+   if (ThisCell->flags & CELL_LIBRARY) return 0;
+
    // If cell is type MODULE, this is a black-box circuit and
    // pins are expected to be disconnected (so don't remove them).
    if (ThisCell->class == CLASS_MODULE) return 0;
@@ -1693,6 +1731,8 @@ PrematchLists(char *name1, int file1, char *name2, int file2)
 
     if (tc1 == NULL || tc2 == NULL) return 0;
 
+    StatStart(STAT_PREMATCH);
+
     InitializeHashTable(&compdict, OBJHASHSIZE);
     listX0 = list0X = NULL;
 
@@ -2389,16 +2429,16 @@ done:
 	list0X = nextptr;
     }
 
-    // If either netlist was modified, rebuild its node cache
+    // If either netlist was modified, discard its node cache
 
     if (modified1 > 0) {
 	FreeNodeNames(tc1);
-	CacheNodeNames(tc1);
     }
     if (modified2 > 0) {
 	FreeNodeNames(tc2);
-	CacheNodeNames(tc2);
     }
 
+    StatCount(STAT_PREMATCH, (long)(modified1 + modified2));
+    StatStop(STAT_PREMATCH);
     return modified1 + modified2;
 }
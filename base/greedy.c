@@ -45,8 +45,9 @@ static struct nlist *curcell;
 int permutation[MAX_LEAVES+1];
 int TopDownStartLevel;
 
-int leftnodes[MAX_NODES + 1];
-int rightnodes[MAX_NODES + 1];
+/* allocated with Nodes + 1 entries by InitializeMatrices() */
+int *leftnodes = NULL;
+int *rightnodes = NULL;
 
 
 int PartitionFanout(int left, int right, int side)
@@ -55,20 +56,20 @@ int PartitionFanout(int left, int right, int side)
    these represent the integrated node usages for the left and right 
    partitions */
 {
-  int i, E;
+  int i, k, E;
   int ports;
-  int sum;
+  int *sum;
+
+  /* save total node usage in 'leftnodes' and 'rightnodes' */
+  sum = (side == LEFT) ? leftnodes : rightnodes;
+  for (i = 1; i <= Nodes; i++) sum[i] = 0;
+  for (E = left; E <= right; E++)
+    for (k = FIRSTCONN(permutation[E]); k < ENDCONN(permutation[E]); k++)
+      sum[Conn[k].node] += Conn[k].usage;
 
   ports = 0;
-  for (i = 1; i <= Nodes; i++) {
-    sum = 0;
-    for (E = left; E <= right; E++) sum += CSTAR[permutation[E]][i];
-    /* save total node usage in 'leftnodes' and 'rightnodes' */
-    if (side == LEFT) leftnodes[i] = sum;
-    else rightnodes[i] = sum;
-
-    if (sum && (sum < CSTAR[0][i] || C[0][i])) ports ++;
-  }
+  for (i = 1; i <= Nodes; i++)
+    if (sum[i] && (sum[i] < NodeUsage[i] || PortNodes[i])) ports ++;
   return(ports);
 }
 
@@ -90,21 +91,22 @@ void Dbug_print_cells(int left, int right)
 
 int FindOptimum(int left, int right, int *mynodes, int *othernodes)
 {
-  int E, max, choice, i;
+  int E, max, choice, i, k;
   int gain[MAX_LEAVES + 1];
 
   /* find the left optimum */
   for (E = left; E <= right; E++) {
     gain[E] = 0;
-    for (i = 1; i <= Nodes; i++) {
+    for (k = FIRSTCONN(permutation[E]); k < ENDCONN(permutation[E]); k++) {
+      if (!Conn[k].pin) continue;
+      i = Conn[k].node;
 #ifdef BAD
-      if (C[permutation[E]][i] && mynodes[i] == 1) gain[E]++;
+      if (mynodes[i] == 1) gain[E]++;
 #else
-      /* remember: left,rightnodes built up from CSTAR */
-      if (C[permutation[E]][i] && mynodes[i] == CSTAR[permutation[E]][i])
-	      gain[E]++;
+      /* remember: left,rightnodes built up from usage counts */
+      if (mynodes[i] == Conn[k].usage) gain[E]++;
 #endif
-      else if (C[permutation[E]][i] && othernodes[i] == 0) gain[E]--;
+      else if (othernodes[i] == 0) gain[E]--;
     }
   }
   
@@ -129,7 +131,7 @@ int GradientDescent(int left, int right, int partition)
 /* returns 1 if a swap was possible */
 {
   int leftchoice, rightchoice;
-  int tmp;
+  int tmp, k;
 #if 1
   int E, leftmax, rightmax, i;
   int gain[MAX_LEAVES + 1];
@@ -137,14 +139,15 @@ int GradientDescent(int left, int right, int partition)
   /* find the left optimum */
   for (E = left; E <= partition; E++) {
     gain[E] = 0;
-    for (i = 1; i <= Nodes; i++) {
+    for (k = FIRSTCONN(permutation[E]); k < ENDCONN(permutation[E]); k++) {
+      if (!Conn[k].pin) continue;
+      i = Conn[k].node;
 #ifdef BAD
-      if (C[permutation[E]][i] && leftnodes[i] == 1) gain[E]++;
+      if (leftnodes[i] == 1) gain[E]++;
 #else
-      if (C[permutation[E]][i] && leftnodes[i] == CSTAR[permutation[E]][i])
-	      gain[E]++;
+      if (leftnodes[i] == Conn[k].usage) gain[E]++;
 #endif
-      else if (C[permutation[E]][i] && rightnodes[i] == 0) gain[E]--;
+      else if (rightnodes[i] == 0) gain[E]--;
     }
   }
   
@@ -162,14 +165,15 @@ int GradientDescent(int left, int right, int partition)
   /* find the right optimum */
   for (E = partition+1; E <= right; E++) {
     gain[E] = 0;
-    for (i = 1; i <= Nodes; i++) {
+    for (k = FIRSTCONN(permutation[E]); k < ENDCONN(permutation[E]); k++) {
+      if (!Conn[k].pin) continue;
+      i = Conn[k].node;
 #ifdef BAD
-      if (C[permutation[E]][i] && rightnodes[i] == 1) gain[E]++;
+      if (rightnodes[i] == 1) gain[E]++;
 #else
-      if (C[permutation[E]][i] && rightnodes[i] == CSTAR[permutation[E]][i])
-	      gain[E]++;
+      if (rightnodes[i] == Conn[k].usage) gain[E]++;
 #endif
-      else if (C[permutation[E]][i] && leftnodes[i] == 0) gain[E]--;
+      else if (leftnodes[i] == 0) gain[E]--;
     }
   }
   
@@ -202,27 +206,27 @@ int GradientDescent(int left, int right, int partition)
   permutation[leftchoice] = permutation[rightchoice];
   permutation[rightchoice] = tmp;
   /* update node usage lists */
-  for (tmp = 1; tmp <= Nodes; tmp++) {
-    if (C[permutation[leftchoice]][tmp]) {
-      leftnodes[tmp] -= C[permutation[leftchoice]][tmp];
-      rightnodes[tmp] += C[permutation[leftchoice]][tmp];
-    }
-    if (C[permutation[rightchoice]][tmp]) {
-      leftnodes[tmp] += C[permutation[rightchoice]][tmp];
-      rightnodes[tmp] -= C[permutation[rightchoice]][tmp];
-    }
+  for (k = FIRSTCONN(permutation[leftchoice]);
+       k < ENDCONN(permutation[leftchoice]); k++) {
+    leftnodes[Conn[k].node]--;
+    rightnodes[Conn[k].node]++;
+  }
+  for (k = FIRSTCONN(permutation[rightchoice]);
+       k < ENDCONN(permutation[rightchoice]); k++) {
+    leftnodes[Conn[k].node]++;
+    rightnodes[Conn[k].node]--;
   }
 #else
-  /* update node usage lists, remembering that CSTAR goes into leftnodes */
-  for (tmp = 1; tmp <= Nodes; tmp++) {
-    if (CSTAR[permutation[leftchoice]][tmp]) {
-      leftnodes[tmp] -= CSTAR[permutation[leftchoice]][tmp];
-      rightnodes[tmp] += CSTAR[permutation[leftchoice]][tmp];
-    }
-    if (CSTAR[permutation[rightchoice]][tmp]) {
-      leftnodes[tmp] += CSTAR[permutation[rightchoice]][tmp];
-      rightnodes[tmp] -= CSTAR[permutation[rightchoice]][tmp];
-    }
+  /* update node usage lists, remembering that usage goes into leftnodes */
+  for (k = FIRSTCONN(permutation[leftchoice]);
+       k < ENDCONN(permutation[leftchoice]); k++) {
+    leftnodes[Conn[k].node] -= Conn[k].usage;
+    rightnodes[Conn[k].node] += Conn[k].usage;
+  }
+  for (k = FIRSTCONN(permutation[rightchoice]);
+       k < ENDCONN(permutation[rightchoice]); k++) {
+    leftnodes[Conn[k].node] += Conn[k].usage;
+    rightnodes[Conn[k].node] -= Conn[k].usage;
   }
   /* THEN swap the elements */
   tmp = permutation[leftchoice];
@@ -460,6 +464,9 @@ void TopDownEmbedCell(char *cellname, char *filename,
   case anneal:
     Found = AnnealPartition(1, Leaves, TopDownStartLevel);
     break;
+  case multilevel:
+    Found = MultilevelPartition(1, Leaves, TopDownStartLevel);
+    break;
   case bottomup:
     Fprintf(stderr,"ERROR: called TopDownEmbedCell with bottomup strategy\n");
     break;
@@ -18,6 +18,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* hash.c  -- hash table support functions  */
 
+#define MEMTAG MEM_HASH	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -113,25 +114,6 @@ int CountHashTableBinsUsed(struct hashlist *p)
 	return(0);
 }
 
-static unsigned char uppercase[] = {
-	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
-	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
-	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
-	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
-	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
-	0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
-	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
-	0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
-	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
-	0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
-	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,
-	0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
-	0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
-	0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
-	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,
-	0x58, 0x59, 0x5a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f
-};
-
 // Hash functions of the stupid-simple accumulate-the-character-codes
 // method replaced by the more sophisticated SDBM hash.  Otherwise
 // horrible things can happen, as, for example, names AOI12 and OAI12
@@ -140,37 +122,147 @@ static unsigned char uppercase[] = {
 //
 // Updated again 4/2/2026 to the FNV-1a hash, which is better than
 // SDBM for this application, according to ChatGPT.
+//
+// Updated 10/19/2026 to a 64-bit hash that consumes the name eight
+// characters at a time.  FNV-1a needs one multiply per character,
+// and the chain of multiplies dominated netlist read time.  The
+// case-insensitive version folds all eight characters to upper case
+// at once instead of looking each one up in a table.
+
+typedef unsigned long long hashword;
+
+#define HASHONES	0x0101010101010101ull
+#define HASHHIGHS	0x8080808080808080ull
+#define HASHSEED	0x243F6A8885A308D3ull
+#define HASHMULT	0x9E3779B97F4A7C15ull
+#define HASHMIX		0xBF58476D1CE4E5B9ull
+
+/* Gather up to eight characters of s into a word;  return the count */
+
+static int hashgather(unsigned char *s, hashword *w)
+{
+    hashword v = 0;
+    int n;
+
+    for (n = 0; n < 8 && s[n] != '\0'; n++)
+	v |= (hashword)s[n] << (n << 3);
+    *w = v;
+    return n;
+}
+
+/* Convert the ASCII lower-case characters of a word to upper case */
+
+static hashword hashfold(hashword w)
+{
+    hashword low, gea, gtz;
+
+    low = w & ~HASHHIGHS;
+    gea = low + HASHONES * (0x80 - 'a');
+    gtz = low + HASHONES * (0x80 - 'z' - 1);
+    return w - (((gea & ~gtz & ~w) & HASHHIGHS) >> 2);
+}
+
+static unsigned long hashfinish(hashword h, int hashsize)
+{
+    h ^= h >> 29;
+    h *= HASHMIX;
+    h ^= h >> 32;
+    return (hashsize == 0) ? (unsigned long)h :
+		(unsigned long)(h % (hashword)hashsize);
+}
 
 unsigned long hashnocase(char *s, int hashsize)
 {
-	unsigned long hashval = 2166136261ul;
-	for (; *s != '\0'; s++) {
-	    hashval ^= uppercase[*s];
-	    hashval *= 16777619ul;
+	unsigned char *p = (unsigned char *)s;
+	hashword h = HASHSEED, w;
+	int n;
+
+	while ((n = hashgather(p, &w)) > 0) {
+	    h = (h ^ hashfold(w)) * HASHMULT;
+	    h ^= h >> 32;
+	    p += n;
+	    if (n < 8) break;
 	}
-	return (hashsize == 0) ? hashval : (hashval % hashsize);
+	return hashfinish(h ^ (hashword)(p - (unsigned char *)s), hashsize);
 }
 
 unsigned long hashcase(char *s, int hashsize)
 {
-	unsigned long hashval = 2166136261ul;
-	for (; *s != '\0'; s++) {
-	    hashval ^= (unsigned char)(*s);
-	    hashval *= 16777619ul;
+	unsigned char *p = (unsigned char *)s;
+	hashword h = HASHSEED, w;
+	int n;
+
+	while ((n = hashgather(p, &w)) > 0) {
+	    h = (h ^ w) * HASHMULT;
+	    h ^= h >> 32;
+	    p += n;
+	    if (n < 8) break;
 	}
-	return (hashsize == 0) ? hashval : (hashval % hashsize);
+	return hashfinish(h ^ (hashword)(p - (unsigned char *)s), hashsize);
 }
 
 unsigned long genhash(char *s, int c, int hashsize)
 {
-	unsigned long hashval = 2166136261ul;
-	hashval ^= (unsigned long)c;
-	hashval *= 16777619ul;
-	for (; *s != '\0'; s++) {
-	    hashval ^= (unsigned char)(*s);
-	    hashval *= 16777619ul;
+	unsigned char *p = (unsigned char *)s;
+	hashword h, w;
+	int n;
+
+	h = (HASHSEED ^ (hashword)(unsigned int)c) * HASHMULT;
+	while ((n = hashgather(p, &w)) > 0) {
+	    h = (h ^ w) * HASHMULT;
+	    h ^= h >> 32;
+	    p += n;
+	    if (n < 8) break;
 	}
-	return (hashsize == 0) ? hashval : (hashval % hashsize);
+	return hashfinish(h ^ (hashword)(p - (unsigned char *)s), hashsize);
+}
+
+/*----------------------------------------------------------------------*/
+/* Hash and compare names under the current case rule.  The usual	*/
+/* functions are called directly rather than through the pointers,	*/
+/* and entries whose stored hash differs are never compared by name.	*/
+/*----------------------------------------------------------------------*/
+
+static unsigned long hashname(char *s)
+{
+  if (hashfunc == hashcase) return hashcase(s, 0);
+  else if (hashfunc == hashnocase) return hashnocase(s, 0);
+  else return (*hashfunc)(s, 0);
+}
+
+static int matchname(char *s, struct hashlist *np, unsigned long hashval)
+{
+  if (np->hashval != hashval) return 0;
+  else if (matchfunc == match) return !strcmp(s, np->name);
+  else return (*matchfunc)(s, np->name);
+}
+
+static int matchintname(char *s, struct hashlist *np, unsigned long hashval,
+		int i)
+{
+  int value = (np->ptr == NULL) ? -1 : (int)(*((int *)np->ptr));
+
+  if (np->hashval != hashval) return 0;
+  else if (matchintfunc == matchfile)
+    return (i == value) && !strcmp(s, np->name);
+  else return (*matchintfunc)(s, np->name, i, value);
+}
+
+/* Allocate a new entry at the head of bucket "hashval % hashsize" */
+
+static struct hashlist *hashnew(char *name, void *ptr, unsigned long hashval,
+		struct hashdict *dict)
+{
+  struct hashlist *np;
+  unsigned long bucket = hashval % dict->hashsize;
+
+  if ((np = (struct hashlist *) CALLOC(1,sizeof(struct hashlist))) == NULL)
+    return (NULL);
+  if ((np->name = strsave(name)) == NULL) return (NULL);
+  np->ptr = ptr;
+  np->hashval = hashval;
+  np->next = dict->hashtab[bucket];
+  return(dict->hashtab[bucket] = np);
 }
 
 /*----------------------------------------------------------------------*/
@@ -183,10 +275,10 @@ void *HashLookup(char *s, struct hashdict *dict)
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = (*hashfunc)(s, dict->hashsize);
+  hashval = hashname(s);
 	
-  for (np = dict->hashtab[hashval]; np != NULL; np = np->next)
-    if ((*matchfunc)(s, np->name)) return (np->ptr);	/* correct match */
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (matchname(s, np, hashval)) return (np->ptr);	/* correct match */
   return (NULL); /* not found */
 }
 
@@ -202,18 +294,11 @@ void *HashIntLookup(char *s, int i, struct hashdict *dict)
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = (*hashfunc)(s, dict->hashsize);
+  hashval = hashname(s);
 
-  for (np = dict->hashtab[hashval]; np != NULL; np = np->next) {
-    if (np->ptr == NULL) {
-       if ((*matchintfunc)(s, np->name, i, -1))
-	  return NULL;
-    }
-    else {
-       if ((*matchintfunc)(s, np->name, i, (int)(*((int *)np->ptr))))
-	  return (np->ptr);	/* correct match */
-    }
-  }
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (matchintname(s, np, hashval, i))
+      return (np->ptr);	/* correct match (NULL if the entry has no ptr) */
   return (NULL); /* not found */
 }
 
@@ -228,10 +313,10 @@ void *HashInt2Lookup(char *s, int c, struct hashdict *dict)
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = genhash(s, c, dict->hashsize);
+  hashval = genhash(s, c, 0);
 	
-  for (np = dict->hashtab[hashval]; np != NULL; np = np->next)
-    if (!strcmp(s, np->name))
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (np->hashval == hashval && !strcmp(s, np->name))
       return (np->ptr);	/* correct match */
 
   return (NULL); /* not found */
@@ -247,20 +332,15 @@ struct hashlist *HashPtrInstall(char *name, void *ptr, struct hashdict *dict)
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = (*hashfunc)(name, dict->hashsize);
-  for (np =  dict->hashtab[hashval]; np != NULL; np = np->next)
-    if ((*matchfunc)(name, np->name)) {
+  hashval = hashname(name);
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (matchname(name, np, hashval)) {
       np->ptr = ptr;
       return (np);		/* match found in hash table */
     }
 
   /* not in table, so install it */
-  if ((np = (struct hashlist *) CALLOC(1,sizeof(struct hashlist))) == NULL)
-    return (NULL);
-  if ((np->name = strsave(name)) == NULL) return (NULL);
-  np->ptr = ptr;
-  np->next =  dict->hashtab[hashval];
-  return(dict->hashtab[hashval] = np);
+  return hashnew(name, ptr, hashval, dict);
 }
 
 /*----------------------------------------------------------------------*/
@@ -274,20 +354,15 @@ struct hashlist *HashIntPtrInstall(char *name, int value, void *ptr,
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = (*hashfunc)(name, dict->hashsize);
-  for (np =  dict->hashtab[hashval]; np != NULL; np = np->next)
-    if ((*matchintfunc)(name, np->name, value, (int)(*((int *)np->ptr)))) {
+  hashval = hashname(name);
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (matchintname(name, np, hashval, value)) {
       np->ptr = ptr;
       return (np);		/* match found in hash table */
     }
 
   /* not in table, so install it */
-  if ((np = (struct hashlist *) CALLOC(1,sizeof(struct hashlist))) == NULL)
-    return (NULL);
-  if ((np->name = strsave(name)) == NULL) return (NULL);
-  np->ptr = ptr;
-  np->next = dict->hashtab[hashval];
-  return(dict->hashtab[hashval] = np);
+  return hashnew(name, ptr, hashval, dict);
 }
 
 /*----------------------------------------------------------------------*/
@@ -300,20 +375,15 @@ struct hashlist *HashInt2PtrInstall(char *name, int c, void *ptr,
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = genhash(name, c, dict->hashsize);
-  for (np = dict->hashtab[hashval]; np != NULL; np = np->next)
-    if (!strcmp(name, np->name)) {
+  hashval = genhash(name, c, 0);
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (np->hashval == hashval && !strcmp(name, np->name)) {
       np->ptr = ptr;
       return (np);		/* match found in hash table */
     }
 
   /* not in table, so install it */
-  if ((np = (struct hashlist *) CALLOC(1,sizeof(struct hashlist))) == NULL)
-    return (NULL);
-  if ((np->name = strsave(name)) == NULL) return (NULL);
-  np->ptr = ptr;
-  np->next = dict->hashtab[hashval];
-  return(dict->hashtab[hashval] = np);
+  return hashnew(name, ptr, hashval, dict);
 }
 
 /*----------------------------------------------------------------------*/
@@ -349,17 +419,12 @@ struct hashlist *HashInstall(char *name, struct hashdict *dict)
   struct hashlist *np;
   unsigned long hashval;
 	
-  hashval = (*hashfunc)(name, dict->hashsize);
-  for (np = dict->hashtab[hashval]; np != NULL; np = np->next)
-    if ((*matchfunc)(name, np->name)) return (np); /* match found in hash table */
+  hashval = hashname(name);
+  for (np = dict->hashtab[hashval % dict->hashsize]; np != NULL; np = np->next)
+    if (matchname(name, np, hashval)) return (np); /* match found in hash table */
 
   /* not in table, so install it */
-  if ((np = (struct hashlist *) CALLOC(1,sizeof(struct hashlist))) == NULL)
-    return (NULL);
-  if ((np->name = strsave(name)) == NULL) return (NULL);
-  np->ptr = NULL;
-  np->next = dict->hashtab[hashval];
-  return(dict->hashtab[hashval] = np);
+  return hashnew(name, NULL, hashval, dict);
 }
 
 /*----------------------------------------------------------------------*/
@@ -370,30 +435,17 @@ void HashDelete(char *name, struct hashdict *dict)
 {
   unsigned long hashval;
   struct hashlist *np;
-  struct hashlist *np2;
+  struct hashlist **npp;
   
-  hashval = (*hashfunc)(name, dict->hashsize);
-  np = dict->hashtab[hashval];
-  if (np == NULL) return;
-
-  if ((*matchfunc)(name, np->name)) {
-    /* it is the first element in the list */
-    dict->hashtab[hashval] = np->next;
-    FREE(np->name);
-    FREE(np);
-    return;
-  }
-
-  /* else, traverse the list, deleting the appropriate element */
-  while (np->next != NULL) {
-    if ((*matchfunc)(name, np->next->name)) {
-      np2 = np->next;
-      np->next = np2->next;
-      FREE(np2->name);
-      FREE(np2);
+  hashval = hashname(name);
+  for (npp = &dict->hashtab[hashval % dict->hashsize]; (np = *npp) != NULL;
+		npp = &np->next) {
+    if (matchname(name, np, hashval)) {
+      *npp = np->next;
+      FREE(np->name);
+      FREE(np);
       return;
     }
-    np = np->next;
   }
 }
 
@@ -405,31 +457,17 @@ void HashIntDelete(char *name, int value, struct hashdict *dict)
 {
   unsigned long hashval;
   struct hashlist *np;
-  struct hashlist *np2;
+  struct hashlist **npp;
   
-  hashval = (*hashfunc)(name, dict->hashsize);
-  np = dict->hashtab[hashval];
-  if (np == NULL) return;
-
-  if ((*matchintfunc)(name, np->name, value, (int)(*((int *)np->ptr)))) {
-    /* it is the first element in the list */
-    dict->hashtab[hashval] = np->next;
-    FREE(np->name);
-    FREE(np);
-    return;
-  }
-
-  /* else, traverse the list, deleting the appropriate element */
-  while (np->next != NULL) {
-    if ((*matchintfunc)(name, np->next->name, value,
-		(int)(*((int *)np->next->ptr)))) {
-      np2 = np->next;
-      np->next = np2->next;
-      FREE(np2->name);
-      FREE(np2);
+  hashval = hashname(name);
+  for (npp = &dict->hashtab[hashval % dict->hashsize]; (np = *npp) != NULL;
+		npp = &np->next) {
+    if (matchintname(name, np, hashval, value)) {
+      *npp = np->next;
+      FREE(np->name);
+      FREE(np);
       return;
     }
-    np = np->next;
   }
 }
 
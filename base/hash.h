@@ -4,6 +4,7 @@
 struct hashlist {
   char *name;
   void *ptr;
+  unsigned long hashval;	/* full hash of name, compared before name */
   struct hashlist *next;
 };
 
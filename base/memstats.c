@@ -0,0 +1,351 @@
+/* "NETGEN", a netlist-specification tool for VLSI
+   Copyright (C) 1989, 1990   Massimo A. Sivilotti
+   Author's address: mass@csvax.cs.caltech.edu;
+                     Caltech 256-80, Pasadena CA 91125.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation (any version).
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file copying.  If not, write to
+the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+/* memstats.c -- accounting of allocated memory
+ *
+ * In builds configured with --enable-memstats (MEMSTATS defined), every
+ * block allocated through MALLOC(), CALLOC() and STRDUP() carries a small
+ * header recording its size, category and file number, so that FREE()
+ * can subtract it from the right totals.  The category is chosen at the
+ * allocation site (see MEMTAG in config.h).  The file number is that
+ * given to MemSetFile(), or else that of the current cell;  blocks
+ * belonging to the comparison graph are not attributed to any file.
+ *
+ * Otherwise the allocation functions call the allocator directly, blocks
+ * are laid out as the allocator returns them, and no totals are kept.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef TCL_NETGEN
+#include <tcl.h>
+#endif
+
+#include "netgen.h"
+#include "objlist.h"
+#include "print.h"
+#include "memstats.h"
+
+#ifdef TCL_NETGEN
+#define RAWALLOC(s)	((void *)Tcl_Alloc(s))
+#define RAWFREE(a)	Tcl_Free((char *)(a))
+#else
+#define RAWALLOC(s)	malloc(s)
+#define RAWFREE(a)	free(a)
+#endif
+
+struct memstat MemClassStats[MEM_NUMCLASSES];
+
+char *MemClassNames[MEM_NUMCLASSES] = {
+   "other", "cells", "hash", "strings", "properties", "compare", "parser"
+};
+
+size_t MemInUse = 0;
+size_t MemPeak = 0;
+size_t MemPhasePeak = 0;
+
+#ifdef MEMSTATS
+
+struct memhdr {
+   size_t size;
+   short tag;
+   int file;
+};
+
+/* Header size rounded up to keep the returned block aligned */
+#define MEMHDRSIZE ((sizeof(struct memhdr) + 15) & ~(size_t)15)
+
+/* Per-file statistics, indexed by file number + 1 (entry 0 holds	*/
+/* blocks not belonging to any file).  Allocated with the raw		*/
+/* allocator, so it is not itself counted.				*/
+
+#define MEM_MAXFILES	4096
+
+static struct memstat *MemFiles = NULL;
+static int MemFilesAlloc = 0;
+static int MemFile = -1;
+
+/* While other threads may allocate (see MemSetThreaded()), the	*/
+/* allocator and the totals are protected by a lock.		*/
+
+static int MemThreaded = 0;
+static pthread_mutex_t MemLock = PTHREAD_MUTEX_INITIALIZER;
+
+#define MEMLOCK()	if (MemThreaded) pthread_mutex_lock(&MemLock)
+#define MEMUNLOCK()	if (MemThreaded) pthread_mutex_unlock(&MemLock)
+
+/*--------------------------------------------------------------*/
+/* Set the file number to which new blocks are attributed,	*/
+/* overriding that of the current cell.  A value of -1 restores	*/
+/* the default.  Returns the previous setting.			*/
+/*--------------------------------------------------------------*/
+
+int MemSetFile(int file)
+{
+   int oldfile = MemFile;
+
+   MemFile = file;
+   return oldfile;
+}
+
+/*--------------------------------------------------------------*/
+/* Declare whether threads other than the main one may allocate	*/
+/* memory.  Must be called by the main thread while no other	*/
+/* thread is running.						*/
+/*--------------------------------------------------------------*/
+
+void MemSetThreaded(int threaded)
+{
+   MemThreaded = threaded;
+}
+
+/*--------------------------------------------------------------*/
+/* Return the statistics entry for a file number, growing the	*/
+/* table as needed.  Returns NULL only if the table cannot grow.	*/
+/*--------------------------------------------------------------*/
+
+struct memstat *MemFileStats(int file)
+{
+   int idx, newalloc;
+   struct memstat *newfiles;
+
+   idx = (file < 0 || file >= MEM_MAXFILES) ? 0 : file + 1;
+   if (idx >= MemFilesAlloc) {
+      newalloc = (MemFilesAlloc == 0) ? 16 : MemFilesAlloc;
+      while (newalloc <= idx) newalloc *= 2;
+      newfiles = (struct memstat *)realloc(MemFiles,
+		newalloc * sizeof(struct memstat));
+      if (newfiles == NULL) return NULL;
+      memset(newfiles + MemFilesAlloc, 0,
+		(newalloc - MemFilesAlloc) * sizeof(struct memstat));
+      MemFiles = newfiles;
+      MemFilesAlloc = newalloc;
+   }
+   return MemFiles + idx;
+}
+
+/* Return one more than the highest file number with any blocks */
+
+int MemMaxFile(void)
+{
+   return (MemFilesAlloc > 0) ? MemFilesAlloc - 1 : 0;
+}
+
+static void MemAdd(struct memstat *ms, size_t size)
+{
+   ms->current += size;
+   ms->blocks++;
+   if (ms->current > ms->peak) ms->peak = ms->current;
+}
+
+static void MemSub(struct memstat *ms, size_t size)
+{
+   ms->current -= size;
+   ms->blocks--;
+}
+
+/*--------------------------------------------------------------*/
+/* Allocation functions called by the macros in config.h	*/
+/*--------------------------------------------------------------*/
+
+void *MemAlloc(size_t size, int tag)
+{
+   struct memhdr *mh;
+   struct memstat *ms;
+
+   MEMLOCK();
+   mh = (struct memhdr *)RAWALLOC(size + MEMHDRSIZE);
+   if (mh == NULL) {
+      MEMUNLOCK();
+      return NULL;
+   }
+
+   mh->size = size;
+   mh->tag = tag;
+   if (tag == MEM_COMPARE)
+      mh->file = -1;
+   else if (MemFile >= 0)
+      mh->file = MemFile;
+   else
+      mh->file = (CurrentCell != NULL) ? CurrentCell->file : -1;
+
+   MemAdd(&MemClassStats[tag], size);
+   if ((ms = MemFileStats(mh->file)) != NULL) MemAdd(ms, size);
+
+   MemInUse += size;
+   if (MemInUse > MemPeak) MemPeak = MemInUse;
+   if (MemInUse > MemPhasePeak) MemPhasePeak = MemInUse;
+   MEMUNLOCK();
+
+   return (void *)((char *)mh + MEMHDRSIZE);
+}
+
+void *MemCalloc(size_t nmemb, size_t size, int tag)
+{
+   void *ptr;
+
+   ptr = MemAlloc(nmemb * size, tag);
+   if (ptr != NULL) memset(ptr, 0, nmemb * size);
+   return ptr;
+}
+
+char *MemStrdup(const char *s)
+{
+   char *snew;
+   size_t slen;
+
+   slen = strlen(s) + 1;
+   snew = (char *)MemAlloc(slen, MEM_STRING);
+   if (snew != NULL) memcpy(snew, s, slen);
+   return snew;
+}
+
+void MemFree(void *ptr)
+{
+   struct memhdr *mh;
+   struct memstat *ms;
+
+   if (ptr == NULL) return;
+   mh = (struct memhdr *)((char *)ptr - MEMHDRSIZE);
+
+   MEMLOCK();
+   MemSub(&MemClassStats[mh->tag], mh->size);
+   if ((ms = MemFileStats(mh->file)) != NULL) MemSub(ms, mh->size);
+   MemInUse -= mh->size;
+
+   RAWFREE(mh);
+   MEMUNLOCK();
+}
+
+/*--------------------------------------------------------------*/
+/* Reset all high-water marks to the current usage		*/
+/*--------------------------------------------------------------*/
+
+void MemResetPeaks(void)
+{
+   int i;
+
+   for (i = 0; i < MEM_NUMCLASSES; i++)
+      MemClassStats[i].peak = MemClassStats[i].current;
+   for (i = 0; i < MemFilesAlloc; i++)
+      MemFiles[i].peak = MemFiles[i].current;
+   MemPeak = MemPhasePeak = MemInUse;
+}
+
+/*--------------------------------------------------------------*/
+/* Print current and peak usage by category and by file	*/
+/*--------------------------------------------------------------*/
+
+#define MBYTES(b)	((double)(b) / 1048576.0)
+
+void PrintMemoryStats(void)
+{
+   int i;
+   struct memstat *ms;
+
+   Printf("%-16s %12s %12s %12s\n", "Category", "Blocks", "Current (MB)",
+		"Peak (MB)");
+   for (i = 0; i < MEM_NUMCLASSES; i++) {
+      ms = &MemClassStats[i];
+      Printf("%-16s %12ld %12.3f %12.3f\n", MemClassNames[i], ms->blocks,
+		MBYTES(ms->current), MBYTES(ms->peak));
+   }
+   Printf("%-16s %12s %12.3f %12.3f\n", "total", "", MBYTES(MemInUse),
+		MBYTES(MemPeak));
+
+   Printf("\n%-16s %12s %12s %12s\n", "File", "Blocks", "Current (MB)",
+		"Peak (MB)");
+   for (i = 0; i < MemFilesAlloc; i++) {
+      ms = &MemFiles[i];
+      if (ms->peak == 0) continue;
+      if (i == 0)
+         Printf("%-16s", "(none)");
+      else
+         Printf("%-16d", i - 1);
+      Printf(" %12ld %12.3f %12.3f\n", ms->blocks, MBYTES(ms->current),
+		MBYTES(ms->peak));
+   }
+}
+
+#else /* !MEMSTATS */
+
+int MemSetFile(int file)
+{
+   return -1;
+}
+
+void MemSetThreaded(int threaded)
+{
+}
+
+struct memstat *MemFileStats(int file)
+{
+   return NULL;
+}
+
+int MemMaxFile(void)
+{
+   return 0;
+}
+
+void *MemAlloc(size_t size, int tag)
+{
+   return RAWALLOC(size);
+}
+
+void *MemCalloc(size_t nmemb, size_t size, int tag)
+{
+   void *ptr;
+
+   ptr = RAWALLOC(nmemb * size);
+   if (ptr != NULL) memset(ptr, 0, nmemb * size);
+   return ptr;
+}
+
+char *MemStrdup(const char *s)
+{
+   char *snew;
+   size_t slen;
+
+   slen = strlen(s) + 1;
+   snew = (char *)RAWALLOC(slen);
+   if (snew != NULL) memcpy(snew, s, slen);
+   return snew;
+}
+
+void MemFree(void *ptr)
+{
+   if (ptr != NULL) RAWFREE(ptr);
+}
+
+void MemResetPeaks(void)
+{
+}
+
+void PrintMemoryStats(void)
+{
+   Printf("Memory accounting is not available "
+		"(configure with --enable-memstats).\n");
+}
+
+#endif /* !MEMSTATS */
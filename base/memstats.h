@@ -0,0 +1,28 @@
+/* memstats.h -- accounting of memory allocated through MALLOC() et al. */
+
+#ifndef _MEMSTATS_H
+#define _MEMSTATS_H
+
+/* Bytes currently allocated and the high-water mark for one	*/
+/* allocation category (MEM_* in config.h) or one file number.	*/
+
+struct memstat {
+   size_t current;
+   size_t peak;
+   long blocks;		/* number of blocks currently allocated */
+};
+
+extern struct memstat MemClassStats[MEM_NUMCLASSES];
+extern char *MemClassNames[MEM_NUMCLASSES];
+
+extern size_t MemInUse;		/* total bytes currently allocated */
+extern size_t MemPeak;		/* high-water mark of MemInUse */
+extern size_t MemPhasePeak;	/* high-water mark since the last phase mark */
+
+extern int MemSetFile(int file);
+extern struct memstat *MemFileStats(int file);
+extern int MemMaxFile(void);
+extern void MemResetPeaks(void);
+extern void MemSetThreaded(int threaded);
+
+#endif /* _MEMSTATS_H */
@@ -0,0 +1,596 @@
+/* "NETGEN", a netlist-specification tool for VLSI
+   Copyright (C) 1989, 1990   Massimo A. Sivilotti
+   Author's address: mass@csvax.cs.caltech.edu;
+                     Caltech 256-80, Pasadena CA 91125.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation (any version).
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file copying.  If not, write to
+the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+/* multilevel.c -- multilevel graph partitioning for PROTOCHIP */
+
+/* Each bisection coarsens the leaves of the range by heavy-edge	*/
+/* matching (pairing leaves that share the most nodes), partitions	*/
+/* the coarsest graph exhaustively, then projects the partition back	*/
+/* level by level, improving it with Fiduccia-Mattheyses moves.  The	*/
+/* cost of a partition is the fanout of its two halves, with fanout	*/
+/* above TreeFanout[level] weighted heavily, and each half must fit	*/
+/* in the leaf slots of a subtree one level down.			*/
+
+#include <stdio.h>
+
+#include "config.h"
+#include "hash.h"
+#include "objlist.h"
+#include "embed.h"
+#include "print.h"
+#include "dbug.h"
+
+/* stop coarsening at this many vertices; the coarsest graph is	*/
+/* partitioned exhaustively, so this must stay small		*/
+#define ML_COARSEST 10
+
+/* the larger half may hold this percentage of the leaf slots, but	*/
+/* never more than the subtree an even split would need, so that an	*/
+/* uneven split does not make the embedding deeper			*/
+#define ML_BALANCE 55
+
+/* refinement passes at each level */
+#define ML_PASSES 4
+
+/* nodes on more vertices than this are ignored when matching */
+#define ML_MAXDEGREE 64
+
+/* weight of one pin of fanout over TreeFanout[level] */
+#define ML_OVERFANOUT 1000
+
+/* One level of the hierarchy.  Vertices are clusters of leaves, and	*/
+/* nodes are numbered locally to the range being partitioned.		*/
+struct mlgraph {
+  int nv;		/* number of vertices */
+  int *weight;		/* leaf slots, POW2(LEVEL), of each vertex */
+  int *start;		/* row of v is entries start[v] to start[v + 1] - 1 */
+  int *node;		/* local node of each entry */
+  int *usage;		/* leaf pins of the vertex on the node */
+  int *adjstart;	/* vertices on node n are adj[adjstart[n]] ... */
+  int *adj;
+  int *map;		/* vertex of the next coarser graph */
+  int *side;		/* 0 = left, 1 = right */
+  struct mlgraph *coarser;
+  struct mlgraph *finer;
+};
+
+static int MLNodes;	/* number of local nodes */
+static int *MLTotal;	/* total usage of each local node (NodeUsage) */
+static char *MLPort;	/* local node is a port of the cell (PortNodes) */
+static int MLFanout;	/* TreeFanout of the level being partitioned */
+
+/* 1 if 'usage' pins on local node n make it a pin of a partition */
+#define SidePin(usage, n) \
+	((usage) > 0 && ((usage) < MLTotal[n] || MLPort[n]))
+
+static long MLCost(int f0, int f1)
+{
+  return((long)(MAX(f0 - MLFanout, 0) + MAX(f1 - MLFanout, 0))
+	 * ML_OVERFANOUT + f0 + f1);
+}
+
+static void MLFreeGraph(struct mlgraph *g)
+{
+  if (g == NULL) return;
+  if (g->weight != NULL) FREE(g->weight);
+  if (g->start != NULL) FREE(g->start);
+  if (g->node != NULL) FREE(g->node);
+  if (g->usage != NULL) FREE(g->usage);
+  if (g->adjstart != NULL) FREE(g->adjstart);
+  if (g->adj != NULL) FREE(g->adj);
+  if (g->map != NULL) FREE(g->map);
+  if (g->side != NULL) FREE(g->side);
+  FREE(g);
+}
+
+static struct mlgraph *MLNewGraph(int nv, int entries)
+/* returns an empty graph, or NULL if out of memory */
+{
+  struct mlgraph *g;
+
+  g = (struct mlgraph *)CALLOC(1, sizeof(struct mlgraph));
+  if (g == NULL) return(NULL);
+  g->nv = nv;
+  g->weight = (int *)CALLOC(nv, sizeof(int));
+  g->start = (int *)CALLOC(nv + 1, sizeof(int));
+  g->node = (int *)CALLOC(entries + 1, sizeof(int));
+  g->usage = (int *)CALLOC(entries + 1, sizeof(int));
+  g->adjstart = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  g->adj = (int *)CALLOC(entries + 1, sizeof(int));
+  g->map = (int *)CALLOC(nv, sizeof(int));
+  g->side = (int *)CALLOC(nv, sizeof(int));
+  if (g->weight == NULL || g->start == NULL || g->node == NULL ||
+	g->usage == NULL || g->adjstart == NULL || g->adj == NULL ||
+	g->map == NULL || g->side == NULL) {
+    MLFreeGraph(g);
+    return(NULL);
+  }
+  return(g);
+}
+
+static void MLBuildAdj(struct mlgraph *g)
+/* fill in the vertex lists of each node from the vertex rows */
+{
+  int v, k, n;
+
+  for (n = 0; n <= MLNodes; n++) g->adjstart[n] = 0;
+  for (k = 0; k < g->start[g->nv]; k++) g->adjstart[g->node[k] + 1]++;
+  for (n = 0; n < MLNodes; n++) g->adjstart[n + 1] += g->adjstart[n];
+  for (v = 0; v < g->nv; v++)
+    for (k = g->start[v]; k < g->start[v + 1]; k++)
+      g->adj[g->adjstart[g->node[k]]++] = v;
+  for (n = MLNodes; n > 0; n--) g->adjstart[n] = g->adjstart[n - 1];
+  g->adjstart[0] = 0;
+}
+
+static struct mlgraph *MLCoarsen(struct mlgraph *g, int maxweight)
+/* match each vertex with the unmatched neighbor sharing the most nodes,
+   and return the graph of matched pairs; returns NULL if out of memory
+   or if the graph would not get much smaller */
+{
+  struct mlgraph *c;
+  int *order, *score, *touched, *first, *second, *acc, *accnodes;
+  int i, j, k, a, v, u, n, nc, nt, best, entries, naccnodes;
+
+  order = (int *)CALLOC(g->nv, sizeof(int));
+  score = (int *)CALLOC(g->nv, sizeof(int));
+  touched = (int *)CALLOC(g->nv, sizeof(int));
+  first = (int *)CALLOC(g->nv, sizeof(int));
+  second = (int *)CALLOC(g->nv, sizeof(int));
+  acc = (int *)CALLOC(MLNodes, sizeof(int));
+  accnodes = (int *)CALLOC(MLNodes, sizeof(int));
+  c = NULL;
+  if (order == NULL || score == NULL || touched == NULL || first == NULL
+	|| second == NULL || acc == NULL || accnodes == NULL) goto done;
+
+  /* visit the vertices in random order */
+  for (v = 0; v < g->nv; v++) {
+    order[v] = v;
+    g->map[v] = -1;
+  }
+  for (i = g->nv - 1; i > 0; i--) {
+    j = Random(i + 1);
+    v = order[i]; order[i] = order[j]; order[j] = v;
+  }
+
+  nc = 0;
+  for (i = 0; i < g->nv; i++) {
+    v = order[i];
+    if (g->map[v] != -1) continue;
+
+    /* score the unmatched neighbors by the number of shared nodes */
+    nt = 0;
+    for (k = g->start[v]; k < g->start[v + 1]; k++) {
+      n = g->node[k];
+      /* global nodes and large nets connect everything */
+      if (MLPort[n]) continue;
+      if (g->adjstart[n + 1] - g->adjstart[n] > ML_MAXDEGREE) continue;
+      for (a = g->adjstart[n]; a < g->adjstart[n + 1]; a++) {
+	u = g->adj[a];
+	if (u == v || g->map[u] != -1) continue;
+	if (g->weight[u] + g->weight[v] > maxweight) continue;
+	if (score[u] == 0) touched[nt++] = u;
+	score[u]++;
+      }
+    }
+    best = -1;
+    for (j = 0; j < nt; j++) {
+      if (best == -1 || score[touched[j]] > score[best]) best = touched[j];
+      score[touched[j]] = 0;
+    }
+
+    first[nc] = v;
+    second[nc] = best;
+    g->map[v] = nc;
+    if (best != -1) g->map[best] = nc;
+    nc++;
+  }
+  if (nc > g->nv * 9 / 10) goto done;
+
+  /* build the coarse graph:  rows are merged, usages summed */
+  entries = g->start[g->nv];
+  c = MLNewGraph(nc, entries);
+  if (c == NULL) goto done;
+  entries = 0;
+  for (v = 0; v < nc; v++) {
+    c->start[v] = entries;
+    naccnodes = 0;
+    for (j = 0; j < 2; j++) {
+      u = (j == 0) ? first[v] : second[v];
+      if (u == -1) continue;
+      c->weight[v] += g->weight[u];
+      for (k = g->start[u]; k < g->start[u + 1]; k++) {
+	n = g->node[k];
+	if (acc[n] == 0) accnodes[naccnodes++] = n;
+	acc[n] += g->usage[k];
+      }
+    }
+    for (j = 0; j < naccnodes; j++) {
+      n = accnodes[j];
+      c->node[entries] = n;
+      c->usage[entries] = acc[n];
+      entries++;
+      acc[n] = 0;
+    }
+  }
+  c->start[nc] = entries;
+  MLBuildAdj(c);
+
+ done:
+  if (order != NULL) FREE(order);
+  if (score != NULL) FREE(score);
+  if (touched != NULL) FREE(touched);
+  if (first != NULL) FREE(first);
+  if (second != NULL) FREE(second);
+  if (acc != NULL) FREE(acc);
+  if (accnodes != NULL) FREE(accnodes);
+  return(c);
+}
+
+static void MLCount(struct mlgraph *g, int *count[2], int f[2], int w[2])
+/* compute the node usage, fanout and leaf slots of each side of g */
+{
+  int v, k, n, s;
+
+  for (n = 0; n < MLNodes; n++) count[0][n] = count[1][n] = 0;
+  w[0] = w[1] = 0;
+  for (v = 0; v < g->nv; v++) {
+    s = g->side[v];
+    w[s] += g->weight[v];
+    for (k = g->start[v]; k < g->start[v + 1]; k++)
+      count[s][g->node[k]] += g->usage[k];
+  }
+  f[0] = f[1] = 0;
+  for (n = 0; n < MLNodes; n++) {
+    f[0] += SidePin(count[0][n], n);
+    f[1] += SidePin(count[1][n], n);
+  }
+}
+
+static void MLMoveDelta(struct mlgraph *g, int v, int *count[2], int d[2])
+/* change in the fanout of each side if v changed sides */
+{
+  int k, n, u, s, t;
+
+  s = g->side[v];
+  t = 1 - s;
+  d[0] = d[1] = 0;
+  for (k = g->start[v]; k < g->start[v + 1]; k++) {
+    n = g->node[k];
+    u = g->usage[k];
+    d[s] += SidePin(count[s][n] - u, n) - SidePin(count[s][n], n);
+    d[t] += SidePin(count[t][n] + u, n) - SidePin(count[t][n], n);
+  }
+}
+
+static void MLMove(struct mlgraph *g, int v, int *count[2], int w[2])
+{
+  int k, s, t;
+
+  s = g->side[v];
+  t = 1 - s;
+  for (k = g->start[v]; k < g->start[v + 1]; k++) {
+    count[s][g->node[k]] -= g->usage[k];
+    count[t][g->node[k]] += g->usage[k];
+  }
+  w[s] -= g->weight[v];
+  w[t] += g->weight[v];
+  g->side[v] = t;
+}
+
+static int MLRefine(struct mlgraph *g, int limit)
+/* Fiduccia-Mattheyses passes:  move each vertex once, always making	*/
+/* the best move that keeps both sides within 'limit' leaf slots, then	*/
+/* keep the best prefix of the moves.  Since a range has at most	*/
+/* MAX_LEAVES leaves, gains are recomputed rather than bucketed.	*/
+/* Returns 0 if out of memory.						*/
+{
+  int *count[2], f[2], w[2], d[2];
+  int *moves;
+  char *locked;
+  int pass, nmoves, bestmoves, v, bestv, bestd[2], ok;
+  long cost, bestcost, c, bestc;
+
+  count[0] = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  count[1] = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  moves = (int *)CALLOC(g->nv, sizeof(int));
+  locked = (char *)CALLOC(g->nv, sizeof(char));
+  ok = (count[0] != NULL && count[1] != NULL && moves != NULL
+	&& locked != NULL);
+
+  for (pass = 0; ok && pass < ML_PASSES; pass++) {
+    MLCount(g, count, f, w);
+    cost = bestcost = MLCost(f[0], f[1]);
+    for (v = 0; v < g->nv; v++) locked[v] = 0;
+    nmoves = bestmoves = 0;
+
+    while (nmoves < g->nv) {
+      bestv = -1;
+      bestc = 0;
+      for (v = 0; v < g->nv; v++) {
+	if (locked[v]) continue;
+	/* keep both sides within the limit and non-empty */
+	if (w[1 - g->side[v]] + g->weight[v] > limit) continue;
+	if (w[g->side[v]] - g->weight[v] <= 0) continue;
+	MLMoveDelta(g, v, count, d);
+	c = MLCost(f[0] + d[0], f[1] + d[1]);
+	if (bestv == -1 || c < bestc) {
+	  bestv = v;
+	  bestc = c;
+	  bestd[0] = d[0];
+	  bestd[1] = d[1];
+	}
+      }
+      if (bestv == -1) break;
+
+      MLMove(g, bestv, count, w);
+      f[0] += bestd[0];
+      f[1] += bestd[1];
+      cost = bestc;
+      locked[bestv] = 1;
+      moves[nmoves++] = bestv;
+      if (cost < bestcost) {
+	bestcost = cost;
+	bestmoves = nmoves;
+      }
+    }
+
+    /* undo the moves after the best point */
+    while (nmoves > bestmoves) MLMove(g, moves[--nmoves], count, w);
+    if (bestmoves == 0) break;
+  }
+
+  if (count[0] != NULL) FREE(count[0]);
+  if (count[1] != NULL) FREE(count[1]);
+  if (moves != NULL) FREE(moves);
+  if (locked != NULL) FREE(locked);
+  return(ok);
+}
+
+static int MLInitialPartition(struct mlgraph *g, int limit)
+/* partition the coarsest graph; returns 0 if no partition fits */
+{
+  int *count[2], f[2], w[2];
+  int v, total, found;
+  unsigned long mask, bestmask;
+  long c, bestc;
+
+  if (g->nv < 2) return(0);
+
+  if (g->nv > ML_COARSEST + 8) {
+    /* coarsening stalled:  fill the left side in order, then refine */
+    total = 0;
+    for (v = 0; v < g->nv; v++) total += g->weight[v];
+    w[0] = 0;
+    for (v = 0; v < g->nv; v++) {
+      g->side[v] = (w[0] < total / 2) ? 0 : 1;
+      if (g->side[v] == 0) w[0] += g->weight[v];
+    }
+    if (w[0] > limit || total - w[0] > limit) return(0);
+    return(1);
+  }
+
+  count[0] = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  count[1] = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  found = 0;
+  bestmask = 0;
+  bestc = 0;
+  if (count[0] != NULL && count[1] != NULL) {
+    /* vertex 0 stays on the left, so each partition is tried once */
+    for (mask = 2; mask < (1UL << g->nv); mask += 2) {
+      for (v = 0; v < g->nv; v++) g->side[v] = (mask >> v) & 1;
+      MLCount(g, count, f, w);
+      if (w[0] > limit || w[1] > limit) continue;
+      c = MLCost(f[0], f[1]);
+      if (!found || c < bestc) {
+	found = 1;
+	bestc = c;
+	bestmask = mask;
+      }
+    }
+  }
+  for (v = 0; v < g->nv; v++) g->side[v] = (bestmask >> v) & 1;
+
+  if (count[0] != NULL) FREE(count[0]);
+  if (count[1] != NULL) FREE(count[1]);
+  return(found);
+}
+
+static int MultilevelBisect(int left, int right, int level)
+/* reorder permutation[left..right] into two halves; returns the last
+   index of the left half, or 0 if no partition fits in level - 1 */
+{
+  struct mlgraph *g, *fine;
+  int *local;
+  int i, k, n, v, e, entries, total, cap, half, fit, limit, partition;
+
+  if (level <= 0) return(0);
+  cap = POW2(level - 1);
+  MLFanout = TreeFanout[level];
+  partition = 0;
+  g = NULL;
+  MLTotal = NULL;
+  MLPort = NULL;
+
+  /* number the nodes of the range locally */
+  local = (int *)CALLOC(Nodes + 1, sizeof(int));
+  if (local == NULL) return(0);
+  MLNodes = 0;
+  entries = 0;
+  total = 0;
+  for (i = left; i <= right; i++) {
+    e = permutation[i];
+    total += POW2(LEVEL(e));
+    for (k = FIRSTCONN(e); k < ENDCONN(e); k++) {
+      if (local[Conn[k].node] == 0) local[Conn[k].node] = ++MLNodes;
+      entries++;
+    }
+  }
+  if (total > 2 * cap) goto done;
+  half = total - total / 2;
+  for (fit = 1; fit < half; fit <<= 1);
+  limit = (total * ML_BALANCE + 99) / 100;
+  if (limit > fit) limit = fit;
+  if (limit < half) limit = half;
+  if (limit > cap) limit = cap;
+
+  MLTotal = (int *)CALLOC(MLNodes + 1, sizeof(int));
+  MLPort = (char *)CALLOC(MLNodes + 1, sizeof(char));
+  fine = MLNewGraph(right - left + 1, entries);
+  if (MLTotal == NULL || MLPort == NULL || fine == NULL) {
+    MLFreeGraph(fine);
+    goto done;
+  }
+  for (n = 1; n <= Nodes; n++) {
+    if (local[n] == 0) continue;
+    MLTotal[local[n] - 1] = NodeUsage[n];
+    MLPort[local[n] - 1] = PortNodes[n];
+  }
+
+  /* the finest graph has one vertex per leaf */
+  entries = 0;
+  for (v = 0; v < fine->nv; v++) {
+    e = permutation[left + v];
+    fine->weight[v] = POW2(LEVEL(e));
+    fine->start[v] = entries;
+    for (k = FIRSTCONN(e); k < ENDCONN(e); k++) {
+      fine->node[entries] = local[Conn[k].node] - 1;
+      fine->usage[entries] = Conn[k].usage;
+      entries++;
+    }
+  }
+  fine->start[fine->nv] = entries;
+  MLBuildAdj(fine);
+
+  /* coarsen; pairs may use at most half of a side */
+  g = fine;
+  while (g->nv > ML_COARSEST) {
+    struct mlgraph *c;
+
+    c = MLCoarsen(g, MAX(limit / 2, 1));
+    if (c == NULL) break;
+    g->coarser = c;
+    c->finer = g;
+    g = c;
+  }
+
+  /* partition the coarsest graph, then refine on the way back down */
+  if (!MLInitialPartition(g, limit) && !MLInitialPartition(g, cap)) {
+    g = fine;
+    goto done;
+  }
+  if (!MLRefine(g, limit)) goto done;
+  while (g->finer != NULL) {
+    fine = g->finer;
+    for (v = 0; v < fine->nv; v++) fine->side[v] = g->side[fine->map[v]];
+    g = fine;
+    if (!MLRefine(g, limit)) goto done;
+  }
+
+  /* left half first, keeping the order of the leaves otherwise */
+  for (v = 0; v < g->nv; v++) local[v] = permutation[left + v];
+  partition = left;
+  for (v = 0; v < g->nv; v++)
+    if (g->side[v] == 0) permutation[partition++] = local[v];
+  k = partition;
+  for (v = 0; v < g->nv; v++)
+    if (g->side[v] == 1) permutation[k++] = local[v];
+  partition--;
+
+ done:
+  /* g is the finest graph here; free the whole chain */
+  while (g != NULL && g->finer != NULL) g = g->finer;
+  while (g != NULL) {
+    fine = g->coarser;
+    MLFreeGraph(g);
+    g = fine;
+  }
+  if (MLTotal != NULL) FREE(MLTotal);
+  if (MLPort != NULL) FREE(MLPort);
+  FREE(local);
+  return(partition);
+}
+
+
+int MultilevelPartition(int left, int right, int level)
+/* return index of new element, if successful partition has been found */
+{
+  int partition;
+  int iterations;
+  int found;
+  int OriginalNewN;
+  int leftelement, rightelement;
+
+#define MAX_PARTITION_ITERATIONS 10
+
+  DBUG_ENTER("MultilevelPartition");
+  OriginalNewN = NewN;
+  if (level < LEVEL(permutation[left])) {
+    Fprintf(stdout,"Failed at level %d; subtree too deep\n",level);
+    DBUG_RETURN(0);
+  }
+
+  if (left == right) DBUG_RETURN(permutation[left]);
+
+  /* each try uses different random matchings while coarsening */
+  iterations = 0;
+  do {
+    int i;
+    int leftfanout, rightfanout;
+
+    iterations++;
+    partition = MultilevelBisect(left, right, level);
+    if (partition == 0) {
+      Fprintf(stdout,"Failed embedding at level %d; no partition fits\n",
+	      level);
+      goto fail;
+    }
+
+    found = 0;
+    leftfanout = PartitionFanout(left,partition,LEFT);
+    rightfanout = PartitionFanout(partition+1, right, RIGHT);
+    if (leftfanout <= TreeFanout[level] && rightfanout <= TreeFanout[level])
+	    found = 1;
+
+    if (!found || level > TopDownStartLevel - 2) {
+      for (i = MAX_TREE_DEPTH; i > level; i--) Fprintf(stdout, "   ");
+      Fprintf(stdout,
+    "Level: %d; L (%d leaves) fanout %d; R (%d leaves) fanout %d (<= %d) %s\n",
+	      level, (partition - left + 1), leftfanout,
+	      (right - partition), rightfanout, TreeFanout[level],
+	      found ? "SUCCESSFUL" : "UNSUCCESSFUL");
+    }
+  } while (iterations < MAX_PARTITION_ITERATIONS && !found);
+  if (!found) {
+    Fprintf(stdout,"Failed embedding at level %d; no partition\n",level);
+    goto fail;
+  }
+
+  leftelement = MultilevelPartition(left, partition, level-1);
+  if (leftelement == 0) goto fail;
+  rightelement = MultilevelPartition(partition+1, right, level-1);
+  if (rightelement == 0) goto fail;
+
+  /* add it to the list */
+  AddNewElement(leftelement, rightelement);
+  DBUG_RETURN(NewN);
+
+ fail:
+  NewN = OriginalNewN;
+  DBUG_RETURN(0);
+}
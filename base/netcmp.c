@@ -17,6 +17,7 @@ along with this program; see the file copying.  If not, write to
 the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* netcmp.c  -- graph isomorphism testing */
+#define MEMTAG MEM_COMPARE	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -29,6 +30,8 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include <limits.h>
 #include <math.h>    /* for fabs() */
 #include <ctype.h>   /* for toupper() */
+#include <unistd.h>  /* for sysconf() */
+#include <pthread.h>
 
 #ifdef IBMPC
 #include <alloc.h>
@@ -48,7 +51,9 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "netfile.h"
 #include "print.h"
 #include "dbug.h"
+#include "timing.h"
 #include "hash.h"
+#include "memstats.h"
 
 #ifdef TCL_NETGEN
 int InterruptPending = 0;
@@ -167,6 +172,15 @@ int ExhaustiveSubdivision = 0;
 /* topologically, as opposed to just matching numerically.	*/
 int ExactTopology = 0;
 
+/* Number of threads used to check the properties of matched	*/
+/* elements and to find parallel devices in large cells (0 =	*/
+/* one per processor).						*/
+int PropertyThreads = 0;
+
+/* Serializes the changes that property checks running on	*/
+/* different threads make to the device cells they share.	*/
+static pthread_mutex_t PropertyLock = PTHREAD_MUTEX_INITIALIZER;
+
 #ifdef TEST
 static void PrintElement_List(struct Element *E)
 {
@@ -1276,6 +1290,118 @@ SortFanoutLists(nlist1, nlist2)
     HashKill(&f2hash);
 }
 
+/* 
+ *---------------------------------------------------------------------
+ *
+ * Content matching of unmatched nets and devices.  Each entry of a
+ * formatted list is reduced to an array of keys, one per fanout entry,
+ * holding the hash of the model and pin name.  Keys are sorted by
+ * hash, so that two entries can be compared by a merge instead of by
+ * building hash tables.  All arrays used for content matching are kept
+ * in one scratch structure that is reused and grown across calls.
+ *
+ *---------------------------------------------------------------------
+ */
+
+#define MINHASH_K	16	/* Length of MinHash signatures		*/
+#define MINHASH_ROWS	2	/* Signature entries per LSH band	*/
+#define MINHASH_BANDS	(MINHASH_K / MINHASH_ROWS)
+#define CONTENT_ALLPAIRS 4096	/* Score all pairs below this many	*/
+
+struct fanoutkey {
+    unsigned long hash;
+    struct FanoutList *fl;
+};
+
+struct contentsig {
+    struct FormattedList *list;
+    int keys;			/* Offset of first key in scratch */
+    int nkeys;
+    unsigned long sig[MINHASH_K];
+};
+
+static struct {
+    struct fanoutkey *keys;
+    int keyalloc;
+    struct contentsig *sigs;
+    int sigalloc;
+    int *ints;
+    int intalloc;
+} ContentScratch = {NULL, 0, NULL, 0, NULL, 0};
+
+static void *ContentGrow(void *ptr, int *alloc, int need, size_t size)
+{
+    if (need <= *alloc) return ptr;
+    if (ptr != NULL) FREE(ptr);
+    *alloc = (*alloc == 0) ? 256 : *alloc;
+    while (*alloc < need) *alloc <<= 1;
+    return CALLOC(*alloc, size);
+}
+
+static int fanoutkeycmp(const void *a, const void *b)
+{
+    unsigned long ha = ((struct fanoutkey *)a)->hash;
+    unsigned long hb = ((struct fanoutkey *)b)->hash;
+
+    return (ha < hb) ? -1 : (ha > hb) ? 1 : 0;
+}
+
+/* Fill "keys" with the sorted fanout keys of a formatted list.	*/
+/* Element fragments have no model name.			*/
+
+static void ContentKeys(struct FormattedList *nlist, struct fanoutkey *keys)
+{
+    struct FanoutList *fl;
+    int f;
+
+    for (f = 0; f < nlist->fanout; f++) {
+	fl = &(nlist->flist[f]);
+	keys[f].hash = (fl->model == NULL) ? 0 : (*hashfunc)(fl->model, 0);
+	keys[f].hash *= 16777619ul;
+	if (fl->name != NULL) keys[f].hash ^= (*hashfunc)(fl->name, 0);
+	keys[f].fl = fl;
+    }
+    qsort(keys, nlist->fanout, sizeof(struct fanoutkey), fanoutkeycmp);
+}
+
+/* Compare two names, either of which may be NULL */
+
+static int ContentMatch(char *name1, char *name2)
+{
+    if ((name1 == NULL) || (name2 == NULL)) return (name1 == name2);
+    return (*matchfunc)(name1, name2);
+}
+
+/* Score two sorted key arrays as described for NodeMatchScore() */
+
+static int ContentScore(struct fanoutkey *keys1, int n1,
+	struct fanoutkey *keys2, int n2)
+{
+    struct FanoutList *fl1, *fl2;
+    int f1 = 0, f2 = 0, score = 0;
+
+    if ((n1 == 0) || (n2 == 0)) return 0;
+
+    while ((f1 < n1) && (f2 < n2)) {
+	if (keys1[f1].hash < keys2[f2].hash)
+	    f1++;
+	else if (keys1[f1].hash > keys2[f2].hash)
+	    f2++;
+	else {
+	    fl1 = keys1[f1].fl;
+	    fl2 = keys2[f2].fl;
+	    if (ContentMatch(fl1->model, fl2->model) &&
+			ContentMatch(fl1->name, fl2->name)) {
+		score++;
+		if (fl1->count == fl2->count) score++;
+	    }
+	    f1++;
+	    f2++;
+	}
+    }
+    return (50 * score) / ((n1 < n2) ? n2 : n1);
+}
+
 /* 
  *---------------------------------------------------------------------
  *
@@ -1298,60 +1424,219 @@ int
 NodeMatchScore(nlist1, nlist2)
     struct FormattedList *nlist1, *nlist2;
 {
-    struct hashdict f1hash, f2hash;
-    char pinname[1024];
-    int f1, f2, maxfanout;
-    int score = 0;
+    struct fanoutkey *keys;
+
+    ContentScratch.keys = (struct fanoutkey *)ContentGrow(ContentScratch.keys,
+		&ContentScratch.keyalloc, nlist1->fanout + nlist2->fanout,
+		sizeof(struct fanoutkey));
+    keys = ContentScratch.keys;
+    ContentKeys(nlist1, keys);
+    ContentKeys(nlist2, keys + nlist1->fanout);
+    return ContentScore(keys, nlist1->fanout, keys + nlist1->fanout,
+		nlist2->fanout);
+}
 
-    InitializeHashTable(&f1hash, OBJHASHSIZE);
-    InitializeHashTable(&f2hash, OBJHASHSIZE);
+/* Compute the MinHash signature of a list from its sorted keys.  The	*/
+/* set hashed is each model/pin, plus each model/pin with its count,	*/
+/* so that similarity reflects both terms of the match score.		*/
 
-    if (nlist1->fanout < nlist2->fanout) {
-    	for (f2 = 0; f2 < nlist2->fanout; f2++) {
-	    sprintf(pinname, "%s/%s", nlist2->flist[f2].model,
-			nlist2->flist[f2].name);
-	    HashPtrInstall(pinname, (void *)((long)f2 + 1), &f2hash);
+static void ContentSignature(struct contentsig *cs, struct fanoutkey *keys)
+{
+    unsigned long x, v;
+    int f, k, c;
+
+    for (k = 0; k < MINHASH_K; k++) cs->sig[k] = ~0UL;
+    for (f = 0; f < cs->nkeys; f++) {
+	for (c = 0; c < 2; c++) {
+	    x = keys[f].hash;
+	    if (c == 1) x ^= ((unsigned long)keys[f].fl->count + 1) * 2654435761ul;
+	    for (k = 0; k < MINHASH_K; k++) {
+		v = (x ^ ((unsigned long)k * 0x9e3779b9ul)) * 2246822519ul;
+		v ^= v >> 13;
+		v *= 3266489917ul;
+		v ^= v >> 16;
+		if (v < cs->sig[k]) cs->sig[k] = v;
+	    }
 	}
+    }
+}
 
-	for (f1 = 0; f1 < nlist1->fanout; f1++) {
-	    sprintf(pinname, "%s/%s", nlist1->flist[f1].model,
-			nlist1->flist[f1].name);
-	    f2 = (int)(long)HashLookup(pinname, &f2hash);
-	    if (f2 != 0) {
-	    	f2 -= 1;
-		score++;
-		if (nlist1->flist[f1].count == nlist2->flist[f2].count)
-		    score++;
-	    }
+static unsigned long ContentBand(struct contentsig *cs, int band)
+{
+    unsigned long h = 2166136261ul;
+    int r;
+
+    for (r = band * MINHASH_ROWS; r < (band + 1) * MINHASH_ROWS; r++) {
+	h ^= cs->sig[r];
+	h *= 16777619ul;
+    }
+    return h;
+}
+
+/* 
+ *---------------------------------------------------------------------
+ *
+ * Pair entries of "mlists" that did not match by name with entries of
+ * "rlists" by content, moving the chosen entry of mlists into the same
+ * position as its partner in rlists.  matched[] flags the positions
+ * already paired (-1) and has nmax entries, with nmax >= rmax.
+ *
+ * Each entry gets a MinHash signature over its fanout, and candidate
+ * partners are the entries that share at least one band of the
+ * signature (locality-sensitive hashing), so the run time is roughly
+ * linear in the number of entries.  Candidates are ranked by the same
+ * score as NodeMatchScore().  When there are few entries, all pairs are
+ * scored.
+ *
+ *---------------------------------------------------------------------
+ */
+
+static void SortUnmatchedByContent(struct FormattedList **rlists,
+	struct FormattedList **mlists, int rmax, int mmax, int *matched)
+{
+    struct FormattedList *temp;
+    struct contentsig *sigs, *rs, *ms;
+    struct fanoutkey *keys;
+    int *pos, *at, *heads, *nextc, *stamp;
+    int nr, nm, n, r, c, b, q, nkeys, best, ibest, score, tsize, allpairs;
+    unsigned long mask;
+
+    /* Count unmatched entries and their keys */
+    nr = nm = nkeys = 0;
+    for (r = 0; r < rmax; r++)
+	if (matched[r] != -1) {
+	    nr++;
+	    nkeys += rlists[r]->fanout;
+	}
+    for (q = 0; q < mmax; q++)
+	if ((q >= rmax) || (matched[q] != -1)) {
+	    nm++;
+	    nkeys += mlists[q]->fanout;
+	}
+    if ((nr == 0) || (nm == 0)) return;
+
+    allpairs = ((long)nr * (long)nm <= CONTENT_ALLPAIRS) ? 1 : 0;
+    for (tsize = 16; tsize < 2 * nm; tsize <<= 1);
+    mask = (unsigned long)(tsize - 1);
+
+    /* Scratch:  signatures (unmatched mlists first, then rlists), keys, */
+    /* and integer arrays pos[nm], nextc[bands * nm], stamp[nm], at[mmax], */
+    /* heads[bands * tsize].						 */
+
+    ContentScratch.sigs = (struct contentsig *)ContentGrow(ContentScratch.sigs,
+		&ContentScratch.sigalloc, nm + nr, sizeof(struct contentsig));
+    ContentScratch.keys = (struct fanoutkey *)ContentGrow(ContentScratch.keys,
+		&ContentScratch.keyalloc, nkeys, sizeof(struct fanoutkey));
+    ContentScratch.ints = (int *)ContentGrow(ContentScratch.ints,
+		&ContentScratch.intalloc, nm * (MINHASH_BANDS + 2) + mmax +
+		MINHASH_BANDS * tsize, sizeof(int));
+    sigs = ContentScratch.sigs;
+    keys = ContentScratch.keys;
+    pos = ContentScratch.ints;
+    nextc = pos + nm;
+    stamp = nextc + MINHASH_BANDS * nm;
+    at = stamp + nm;
+    heads = at + mmax;
+
+    /* Compute keys and signatures */
+    n = nkeys = 0;
+    for (q = 0; q < mmax; q++) {
+	at[q] = -1;
+	if ((q >= rmax) || (matched[q] != -1)) {
+	    ms = &sigs[n];
+	    ms->list = mlists[q];
+	    ms->keys = nkeys;
+	    ms->nkeys = mlists[q]->fanout;
+	    ContentKeys(ms->list, keys + nkeys);
+	    ContentSignature(ms, keys + nkeys);
+	    nkeys += ms->nkeys;
+	    pos[n] = q;
+	    at[q] = n;
+	    stamp[n] = -1;
+	    n++;
 	}
     }
-    else {
-    	for (f1 = 0; f1 < nlist1->fanout; f1++) {
-	    sprintf(pinname, "%s/%s", nlist1->flist[f1].model,
-			nlist1->flist[f1].name);
-	    HashPtrInstall(pinname, (void *)((long)f1 + 1), &f1hash);
+    for (r = 0; r < rmax; r++) {
+	if (matched[r] != -1) {
+	    rs = &sigs[n];
+	    rs->list = rlists[r];
+	    rs->keys = nkeys;
+	    rs->nkeys = rlists[r]->fanout;
+	    ContentKeys(rs->list, keys + nkeys);
+	    ContentSignature(rs, keys + nkeys);
+	    nkeys += rs->nkeys;
+	    n++;
 	}
+    }
 
-	for (f2 = 0; f2 < nlist2->fanout; f2++) {
-	    sprintf(pinname, "%s/%s", nlist2->flist[f2].model,
-			nlist2->flist[f2].name);
-	    f1 = (int)(long)HashLookup(pinname, &f1hash);
-	    if (f1 != 0) {
-	    	f1 -= 1;
-		score++;
-		if (nlist2->flist[f2].count == nlist1->flist[f1].count)
-		    score++;
+    /* Install the unmatched mlists entries in the LSH band tables */
+    if (!allpairs) {
+	for (c = 0; c < MINHASH_BANDS * tsize; c++) heads[c] = -1;
+	for (c = 0; c < nm; c++) {
+	    if (sigs[c].nkeys == 0) continue;
+	    for (b = 0; b < MINHASH_BANDS; b++) {
+		q = b * tsize + (int)(ContentBand(&sigs[c], b) & mask);
+		nextc[b * nm + c] = heads[q];
+		heads[q] = c;
 	    }
 	}
     }
 
-    HashKill(&f1hash);
-    HashKill(&f2hash);
-
-    maxfanout = (nlist1->fanout < nlist2->fanout) ? nlist2->fanout : nlist1->fanout;
-    score = (50 * score) / maxfanout;
-
-    return score;
+    /* Pair each unmatched rlists entry with its best candidate */
+    n = nm;
+    for (r = 0; r < rmax; r++) {
+	if (matched[r] == -1) continue;
+	rs = &sigs[n++];
+	if (rs->nkeys == 0) continue;
+
+	best = 0;
+	ibest = -1;
+	if (allpairs) {
+	    for (c = 0; c < nm; c++) {
+		if (stamp[c] == -2) continue;		/* Already paired */
+		ms = &sigs[c];
+		score = ContentScore(keys + rs->keys, rs->nkeys,
+			keys + ms->keys, ms->nkeys);
+		if (score > best) {
+		    best = score;
+		    ibest = c;
+		}
+	    }
+	}
+	else {
+	    for (b = 0; b < MINHASH_BANDS; b++) {
+		c = heads[b * tsize + (int)(ContentBand(rs, b) & mask)];
+		for (; c >= 0; c = nextc[b * nm + c]) {
+		    if ((stamp[c] == -2) || (stamp[c] == r)) continue;
+		    stamp[c] = r;			/* Scored for r */
+		    ms = &sigs[c];
+		    score = ContentScore(keys + rs->keys, rs->nkeys,
+				keys + ms->keys, ms->nkeys);
+		    if (score > best) {
+			best = score;
+			ibest = c;
+		    }
+		}
+	    }
+	}
+	if (ibest < 0) continue;
+
+	/* Swap the chosen entry into position r */
+	q = pos[ibest];
+	c = at[r];
+	temp = mlists[q];
+	mlists[q] = mlists[r];
+	mlists[r] = temp;
+	if (c >= 0) {
+	    pos[c] = q;
+	    at[q] = c;
+	}
+	pos[ibest] = r;
+	at[r] = ibest;
+	stamp[ibest] = -2;
+	matched[r] = -1;
+	SortFanoutLists(rlists[r], mlists[r]);
+    }
 }
 
 /* 
@@ -1370,7 +1655,7 @@ void SortUnmatchedLists(nlists1, nlists2, n1max, n2max)
 {
     struct FormattedList *temp;
     int n1, n2;
-    int *matched, total, best, ibest;
+    int *matched, total;
 
     struct hashdict n1hash, n2hash;
 
@@ -1403,36 +1688,8 @@ void SortUnmatchedLists(nlists1, nlists2, n1max, n2max)
 	}
 
 	/* For all nets that didn't match by name, match by content */
-#if 0
-	/* This is ifdef'd out because the improvement in the presentation
-	 * of the output is minimal, but the amount of computation is huge.
-	 * There are numerous ways to optimize this.
-	 */
-	if (total < n1max) {
-    	    for (n1 = 0; n1 < n1max; n1++) {
-		if (matched[n1] != -1) {
-		    best = 0;
-		    ibest = -1;
-		    for (n2 = 0; n2 < n2max; n2++) {
-			if (matched[n2] != -1) {
-			    matched[n2] = NodeMatchScore(nlists1[n1], nlists2[n2]);
-			    if (matched[n2] > best) {
-				best = matched[n2];
-				ibest = n2;
-			    }
-		 	}
-		    }
-		    if (ibest >= 0) {
-		       matched[n1] = -1;
-		       temp = nlists2[ibest];
-		       nlists2[ibest] = nlists2[n1];
-		       nlists2[n1] = temp;
-		       SortFanoutLists(nlists1[n1], nlists2[n1]);
-		    }
-		}
-	    }
-	}
-#endif
+	if (total < n1max)
+	    SortUnmatchedByContent(nlists1, nlists2, n1max, n2max, matched);
     }
     else {
     	matched = (int *)CALLOC(n1max, sizeof(int));
@@ -1463,36 +1720,8 @@ void SortUnmatchedLists(nlists1, nlists2, n1max, n2max)
 	    }
 	}
 	/* For all nets that didn't match by name, match by content */
-#if 0
-	/* This is ifdef'd out because the improvement in the presentation
-	 * of the output is minimal, but the amount of computation is huge.
-	 * There are numerous ways to optimize this.
-	 */
-	if (total < n2max) {
-    	    for (n2 = 0; n2 < n2max; n2++) {
-		if (matched[n2] != -1) {
-		    best = 0;
-		    ibest = -1;
-		    for (n1 = 0; n1 < n1max; n1++) {
-			if (matched[n1] != -1) {
-			    matched[n1] = NodeMatchScore(nlists2[n2], nlists1[n1]);
-			    if (matched[n1] > best) {
-				best = matched[n1];
-				ibest = n1;
-			    }
-		 	}
-		    }
-		    if (ibest >= 0) {
-		       matched[n2] = -1;
-		       temp = nlists1[ibest];
-		       nlists1[ibest] = nlists1[n2];
-		       nlists1[n2] = temp;
-		       SortFanoutLists(nlists2[n2], nlists1[n2]);
-		    }
-		}
-	    }
-	}
-#endif
+	if (total < n2max)
+	    SortUnmatchedByContent(nlists2, nlists1, n2max, n1max, matched);
     }
 
     FREE(matched);
@@ -2289,6 +2518,124 @@ void FreeNodeList(struct NodeList *old)
 	NodeListFreeList = old;
 }
 
+/* The following get a chain of "count" records, linked through	*/
+/* "next", for building the comparison graph.  Records are taken	*/
+/* from the free list first, and the rest are allocated as a single	*/
+/* block.  Like all records, they are only ever returned to the free	*/
+/* list and never freed individually.					*/
+
+struct Element *GetElements(int count)
+{
+	struct Element *head, *new_element, *block;
+	int i;
+
+	head = NULL;
+	while ((count > 0) && (ElementFreeList != NULL)) {
+		new_element = ElementFreeList;
+		ElementFreeList = ElementFreeList->next;
+		memzero(new_element, sizeof(struct Element));
+		new_element->next = head;
+		head = new_element;
+		count--;
+	}
+	if (count > 0) {
+	  block = (struct Element *)CALLOC(count, sizeof(struct Element));
+	  if (block == NULL) return NULL;
+	  for (i = count - 1; i >= 0; i--) {
+		block[i].next = head;
+		head = &block[i];
+	  }
+#ifdef DEBUG_ALLOC
+	  ElementAllocated += count;
+#endif
+	}
+	return(head);
+}
+
+struct Node *GetNodes(int count)
+{
+	struct Node *head, *new_node, *block;
+	int i;
+
+	head = NULL;
+	while ((count > 0) && (NodeFreeList != NULL)) {
+		new_node = NodeFreeList;
+		NodeFreeList = NodeFreeList->next;
+		memzero(new_node, sizeof(struct Node));
+		new_node->next = head;
+		head = new_node;
+		count--;
+	}
+	if (count > 0) {
+	  block = (struct Node *)CALLOC(count, sizeof(struct Node));
+	  if (block == NULL) return NULL;
+	  for (i = count - 1; i >= 0; i--) {
+		block[i].next = head;
+		head = &block[i];
+	  }
+#ifdef DEBUG_ALLOC
+	  NodeAllocated += count;
+#endif
+	}
+	return(head);
+}
+
+struct ElementList *GetElementLists(int count)
+{
+	struct ElementList *head, *new_elementlist, *block;
+	int i;
+
+	head = NULL;
+	while ((count > 0) && (ElementListFreeList != NULL)) {
+		new_elementlist = ElementListFreeList;
+		ElementListFreeList = ElementListFreeList->next;
+		memzero(new_elementlist, sizeof(struct ElementList));
+		new_elementlist->next = head;
+		head = new_elementlist;
+		count--;
+	}
+	if (count > 0) {
+	  block = (struct ElementList *)CALLOC(count, sizeof(struct ElementList));
+	  if (block == NULL) return NULL;
+	  for (i = count - 1; i >= 0; i--) {
+		block[i].next = head;
+		head = &block[i];
+	  }
+#ifdef DEBUG_ALLOC
+	  ElementListAllocated += count;
+#endif
+	}
+	return(head);
+}
+
+struct NodeList *GetNodeLists(int count)
+{
+	struct NodeList *head, *new_nodelist, *block;
+	int i;
+
+	head = NULL;
+	while ((count > 0) && (NodeListFreeList != NULL)) {
+		new_nodelist = NodeListFreeList;
+		NodeListFreeList = NodeListFreeList->next;
+		memzero(new_nodelist, sizeof(struct NodeList));
+		new_nodelist->next = head;
+		head = new_nodelist;
+		count--;
+	}
+	if (count > 0) {
+	  block = (struct NodeList *)CALLOC(count, sizeof(struct NodeList));
+	  if (block == NULL) return NULL;
+	  for (i = count - 1; i >= 0; i--) {
+		block[i].next = head;
+		head = &block[i];
+	  }
+#ifdef DEBUG_ALLOC
+	  NodeListAllocated += count;
+#endif
+	}
+	return(head);
+}
+
 #ifdef DEBUG_ALLOC
 void PrintCoreStats(void)
 {
@@ -2322,6 +2669,31 @@ static int NewNumberOfNclasses;
 
 static int Iterations;
 
+/* Progress reporting and budget for the iterative refinement	*/
+/* (set by the "progress" command).  Reports are sent no more	*/
+/* often than every ProgressInterval seconds.  Refinement stops	*/
+/* after IterationBudget iterations of one comparison, or when	*/
+/* one comparison has run for CompareTimeout seconds.  Both	*/
+/* budgets start again with each pair of cells compared.  All	*/
+/* comparisons stop when the wall-clock time reaches		*/
+/* JobDeadline, which covers a whole run such as "lvs".		*/
+
+double ProgressInterval = 0.0;	/* 0 = no reports */
+char *ProgressFile = NULL;	/* status file, rewritten on each report */
+#ifdef TCL_NETGEN
+char *ProgressCommand = NULL;	/* Tcl command called with each report */
+#endif
+int IterationBudget = 0;	/* 0 = no limit */
+double CompareTimeout = 0.0;	/* 0 = no limit */
+double JobDeadline = 0.0;	/* 0 = no limit */
+int BudgetExceeded = 0;
+
+static double CompareStart;
+static double CompareDeadline;
+static double LastProgress;
+static int ProgressEclasses;
+static int ProgressNclasses;
+
 void FreeEntireElementClass(struct ElementClass *ElementClasses)
 {
   struct ElementClass *next;
@@ -2397,6 +2769,11 @@ void ResetState(void)
   PropertyErrorDetected = 0;
   NewFracturesMade = 0;
   ExhaustiveSubdivision = 0;	/* why not ?? */
+  BudgetExceeded = 0;
+  CompareStart = LastProgress = WallTime();
+  CompareDeadline = (CompareTimeout > 0.0) ?
+		CompareStart + CompareTimeout : 0.0;
+  ProgressEclasses = ProgressNclasses = 0;
   /* maybe should free up free lists ??? */
 }
 
@@ -2407,7 +2784,9 @@ struct Element *CreateElementList(char *name, short graph)
 {
   struct objlist *ob;
   struct nlist *tp;
-  struct Element *head, *tail;
+  struct Element *head, *tail, *elements;
+  struct NodeList *nodelists, *tmp;
+  int numelements, numpins;
 	
   /* get a pointer to the cell */	
   tp = LookupCellFile(name, graph);
@@ -2416,35 +2795,43 @@ struct Element *CreateElementList(char *name, short graph)
     return(NULL);
   }
 
-  head = tail = NULL;
+  /* Count the records needed, and get them all at once */
+  numelements = numpins = 0;
   for (ob = tp->cell; ob != NULL; ob = ob->next) {
-    if (ob->type == FIRSTPIN) {
-      struct Element *new_element;
+    if (ob->type == FIRSTPIN) numelements++;
+    if (ob->type >= FIRSTPIN) numpins++;
+  }
+  if (numelements == 0) return NULL;
 
-      new_element = GetElement();
-      if (new_element == NULL) {
-	Fprintf(stderr,"Memory allocation error\n");
+  elements = GetElements(numelements);
+  nodelists = GetNodeLists(numpins);
+  if ((elements == NULL) || ((numpins > 0) && (nodelists == NULL))) {
+    Fprintf(stderr,"Memory allocation error\n");
 #ifdef DEBUG_ALLOC
-	PrintCoreStats();
+    PrintCoreStats();
 #endif
-	ResetState();
-	return NULL;
-      }
-      new_element->object = ob;
-      new_element->graph = graph;
-      /* append to list */
-      if (head == NULL) head = new_element;
-      else tail->next = new_element;
-      tail = new_element;
+    ResetState();
+    return NULL;
+  }
+
+  head = elements;
+  tail = NULL;
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->type == FIRSTPIN) {
+      /* the chain of elements is already in order */
+      tail = (tail == NULL) ? head : tail->next;
+      tail->object = ob;
+      tail->graph = graph;
     }
     if (ob->type >= FIRSTPIN) {
-      struct NodeList *tmp;
-      tmp = GetNodeList();
+      tmp = nodelists;
+      nodelists = nodelists->next;
       tmp->element = tail;
       tmp->next = tail->nodelist;
       tail->nodelist = tmp;
     }
   }
+  tail->next = NULL;
   return(head);
 }
 
@@ -2458,9 +2845,9 @@ struct Node *CreateNodeList(char *name, short graph)
 {
   struct objlist *ob, *newobj;
   struct nlist *tp;
-  struct Node *head, *tail, *new_node;
-  int maxnode, i;
-  struct ElementList *tmp;
+  struct Node *head, *tail, *new_node, *nodes;
+  int maxnode, numpins, numnodes, i;
+  struct ElementList *tmp, *elementlists;
 
   /* get a pointer to the cell */	
   tp = LookupCellFile(name, graph);
@@ -2469,10 +2856,15 @@ struct Node *CreateNodeList(char *name, short graph)
     return(NULL);
   }
 
-  /* find the max. node number */
+  /* find the max. node number, and count the connected pins */
   maxnode = 0;
-  for (ob = tp->cell; ob != NULL; ob = ob->next) 
-    if (ob->type >= FIRSTPIN && ob->node > maxnode) maxnode = ob->node;
+  numpins = 0;
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->type >= FIRSTPIN) {
+      if (ob->node > maxnode) maxnode = ob->node;
+      if (ob->node > 0) numpins++;
+    }
+  }
 	
   /* now allocate the lookup table */
   LookupElementList = 
@@ -2482,39 +2874,52 @@ struct Node *CreateNodeList(char *name, short graph)
     return(NULL);
   }
 
+  elementlists = GetElementLists(numpins);
+  if ((numpins > 0) && (elementlists == NULL)) {
+    Fprintf(stderr,"Memory allocation error\n");
+#ifdef DEBUG_ALLOC
+    PrintCoreStats();
+#endif
+    ResetState();
+    return NULL;
+  }
+
+  numnodes = 0;
   for (ob = tp->cell; ob != NULL; ob = ob->next) {
     // Requirement that ob->node be greater than zero eliminates
     // unconnected nodes (value -1) and dummy nodes (value 0)
     if (ob->type >= FIRSTPIN && (ob->node > 0)) {
-      tmp = GetElementList();
-      if (tmp == NULL) {
-	Fprintf(stderr,"Memory allocation error\n");
-#ifdef DEBUG_ALLOC
-	PrintCoreStats();
-#endif
-	ResetState();
-	return NULL;
-      }
+      tmp = elementlists;
+      elementlists = elementlists->next;
+      if (LookupElementList[ob->node] == NULL) numnodes++;
       tmp->next = LookupElementList[ob->node];
       LookupElementList[ob->node] = tmp;
     }
   }
 
-  /* now generate a list of Nodes */
+  /* now generate a list of Nodes.  The node name cache gives the	*/
+  /* object naming each node directly.				*/
+  CheckNodeNames(tp);
+  nodes = GetNodes(numnodes);
+  if ((numnodes > 0) && (nodes == NULL)) {
+    Fprintf(stderr,"Memory allocation error\n");
+#ifdef DEBUG_ALLOC
+    PrintCoreStats();
+#endif
+    ResetState();
+    return NULL;
+  }
+
   head = tail = NULL;
   for (i = 0; i <= maxnode; i++) {
     if (LookupElementList[i] != NULL) {
-      newobj = LookupObject(NodeName(tp, i), tp);
+      if ((tp->nodename_cache == NULL) || (i > tp->nodename_cache_size))
+	newobj = NULL;
+      else
+	newobj = tp->nodename_cache[i];
       if (newobj != NULL) {	/* NULL objects may be element property records */
-        new_node = GetNode();
-        if (new_node == NULL) {
-	  Fprintf(stderr,"Memory allocation error\n");
-#ifdef DEBUG_ALLOC
-	  PrintCoreStats();
-#endif
-	  ResetState();
-	  return NULL;
-        }
+        new_node = nodes;
+        nodes = nodes->next;
         new_node->object = newobj;
         new_node->graph = graph;
         new_node->elementlist = LookupElementList[i];
@@ -2526,6 +2931,14 @@ struct Node *CreateNodeList(char *name, short graph)
       }
     }
   }
+  if (tail != NULL) tail->next = NULL;
+
+  /* Return records for any nodes that were not named */
+  while (nodes != NULL) {
+    new_node = nodes->next;
+    FreeNode(nodes);
+    nodes = new_node;
+  }
   return (head);
 }
 
@@ -3908,6 +4321,7 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
     struct nlist *tc1, *tc2, *tcf;
     int modified;
 
+    StatStart(STAT_CREATE_LISTS);
     ResetState();
 
     if (file1 == -1)
@@ -3935,10 +4349,12 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
     modified = CreateLists(name1, file1);
     if (Elements == NULL) {
        Printf("Circuit %s contains no devices.\n", name1);
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
     if (Nodes == NULL) {
        Printf("Circuit %s contains no nets.\n", name1);
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
 
@@ -3949,6 +4365,7 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
        PrintCoreStats();
 #endif
        ResetState();
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
     ElementClasses->elements = Elements;
@@ -3966,6 +4383,7 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
        PrintCoreStats();
 #endif
        ResetState();
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
     NodeClasses->nodes = Nodes;
@@ -3981,12 +4399,14 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
     if (Elements == NULL) {
        Printf("Circuit %s contains no devices.\n", name2);
        ResetState();
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
 
     if (Nodes == NULL) {
        Printf("Circuit %s contains no nets.\n", name2);
        ResetState();
+       StatStop(STAT_CREATE_LISTS);
        return;
     }
 
@@ -4037,6 +4457,7 @@ void CreateTwoLists(char *name1, int file1, char *name2, int file2, int dolist)
     FirstNodePass(NodeClasses->nodes, dolist);
     FractureElementClass(&ElementClasses);
     FractureNodeClass(&NodeClasses);
+    StatStop(STAT_CREATE_LISTS);
 }
 
 void RegroupDataStructures(void)
@@ -4153,6 +4574,199 @@ unsigned long NodeHash(struct Node *N)
   return(hashval);
 }
 
+/*--------------------------------------------------------------*/
+/* Send a progress report to the status file and/or the Tcl	*/
+/* progress command.  "state" is "running", "converged" or	*/
+/* "stopped".  The report gives the number of element and node	*/
+/* classes, the number created since the last report, and the	*/
+/* number matched (one member from each circuit).		*/
+/*--------------------------------------------------------------*/
+
+static void JsonString(FILE *f, char *s)
+/* write s to f as a quoted JSON string */
+{
+  putc('"', f);
+  for (; *s != '\0'; s++) {
+    if (*s == '"' || *s == '\\')
+      fprintf(f, "\\%c", *s);
+    else if ((unsigned char)*s < 0x20)
+      fprintf(f, "\\u%04x", (unsigned char)*s);
+    else
+      putc(*s, f);
+  }
+  putc('"', f);
+}
+
+static void MatchedClasses(int *ematched, int *nmatched)
+/* count the classes with one member from each circuit */
+{
+  struct ElementClass *EC;
+  struct NodeClass *NC;
+
+  *ematched = *nmatched = 0;
+  for (EC = ElementClasses; EC != NULL; EC = EC->next)
+    if (EC->count == 2 && EC->elements->graph != EC->elements->next->graph)
+      (*ematched)++;
+  for (NC = NodeClasses; NC != NULL; NC = NC->next)
+    if (NC->count == 2 && NC->nodes->graph != NC->nodes->next->graph)
+      (*nmatched)++;
+}
+
+void ProgressReport(char *state, double now)
+{
+  int ematched, nmatched;
+  double elapsed;
+  char *name1, *name2;
+  char *tmpname;
+  FILE *pfile;
+
+  MatchedClasses(&ematched, &nmatched);
+  elapsed = now - CompareStart;
+  name1 = (Circuit1 != NULL) ? Circuit1->name : "";
+  name2 = (Circuit2 != NULL) ? Circuit2->name : "";
+
+  if (ProgressFile != NULL && *ProgressFile != '\0') {
+    /* Write a new file and rename it, so a reader never sees a	*/
+    /* partly written report.					*/
+    tmpname = (char *)MALLOC(strlen(ProgressFile) + 5);
+    sprintf(tmpname, "%s.tmp", ProgressFile);
+    pfile = fopen(tmpname, "w");
+    if (pfile != NULL) {
+      /* Cell names come from the netlists and are escaped.	*/
+      fprintf(pfile, "{\"state\": \"%s\", \"cell1\": ", state);
+      JsonString(pfile, name1);
+      fprintf(pfile, ", \"cell2\": ");
+      JsonString(pfile, name2);
+      fprintf(pfile, ", \"iteration\": %d, \"elapsed\": %.3f, "
+		"\"element_classes\": %d, \"node_classes\": %d, "
+		"\"new_element_classes\": %d, \"new_node_classes\": %d, "
+		"\"matched_elements\": %d, \"matched_nodes\": %d}\n",
+		Iterations, elapsed,
+		OldNumberOfEclasses, OldNumberOfNclasses,
+		OldNumberOfEclasses - ProgressEclasses,
+		OldNumberOfNclasses - ProgressNclasses,
+		ematched, nmatched);
+      fclose(pfile);
+      rename(tmpname, ProgressFile);
+    }
+    FREE(tmpname);
+  }
+
+#ifdef TCL_NETGEN
+  if (ProgressCommand != NULL && *ProgressCommand != '\0') {
+    Tcl_Obj *cmd, *report;
+    Tcl_InterpState pstate;
+
+    report = Tcl_NewListObj(0, NULL);
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj("state", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj(state, -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj("cell1", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj(name1, -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj("cell2", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewStringObj(name2, -1));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("iteration", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewIntObj(Iterations));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("elapsed", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewDoubleObj(elapsed));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("element_classes", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewIntObj(OldNumberOfEclasses));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("node_classes", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewIntObj(OldNumberOfNclasses));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("new_element_classes", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewIntObj(OldNumberOfEclasses - ProgressEclasses));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("new_node_classes", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewIntObj(OldNumberOfNclasses - ProgressNclasses));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("matched_elements", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewIntObj(ematched));
+    Tcl_ListObjAppendElement(netgeninterp, report,
+		Tcl_NewStringObj("matched_nodes", -1));
+    Tcl_ListObjAppendElement(netgeninterp, report, Tcl_NewIntObj(nmatched));
+
+    /* The command is called with the report appended as a	*/
+    /* key-value list (usable as a dict).			*/
+    cmd = Tcl_NewStringObj(ProgressCommand, -1);
+    Tcl_IncrRefCount(cmd);
+    Tcl_ListObjAppendElement(netgeninterp, cmd, report);
+    pstate = Tcl_SaveInterpState(netgeninterp, TCL_OK);
+    if (Tcl_EvalObjEx(netgeninterp, cmd, TCL_EVAL_GLOBAL) != TCL_OK)
+      Fprintf(stderr, "Error in progress command: %s\n",
+		Tcl_GetStringResult(netgeninterp));
+    Tcl_RestoreInterpState(netgeninterp, pstate);
+    Tcl_DecrRefCount(cmd);
+  }
+#endif
+
+  LastProgress = now;
+  ProgressEclasses = OldNumberOfEclasses;
+  ProgressNclasses = OldNumberOfNclasses;
+}
+
+/*--------------------------------------------------------------*/
+/* Print how far a comparison got before its budget ran out.	*/
+/* Classes are only ever split by refinement, so a class with	*/
+/* unequal counts from the two circuits is a real mismatch even	*/
+/* though the partition is incomplete.  Returns TRUE if such a	*/
+/* mismatch has been found.					*/
+/*--------------------------------------------------------------*/
+
+int PrintPartialResult(void)
+{
+  int ematched, nmatched;
+
+  MatchedClasses(&ematched, &nmatched);
+  Fprintf(stdout, "Partial result after %d iterations:  %d of %d device "
+		"classes and %d of %d net classes matched.\n", Iterations,
+		ematched, OldNumberOfEclasses, nmatched, OldNumberOfNclasses);
+  if (!BadMatchDetected)
+    Fprintf(stdout, "No mismatches found before the comparison stopped.\n");
+  return BadMatchDetected;
+}
+
+/*--------------------------------------------------------------*/
+/* Called after each iteration when progress reporting or a	*/
+/* budget is enabled.  Returns "notdone", forced to zero if the	*/
+/* budget has run out.						*/
+/*--------------------------------------------------------------*/
+
+static int ProgressCheck(int notdone)
+{
+  double now;
+  char *budget;
+
+  now = WallTime();
+  if (JobDeadline > 0.0 && now >= JobDeadline)
+    budget = "job time";
+  else if (CompareDeadline > 0.0 && now >= CompareDeadline)
+    budget = "time";
+  else if (IterationBudget > 0 && Iterations >= IterationBudget)
+    budget = "iteration";
+  else
+    budget = NULL;
+
+  if (notdone && (budget != NULL)) {
+    BudgetExceeded = 1;
+    Fprintf(stdout, "Comparison of %s and %s stopped after %d iterations:  "
+		"%s budget exceeded.  Results are partial.\n",
+		Circuit1->name, Circuit2->name, Iterations, budget);
+    if (ProgressInterval > 0.0) ProgressReport("stopped", now);
+    return 0;
+  }
+  if (ProgressInterval > 0.0 && now - LastProgress >= ProgressInterval)
+    ProgressReport(notdone ? "running" : "converged", now);
+  return notdone;
+}
+
 int Iterate(void)
 /* does one iteration, and returns TRUE if we are done */
 {
@@ -4164,6 +4778,8 @@ int Iterate(void)
     Fprintf(stderr, "Need to initialize data structures first!\n");
     return(1);
   }
+  if (BudgetExceeded) return(1);
+  StatStart(STAT_ITERATE);
 
   for (EC = ElementClasses; EC != NULL; EC = EC->next) 
     Magic(EC->magic);
@@ -4207,6 +4823,11 @@ int Iterate(void)
   Printf("\n");
 #endif
 
+  if (ProgressInterval > 0.0 || IterationBudget > 0 || CompareTimeout > 0.0
+		|| JobDeadline > 0.0)
+    notdone = ProgressCheck(notdone);
+
+  StatStop(STAT_ITERATE);
   return(!notdone);
 }
 
@@ -4328,7 +4949,7 @@ void series_sort(struct objlist *ob1, struct nlist *tp1, int idx1, int run)
 	    sval = vl->value.ival;
 	    continue;
 	 }
-         kl = (struct property *)HashLookup(vl->key, &(tp1->propdict));
+         kl = PropertyLookup(tp1, vl);
 	 if (kl == NULL) continue;		/* Ignored property */
 
 	 /* Get the property value and slop.  Promote if needed.  Save	*/
@@ -4433,6 +5054,7 @@ void series_sort(struct objlist *ob1, struct nlist *tp1, int idx1, int run)
 	 FREE(obn->instance.props[0].value.string);
 	 for (p = 0;; p++) {
 	    obn->instance.props[p].key = obn->instance.props[p + 1].key;
+	    obn->instance.props[p].pindex = obn->instance.props[p + 1].pindex;
 	    obn->instance.props[p].type = obn->instance.props[p + 1].type;
 	    obn->instance.props[p].value = obn->instance.props[p + 1].value;
 	    if (obn->instance.props[p].type == PROP_ENDLIST) break;
@@ -4446,8 +5068,10 @@ void series_sort(struct objlist *ob1, struct nlist *tp1, int idx1, int run)
 	       /* Create a new property record to hold all the existing	*/
 	       /* properties plus the tag at the beginning.		*/
 
-	       kv2 = (struct valuelist *)MALLOC((p + 2) * sizeof(struct valuelist));
+	       kv2 = (struct valuelist *)MALLOCTAG((p + 2) *
+			sizeof(struct valuelist), MEM_PROPERTY);
 	       kv2->key = strsave("_tag");
+	       kv2->pindex = 0;
 	       kv2->type = PROP_STRING;
 	       kv2->value.string = (char *)MALLOC(2);
 	       kv2->value.string[0] = '+';
@@ -4535,7 +5159,7 @@ void parallel_sort(struct objlist *ob1, struct nlist *tp1, int idx1, int run)
 	    mval = vl->value.ival;
 	    continue;
 	 }
-         kl = (struct property *)HashLookup(vl->key, &(tp1->propdict));
+         kl = PropertyLookup(tp1, vl);
 	 if (kl == NULL) continue;		/* Ignored property */
 
 	 /* Get the property value and slop.  Promote if needed.  Save	*/
@@ -4936,9 +5560,28 @@ void PropertySortAndCombine(struct objlist *pre1, struct nlist *tp1,
 typedef struct _proplink *proplinkptr;
 typedef struct _proplink {
    struct property *prop;
+   int col;
    proplinkptr next;
 } proplink;
 
+/* Find the position of property kl in the array plist.  colmap holds	*/
+/* the position plus one for each property index of the cell, or zero	*/
+/* if the property is not in plist.  A property without an index (the	*/
+/* index is full) is found by searching plist.				*/
+
+static int PropertyColumn(int *colmap, int ncols, struct property **plist,
+	int pcount, struct property *kl)
+{
+   int p;
+
+   if ((kl->pindex > 0) && (kl->pindex < ncols))
+      return colmap[kl->pindex] - 1;
+
+   for (p = 0; p < pcount; p++)
+      if (plist[p] == kl) return p;
+   return -1;
+}
+
 int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 	int comb)
 {
@@ -4947,9 +5590,11 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
    unsigned char **clist;
    struct valuelist ***vlist, *vl, *vl2, *newvlist, critval;
    proplinkptr plink, ptop;
-   int pcount, p, i, j, k, pmatch, ival, ctype;
+   int pcount, p, i, j, k, pmatch, ival, ctype, col, ncols;
+   int *colmap;
    double dval;
-   static struct valuelist nullvl, dfltvl;
+   struct valuelist nullvl, dfltvl;
+   struct hashlist *he;
    char multiple[2], other[2];
    int changed = 0, fail = 0;
 
@@ -4958,6 +5603,8 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
    other[1] = '\0';
    other[0] = (series == TRUE) ? 'M' : 'S';
 
+   memset(&nullvl, 0, sizeof(struct valuelist));
+   memset(&dfltvl, 0, sizeof(struct valuelist));
    nullvl.type = PROP_INTEGER;
    nullvl.value.ival = 0;
 
@@ -4969,22 +5616,23 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
    m_rec = NULL;
    ptop = NULL;
    pcount = 1;
-   kl = (struct property *)HashFirst(&(tp->propdict));
-   while (kl != NULL) {
-      // Make a linked list so we don't have to iterate through the hash again 
-      plink = (proplinkptr)MALLOC(sizeof(proplink));
-      plink->prop = kl;
-      plink->next = ptop;
-      ptop = plink;
-      if ((*matchfunc)(kl->key, multiple)) {
-	 kl->idx = 0;
-	 m_rec = kl;
+   // Walk the hash table directly rather than with HashFirst() and
+   // HashNext(), which keep their place in the table itself.
+   for (i = 0; i < tp->propdict.hashsize; i++)
+      for (he = tp->propdict.hashtab[i]; he != NULL; he = he->next) {
+	 if ((kl = (struct property *)he->ptr) == NULL) continue;
+	 // Make a linked list so we don't have to iterate through the hash again 
+	 plink = (proplinkptr)MALLOC(sizeof(proplink));
+	 plink->prop = kl;
+	 plink->next = ptop;
+	 ptop = plink;
+	 if ((*matchfunc)(kl->key, multiple)) {
+	    plink->col = 0;
+	    m_rec = kl;
+	 }
+	 else
+	    plink->col = pcount++;
       }
-      else
-	 kl->idx = pcount++;
-
-      kl = (struct property *)HashNext(&(tp->propdict));
-   }
    // Recast the linked list as an array
    plist = (struct property **)CALLOC(pcount, sizeof(struct property *));
    vlist = (struct valuelist ***)CALLOC(pcount, sizeof(struct valuelist **));
@@ -4994,14 +5642,21 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
       clist[0] = (unsigned char *)CALLOC(run, sizeof(unsigned char));
    }
 
+   // Map each property index of the cell to its column.
+   PropertyIndexCell(tp);
+   ncols = tp->propcount;
+   colmap = (int *)CALLOC((ncols > 0) ? ncols : 1, sizeof(int));
+
    while (ptop != NULL) {
-      plist[ptop->prop->idx] = ptop->prop;
-      vlist[ptop->prop->idx] = (struct valuelist **)CALLOC(run,
+      plist[ptop->col] = ptop->prop;
+      if ((ptop->prop->pindex > 0) && (ptop->prop->pindex < ncols))
+	 colmap[ptop->prop->pindex] = ptop->col + 1;
+      vlist[ptop->col] = (struct valuelist **)CALLOC(run,
 		sizeof(struct valuelist *));
-      clist[ptop->prop->idx] = (unsigned char *)CALLOC(run, sizeof(unsigned char));
-      plink = ptop;
+      clist[ptop->col] = (unsigned char *)CALLOC(run, sizeof(unsigned char));
+      plink = ptop->next;
       FREE(ptop);
-      ptop = plink->next;
+      ptop = plink;
    }
    
    // Now, for each property record, sort the properties of interest
@@ -5014,7 +5669,7 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 	 vl = &(ob2->instance.props[p]);
 	 if (vl->type == PROP_ENDLIST) break;
 	 if (vl->key == NULL) continue;
-	 kl = (struct property *)HashLookup(vl->key, &(tp->propdict));
+	 kl = PropertyLookup(tp, vl);
 	 if (kl == NULL && m_rec == NULL) {
 	    if ((*matchfunc)(vl->key, multiple)) {
 	       vlist[0][i] = vl;
@@ -5034,16 +5689,16 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 		}
 	    }
 	 }
- 	 else if (kl != NULL) {
-	    vlist[kl->idx][i] = vl;
+ 	 else if ((col = PropertyColumn(colmap, ncols, plist, pcount, kl)) >= 0) {
+	    vlist[col][i] = vl;
 	    if (series == FALSE) {
 		if (kl->merge & (MERGE_P_ADD | MERGE_P_PAR | MERGE_P_CRIT))
-		    clist[kl->idx][i] = kl->merge &
+		    clist[col][i] = kl->merge &
 			    (MERGE_P_ADD | MERGE_P_PAR | MERGE_P_CRIT);
 	    }
 	    else if (series == TRUE) {
 		if (kl->merge & (MERGE_S_ADD | MERGE_S_PAR | MERGE_S_CRIT))
-		    clist[kl->idx][i] = kl->merge &
+		    clist[col][i] = kl->merge &
 			    (MERGE_S_ADD | MERGE_S_PAR | MERGE_S_CRIT);
 	    }
 	 }
@@ -5165,8 +5820,8 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 		     if (vl->type == PROP_ENDLIST) break;
 		  }
 		  p++;
-		  newvlist = (struct valuelist *)CALLOC(p + 1,
-				sizeof(struct valuelist));
+		  newvlist = (struct valuelist *)CALLOCTAG(p + 1,
+				sizeof(struct valuelist), MEM_PROPERTY);
 		  // Move end record forward
 	  	  vl = &newvlist[p];
 	  	  vl->key = NULL;
@@ -5186,8 +5841,10 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 		     vl->type = ob2->instance.props[p].type;
 		     vl->value = ob2->instance.props[p].value;
 
-		     kl = (struct property *)HashLookup(vl->key, &(tp->propdict));
-		     if (kl != NULL) vlist[kl->idx][i] = vl;
+		     kl = PropertyLookup(tp, vl);
+		     if ((kl != NULL) && ((col = PropertyColumn(colmap, ncols,
+				plist, pcount, kl)) >= 0))
+			vlist[col][i] = vl;
 		  }
 
 		  // Replace instance properties with the new list
@@ -5326,8 +5983,8 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 		if (ctype & (MERGE_S_ADD | MERGE_P_ADD)) {
 		    if (!vlist[0][i]) {
 			/* Create an entry with M = 0 to force removal */
-			vlist[0][i] = (struct valuelist *)CALLOC(1,
-				sizeof(struct valuelist));
+			vlist[0][i] = (struct valuelist *)CALLOCTAG(1,
+				sizeof(struct valuelist), MEM_PROPERTY);
 		    }
 		    vlist[0][i]->value.ival = 0;	/* set M to 0 */
 		    if (cvlp && (cvlp->type == PROP_INTEGER))
@@ -5350,8 +6007,8 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
 		else if (ctype & (MERGE_S_PAR | MERGE_P_PAR)) {
 		    if (!vlist[0][i]) {
 			/* Create an entry with M = 0 to force removal */
-			vlist[0][i] = (struct valuelist *)CALLOC(1,
-				sizeof(struct valuelist));
+			vlist[0][i] = (struct valuelist *)CALLOCTAG(1,
+				sizeof(struct valuelist), MEM_PROPERTY);
 		    }
 		    vlist[0][i]->value.ival = 0;    /* set M to 0 */
 		    /* Parallel value combination: (X * Y) / (X + Y)
@@ -5393,7 +6050,9 @@ int PropertyOptimize(struct objlist *ob, struct nlist *tp, int run, int series,
       if (vl != NULL && vl->value.ival == 0) {
 	 obt = ob2->next;
 	 ob2->next = ob2->next->next;
+	 pthread_mutex_lock(&PropertyLock);
 	 FreeObjectAndHash(obt, tp);
+	 pthread_mutex_unlock(&PropertyLock);
          changed++;
       }
       else
@@ -5404,14 +6063,13 @@ cleanup:
 
    // Cleanup memory allocation
    for (p = 0; p < pcount; p++) {
-      kl = (struct property *)plist[p];
-      if (kl) kl->idx = 0;
       FREE(vlist[p]);
       FREE(clist[p]);
    }
    FREE(plist);
    FREE(vlist);
    FREE(clist);
+   FREE(colmap);
 
    return changed;
 }
@@ -5524,15 +6182,19 @@ PropertyCheckMismatch(struct objlist *tp1, struct nlist *tc1,
    int islop;
    int ival1, ival2;
    double pd, dslop, dval1, dval2;
-   static struct valuelist mvl, svl;
-   static struct property klm, kls;
-   static char mkey[2], skey[2];
+   struct valuelist mvl, svl;
+   struct property klm, kls;
+   char mkey[2], skey[2];
 
 #ifdef TCL_NETGEN
    Tcl_Obj *proplist = NULL;
 #endif
 
-   // Set up static records representing property M = 1 and S = 1
+   // Set up records representing property M = 1 and S = 1
+   memset(&mvl, 0, sizeof(struct valuelist));
+   memset(&svl, 0, sizeof(struct valuelist));
+   memset(&klm, 0, sizeof(struct property));
+   memset(&kls, 0, sizeof(struct property));
    mkey[0] = 'M';
    mkey[1] = '\0';
    skey[0] = 'S';
@@ -5584,7 +6246,7 @@ PropertyCheckMismatch(struct objlist *tp1, struct nlist *tc1,
 	       if ((*matchfunc)(vl1->key, vl2->key)) break;
 
 	       /* Check if property is "of interest".	*/
-	       kl2 = (struct property *)HashLookup(vl2->key, &(tc2->propdict));
+	       kl2 = PropertyLookup(tc2, vl2);
 	       if (kl2 != NULL) {
 
 	          /* No match */
@@ -5611,7 +6273,7 @@ PropertyCheckMismatch(struct objlist *tp1, struct nlist *tc1,
       if (vl1->key == NULL) continue;
 
       /* Check if this is a "property of interest". */
-      kl1 = (struct property *)HashLookup(vl1->key, &(tc1->propdict));
+      kl1 = PropertyLookup(tc1, vl1);
       if (kl1 == NULL) {
 	 if ((*matchfunc)(vl1->key, mvl.key))
 	    kl1 = &klm;
@@ -5656,8 +6318,7 @@ PropertyCheckMismatch(struct objlist *tp1, struct nlist *tc1,
          		vla = &(tp1->instance.props[k]);
 	 		if (vla->type == PROP_ENDLIST) break;
 			if (vla != vl1) {
-	       		    kla = (struct property *)HashLookup(vla->key,
-					&(tc1->propdict));
+	       		    kla = PropertyLookup(tc1, vla);
 			    if (kla && kla->pin)
 	     		        if ((*matchfunc)(tob2->name, kla->pin))
 				    break;
@@ -5714,7 +6375,7 @@ PropertyCheckMismatch(struct objlist *tp1, struct nlist *tc1,
       if (vl2->key == NULL) continue;
 
       /* Both device classes must agree on the properties to compare */
-      kl2 = (struct property *)HashLookup(vl2->key, &(tc2->propdict));
+      kl2 = PropertyLookup(tc2, vl2);
       if (kl2 == NULL) {
          if (vl2 == &mvl)
 	    kl2 = &klm;
@@ -6148,6 +6809,8 @@ PropertyMatch(struct Element *E1, struct Element *E2,
    /* Both sides should either have no-connects marked, or neither.	*/
    /* Permutable pins need to be handled correctly.			*/
 
+   CheckNodeNames(Circuit1);
+   CheckNodeNames(Circuit2);
    for (tp1 = ob1, tp2 = ob2, nl1 = E1->nodelist; tp1 && tp2; tp1 = tp1->next, tp2 = tp2->next) {
       struct objlist *node1, *node2;
 
@@ -6250,7 +6913,7 @@ PropertyMatch(struct Element *E1, struct Element *E2,
 	    // Allowed for one instance to be missing "M" or "S" if the other
 	    // has value 1.
 	    if (!(*matchfunc)(vl2->key, "M") && !(*matchfunc)(vl2->key, "S")) {
-	        kl2 = (struct property *)HashLookup(vl2->key, &(tc2->propdict));
+	        kl2 = PropertyLookup(tc2, vl2);
 	    	if (kl2 != NULL)
 		    break;	// Property is required
 	    }
@@ -6309,7 +6972,7 @@ PropertyMatch(struct Element *E1, struct Element *E2,
 	    // Allowed for one instance to be missing "M" or "S" if the other
 	    // has value 1.
 	    if (!(*matchfunc)(vl1->key, "M") && !(*matchfunc)(vl1->key, "S")) {
-	        kl1 = (struct property *)HashLookup(vl1->key, &(tc1->propdict));
+	        kl1 = PropertyLookup(tc1, vl1);
 	        if (kl1 != NULL)
 		    break;	// Property is required
 	    }
@@ -6393,6 +7056,36 @@ PropertyMatch(struct Element *E1, struct Element *E2,
 #endif
 }
 
+/*--------------------------------------------------------------*/
+/* Find the two elements of element class EC, returning the	*/
+/* one belonging to Circuit1 in *E1p.  Return FALSE if EC does	*/
+/* not have exactly one element from each graph.		*/
+/*--------------------------------------------------------------*/
+
+static int PropertyPair(struct ElementClass *EC, struct Element **E1p,
+	struct Element **E2p)
+{
+   struct Element *E1, *E2, *Etmp;
+
+   /* This element class should contain exactly two entries,	*/
+   /* one belonging to each graph.				*/
+
+   if (((E1 = EC->elements) == NULL) ||
+	((E2 = EC->elements->next) == NULL) ||
+	(E2->next != NULL) ||
+	(E1->graph == E2->graph))
+      return FALSE;
+
+   if (E1->graph != Circuit1->file) {	/* Ensure that E1 is Circuit1 */
+      Etmp = E1;
+      E1 = E2;
+      E2 = Etmp;
+   }
+   *E1p = E1;
+   *E2p = E2;
+   return TRUE;
+}
+
 /*--------------------------------------------------------------*/
 /* Check device properties of one element class against the	*/
 /* other.  Use graph1 for the reference property names.		*/
@@ -6412,19 +7105,9 @@ void
 #endif
 PropertyCheck(struct ElementClass *EC, int do_print, int do_list, int *rval)
 {
-   struct Element *E1, *E2, *Etmp;
-#ifdef TCL_NETGEN
-   Tcl_Obj *mpair;
-#endif
+   struct Element *E1, *E2;
 
-   /* This element class should contain exactly two entries,	*/
-   /* one belonging to each graph.				*/
-
-   if (((E1 = EC->elements) == NULL) ||
-	((E2 = EC->elements->next) == NULL) ||
-	(E2->next != NULL) ||
-	(E1->graph == E2->graph))
-   {
+   if (!PropertyPair(EC, &E1, &E2)) {
       *rval = -1;
 #ifdef TCL_NETGEN
       return NULL;
@@ -6433,11 +7116,7 @@ PropertyCheck(struct ElementClass *EC, int do_print, int do_list, int *rval)
 #endif
    }
 
-   if (E1->graph != Circuit1->file) {	/* Ensure that E1 is Circuit1 */
-      Etmp = E1;
-      E1 = E2;
-      E2 = Etmp;
-   }
+   StatCount(STAT_PROPERTY_CHECK, 1);
 #ifdef TCL_NETGEN
    return PropertyMatch(E1, E2, do_print, do_list, rval);
 #else
@@ -6445,40 +7124,239 @@ PropertyCheck(struct ElementClass *EC, int do_print, int do_list, int *rval)
 #endif
 }
 
+/*--------------------------------------------------------------*/
+/* Parallel property checks.  The element classes to check are	*/
+/* divided among PropertyThreads threads, each of which runs	*/
+/* PropertyMatch() without printing.  Anything printed anyway	*/
+/* (e.g., by series/parallel reduction) is captured per class	*/
+/* and printed by the calling thread afterwards in class order,	*/
+/* so the output does not depend on the number of threads.	*/
+/*								*/
+/* The checks of different classes touch different instances,	*/
+/* except for the device cells, whose property index is filled	*/
+/* in beforehand so that lookups do not change it.  A cell with	*/
+/* properties still lacking a default value would have it set	*/
+/* by whichever instance is checked first, so such checks are	*/
+/* left to run in order.					*/
+/*--------------------------------------------------------------*/
+
+/* one element class to be checked */
+struct propcheck {
+   struct Element *E1, *E2;
+   int result;				/* as returned by PropertyCheck() */
+   struct printcapture output;		/* captured output of the check */
+};
+
+/* checks shared by the threads of one pass */
+struct propjob {
+   struct propcheck *checks;
+   int nchecks;
+   int next;		/* next check to run */
+   pthread_mutex_t lock;
+};
+
+#define PROPCHUNK 32	/* checks taken by a thread at a time */
+
+static void *PropertyWorker(void *arg)
+/* run checks of the job until none are left */
+{
+   struct propjob *job = (struct propjob *)arg;
+   struct propcheck *pc;
+   int c, last;
+
+   while (1) {
+      pthread_mutex_lock(&job->lock);
+      c = job->next;
+      job->next += PROPCHUNK;
+      pthread_mutex_unlock(&job->lock);
+      if (c >= job->nchecks) break;
+      last = (c + PROPCHUNK < job->nchecks) ? c + PROPCHUNK : job->nchecks;
+      for (; c < last; c++) {
+	 pc = job->checks + c;
+	 PrintCaptureStart(&pc->output);
+	 PropertyMatch(pc->E1, pc->E2, 0, 0, &pc->result);
+      }
+   }
+   PrintCaptureStart(NULL);
+   return(NULL);
+}
+
+/*--------------------------------------------------------------*/
+/* Check the properties of the ncls element classes in "classes"	*/
+/* in parallel.  On return, checks[c].result holds the result	*/
+/* for classes[c], as PropertyCheck(EC, 0, 0, &result) would	*/
+/* return it, and checks[c].output holds what the check printed,	*/
+/* which the caller must flush with PrintCaptureFlush().  Return	*/
+/* FALSE, having checked nothing, if the classes should be	*/
+/* checked in order by the caller instead.			*/
+/*--------------------------------------------------------------*/
+
+static int PropertyCheckParallel(struct ElementClass **classes, int ncls,
+	struct propcheck *checks)
+{
+   struct propjob job;
+   struct nlist **cells, *tc;
+   struct Element *E;
+   pthread_t *threads;
+   int c, i, ncells, nthreads, started, ok;
+
+   nthreads = PropertyThreads;
+   if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if (nthreads > ncls) nthreads = ncls;
+   if (nthreads <= 1) return FALSE;
+
+   cells = (struct nlist **)CALLOC(2 * ncls, sizeof(struct nlist *));
+   threads = (pthread_t *)CALLOC(nthreads, sizeof(pthread_t));
+   ok = (cells != NULL && threads != NULL);
+
+   /* Prepare each device cell once */
+   ncells = 0;
+   for (c = 0; ok && c < ncls; c++) {
+      if (!PropertyPair(classes[c], &checks[c].E1, &checks[c].E2)) {
+	 ok = FALSE;
+	 break;
+      }
+      checks[c].result = 0;
+      for (E = checks[c].E1; ; E = checks[c].E2) {
+	 tc = LookupCellFile(E->object->model.class, E->graph);
+	 if (tc != NULL) {
+	    for (i = ncells - 1; i >= 0; i--)
+	       if (cells[i] == tc) break;
+	    if (i < 0) {
+	       cells[ncells++] = tc;
+	       if (PropertyIndexCell(tc) > 0) ok = FALSE;
+	    }
+	 }
+	 if (E == checks[c].E2) break;
+      }
+   }
+
+   if (ok) {
+      CheckNodeNames(Circuit1);
+      CheckNodeNames(Circuit2);
+
+      job.checks = checks;
+      job.nchecks = ncls;
+      job.next = 0;
+      pthread_mutex_init(&job.lock, NULL);
+      MemSetThreaded(TRUE);
+
+      /* the calling thread runs checks too */
+      started = 0;
+      for (c = 1; c < nthreads; c++)
+	 if (pthread_create(threads + started, NULL, PropertyWorker, &job) == 0)
+	    started++;
+      PropertyWorker(&job);
+      for (c = 0; c < started; c++) pthread_join(threads[c], NULL);
+
+      MemSetThreaded(FALSE);
+      pthread_mutex_destroy(&job.lock);
+      StatCount(STAT_PROPERTY_CHECK, ncls);
+   }
+
+   if (cells != NULL) FREE(cells);
+   if (threads != NULL) FREE(threads);
+   return ok;
+}
+
+/*--------------------------------------------------------------*/
+/* Collect the element classes having one element from each	*/
+/* graph.  If "stop" is TRUE, stop at the first class having	*/
+/* unequal numbers of elements from the two graphs.  Return the	*/
+/* number of classes, with the list in *classes (to be freed by	*/
+/* the caller), or zero if there are none.			*/
+/*--------------------------------------------------------------*/
+
+static int PropertyClasses(struct ElementClass ***classes, int stop)
+{
+   struct ElementClass *EC, **list = NULL;
+   struct Element *E;
+   int C1, C2, pass, ncls = 0;
+
+   *classes = NULL;
+   for (pass = 0; pass < 2; pass++) {
+      if (pass == 1) {
+	 if (ncls == 0) break;
+	 list = (struct ElementClass **)MALLOC(ncls *
+			sizeof(struct ElementClass *));
+	 if (list == NULL) return 0;
+	 ncls = 0;
+      }
+      for (EC = ElementClasses; EC != NULL; EC = EC->next) {
+	 C1 = C2 = 0;
+	 for (E = EC->elements; E != NULL; E = E->next)
+	    (E->graph == Circuit1->file) ? C1++ : C2++;
+	 if (stop && (C1 != C2)) break;
+	 if (C1 != 1 || C2 != 1) continue;
+	 if (pass == 1) list[ncls] = EC;
+	 ncls++;
+      }
+   }
+   *classes = list;
+   return ncls;
+}
+
 /*--------------------------------------------------------------*/
 /* Print results of property checks				*/
 /*--------------------------------------------------------------*/
 
 void PrintPropertyResults(int do_list)
 {
-    int rval;
-    struct ElementClass *EC;
+    int rval, c, ncls;
+    struct ElementClass *EC, **classes;
+    struct propcheck *checks = NULL;
 #ifdef TCL_NETGEN
+    Tcl_Obj *proplist = NULL, *eprop;
+#endif
 
-    if (do_list) {
-       Tcl_Obj *proplist, *eprop;
+    StatStart(STAT_PROPERTY_CHECK);
+#ifdef TCL_NETGEN
+    if (do_list) proplist = Tcl_NewListObj(0, NULL);
+#endif
+
+    /* Check all classes quietly in parallel first, then go	*/
+    /* back over those with errors to print (or list) them.	*/
+
+    ncls = PropertyClasses(&classes, FALSE);
+    if (ncls > 0) {
+       checks = (struct propcheck *)CALLOC(ncls, sizeof(struct propcheck));
+       if ((checks != NULL) && !PropertyCheckParallel(classes, ncls, checks)) {
+	  FREE(checks);
+	  checks = NULL;
+       }
+    }
 
-       proplist = Tcl_NewListObj(0, NULL);
-       for (EC = ElementClasses; EC != NULL; EC = EC->next) {
- 	   eprop = PropertyCheck(EC, 1, 1, &rval);
-	   if (eprop != NULL)
-	      Tcl_ListObjAppendElement(netgeninterp, proplist, eprop);
+    c = 0;
+    for (EC = ElementClasses; EC != NULL; EC = EC->next) {
+       if (checks != NULL) {
+	  /* Other classes have nothing to print */
+	  if ((c == ncls) || (classes[c] != EC)) continue;
+	  PrintCaptureFlush(&checks[c].output, TRUE);
+	  if (checks[c++].result == 0) continue;
        }
+#ifdef TCL_NETGEN
+       if (do_list) {
+ 	  eprop = PropertyCheck(EC, 1, 1, &rval);
+	  if (eprop != NULL)
+	     Tcl_ListObjAppendElement(netgeninterp, proplist, eprop);
+       }
+       else
+#endif
+ 	  PropertyCheck(EC, 1, 0, &rval);
+    }
+
+#ifdef TCL_NETGEN
+    if (do_list) {
        Tcl_SetVar2Ex(netgeninterp, "lvs_out", NULL,
 			Tcl_NewStringObj("properties", -1),
 			TCL_APPEND_VALUE | TCL_LIST_ELEMENT);
        Tcl_SetVar2Ex(netgeninterp, "lvs_out", NULL, proplist,
 			TCL_APPEND_VALUE | TCL_LIST_ELEMENT);
     }
-    else {
-#endif
-
-    for (EC = ElementClasses; EC != NULL; EC = EC->next)
- 	PropertyCheck(EC, 1, 0, &rval);
-
-#ifdef TCL_NETGEN
-    }
 #endif
+    if (checks != NULL) FREE(checks);
+    if (classes != NULL) FREE(classes);
+    StatStop(STAT_PROPERTY_CHECK);
 }
 
 /*----------------------------------------------------------------------*/
@@ -6498,18 +7376,51 @@ int VerifyMatching(void)
   int P1, P2;
   struct objlist *ob1, *ob2;
   int portMismatch = 0;
+  struct ElementClass **classes;
+  struct propcheck *checks;
+  int c, ncls, checked = FALSE;
 
   if (BadMatchDetected) return(-1);
+
+  /* Check properties in parallel if possible.  Unlike the loop	*/
+  /* below, this does not stop at the first class with errors,	*/
+  /* so that the classes checked do not depend on the order in	*/
+  /* which the threads finish, but the result is the same.	*/
+
+  ncls = 0;
+  if (PropertyErrorDetected != 1)
+     ncls = PropertyClasses(&classes, TRUE);
+  if (ncls > 0) {
+     checks = (struct propcheck *)CALLOC(ncls, sizeof(struct propcheck));
+     StatStart(STAT_PROPERTY_CHECK);
+     if ((checks != NULL) && PropertyCheckParallel(classes, ncls, checks)) {
+	checked = TRUE;
+	for (c = 0; c < ncls; c++) {
+	   PrintCaptureFlush(&checks[c].output, TRUE);
+	   if (checks[c].result > 0)
+	      PropertyErrorDetected = 1;
+	   else if ((checks[c].result < 0) && (PropertyErrorDetected != 1))
+	      PropertyErrorDetected = -1;
+	}
+     }
+     StatStop(STAT_PROPERTY_CHECK);
+     if (checks != NULL) FREE(checks);
+     FREE(classes);
+  }
   
   ret = 0;
+  StatStart(STAT_PROPERTY_CHECK);
   for (EC = ElementClasses; EC != NULL; EC = EC->next) {
     C1 = C2 = 0;
     for (E = EC->elements; E != NULL; E = E->next) 
       (E->graph == Circuit1->file) ? C1++ : C2++;
-    if (C1 != C2) return(-1);
+    if (C1 != C2) {
+      StatStop(STAT_PROPERTY_CHECK);
+      return(-1);
+    }
     if (C1 != 1)
        ret++;
-    else if (PropertyErrorDetected != 1) {
+    else if (!checked && (PropertyErrorDetected != 1)) {
        PropertyCheck(EC, 0, 0, &result);
        if (result > 0)
 	  PropertyErrorDetected = 1;
@@ -6517,6 +7428,7 @@ int VerifyMatching(void)
 	  PropertyErrorDetected = -1;
     }
   }
+  StatStop(STAT_PROPERTY_CHECK);
 
   P1 = P2 = 0;
   for (NC = NodeClasses; NC != NULL; NC = NC->next) {
@@ -6616,6 +7528,8 @@ int ResolveAutomorphsByPin(int match_nets)
     unsigned long newhash, orighash;
     int portnum;
 
+    StatStart(STAT_RESOLVE);
+
     /* Diagnostic */
     if (match_nets)
 	Fprintf(stdout, "Resolving symmetries by net name.\n");
@@ -6663,6 +7577,7 @@ int ResolveAutomorphsByPin(int match_nets)
     FractureNodeClass(&NodeClasses); 
     ExhaustiveSubdivision = 1;
     while (!Iterate() && VerifyMatching() >= 0); 
+    StatStop(STAT_RESOLVE);
     return(VerifyMatching());
 }
 
@@ -6683,6 +7598,8 @@ int ResolveAutomorphsByProperty()
     int C1, C2, result, badmatch;
     unsigned long orighash, newhash;
 
+    StatStart(STAT_RESOLVE);
+
     /* Diagnostic */
     Fprintf(stdout, "Resolving symmetries by property value.\n");
 
@@ -6767,6 +7684,7 @@ int ResolveAutomorphsByProperty()
     FractureNodeClass(&NodeClasses); 
     ExhaustiveSubdivision = 1;
     while (!Iterate() && VerifyMatching() >= 0); 
+    StatStop(STAT_RESOLVE);
     return(VerifyMatching());
 }
 
@@ -6794,6 +7712,8 @@ int ResolveAutomorphisms()
   int C1, C2;
   int automorphs;
 
+  StatStart(STAT_RESOLVE);
+
   for (EC = ElementClasses; EC != NULL; EC = EC->next) {
     struct Element *E1, *E2;
     C1 = C2 = 0;
@@ -6846,6 +7766,7 @@ int ResolveAutomorphisms()
   ExhaustiveSubdivision = 1;
   while (!Iterate() && (VerifyMatching() >= 0));
 
+  StatStop(STAT_RESOLVE);
   return VerifyMatching();
 }
 
@@ -7334,7 +8255,7 @@ int reorderpins(struct hashlist *p, int file)
     struct nlist *ptr;
     struct nlist *tc2 = Circuit2;
     struct objlist *ob, *ob2, *firstpin, *oblast, *newob;
-    int i, numports, *nodes, unordered;
+    int i, numports, *nodes, unordered, modified;
     char **names;
 
     ptr = (struct nlist *)(p->ptr);
@@ -7361,6 +8282,10 @@ int reorderpins(struct hashlist *p, int file)
     nodes = (int *)CALLOC(numports, sizeof(int));
     names = (char **)CALLOC(numports, sizeof(char *));
 
+    /* New implicit pins are numbered from the largest node number */
+    CheckNodeNames(ptr);
+    modified = 0;
+
     if (unordered)
 	Fprintf(stderr, "Ports of %s are unordered.  "
 		"Ordering will be arbitrary.\n", tc2->name);
@@ -7374,6 +8299,7 @@ int reorderpins(struct hashlist *p, int file)
 		   Fprintf(stdout, "Reordering pins on instance %s\n", sptr);
 
 		firstpin = ob;
+		modified = 1;
 		ob2 = tc2->cell;
 		for (i = 0; i < numports; i++) {
 		    if (ob2->model.port >= numports) {
@@ -7454,6 +8380,9 @@ int reorderpins(struct hashlist *p, int file)
 	    ob = ob->next;
     }
 
+    /* Pins were renumbered, so rebuild the node names when next used */
+    if (modified) FreeNodeNames(ptr);
+
     FREE(nodes);
     FREE(names);
     return 1;		/* Continue the search. . . */
@@ -7590,7 +8519,7 @@ struct nlist *addproxies(struct hashlist *p, void *clientdata)
     }
 
     // We messed with the node name list, so have to re-cache them
-    if (maxnode < numnodes) CacheNodeNames(ptr);
+    if (maxnode < numnodes) FreeNodeNames(ptr);
 
     return NULL;	/* Keep the search going */
 }
@@ -7666,6 +8595,8 @@ int MatchPins(struct nlist *tc1, struct nlist *tc2, int dolist)
       return 2;
    }
 
+   StatStart(STAT_MATCH_PINS);
+   CheckNodeNames(tc1);
    correspond = (int *)CALLOC((tc1->nodename_cache_maxnodenum + 1), sizeof(int));
    cover = (char *)CALLOC(numnodes, sizeof(char));
    numorig = numnodes;
@@ -7716,6 +8647,7 @@ int MatchPins(struct nlist *tc1, struct nlist *tc2, int dolist)
 			}
 #endif
 			FREE(ostr);
+			StatStop(STAT_MATCH_PINS);
 			return 1;
 		     }
 
@@ -8409,7 +9341,7 @@ int MatchPins(struct nlist *tc1, struct nlist *tc2, int dolist)
 
    if (hasproxy1) {
       RecurseCellHashTable2(addproxies, (void *)(tc1));
-      CacheNodeNames(tc1);
+      FreeNodeNames(tc1);
    }
 
    /* Clean up "UNKNOWN" records from Circuit1 */
@@ -8428,7 +9360,7 @@ int MatchPins(struct nlist *tc1, struct nlist *tc2, int dolist)
 
    if (hasproxy2) {
       RecurseCellHashTable2(addproxies, (void *)(tc2));
-      CacheNodeNames(tc2);
+      FreeNodeNames(tc2);
    }
 
    /* Clean up "UNKNOWN" records from Circuit2 */
@@ -8508,6 +9440,7 @@ int MatchPins(struct nlist *tc1, struct nlist *tc2, int dolist)
 #endif
 
    FREE(ostr);
+   StatStop(STAT_MATCH_PINS);
    return result;
 }
 
@@ -8665,7 +9598,7 @@ struct nlist *derivedprops(struct hashlist *p, void *clientdata)
 	     for (i = 0;; i++) {
 		vl = &(ob->instance.props[i]);
 		if (vl->type == PROP_ENDLIST) break;
-		prop = (struct property *)HashLookup(vl->key, &(tc->propdict));
+		prop = PropertyLookup(tc, vl);
 		if (prop != NULL) {
 		    if ((*matchfunc)(vl->key, dpd->pwidth)) {
 			haswidth = TRUE;
@@ -8702,7 +9635,8 @@ struct nlist *derivedprops(struct hashlist *p, void *clientdata)
 		 * perimeter value to the property list for the instance,
 		 * unless the instance already has the property.
 		 */
-		newvlist = (struct valuelist *)CALLOC(i + 1, sizeof(struct valuelist));
+		newvlist = (struct valuelist *)CALLOCTAG(i + 1,
+				sizeof(struct valuelist), MEM_PROPERTY);
 		vl = &newvlist[i];
 		vl->key = NULL;
 		vl->type = PROP_ENDLIST;
@@ -8,6 +8,14 @@ extern struct nlist *Circuit2;
 
 extern int ExhaustiveSubdivision;
 extern int ExactTopology;
+extern int PropertyThreads;
+
+extern double ProgressInterval;
+extern char *ProgressFile;
+extern int IterationBudget;
+extern double CompareTimeout;
+extern double JobDeadline;
+extern int BudgetExceeded;
 
 extern int left_col_end;
 extern int right_col_end;
@@ -15,6 +23,7 @@ extern int right_col_end;
 #ifdef TCL_NETGEN
 #include <tcl.h>
 extern int InterruptPending;
+extern char *ProgressCommand;
 #endif
 
 /* Exported procedures */
@@ -29,6 +38,8 @@ extern void CreateTwoLists(char *name1, int file1, char *name2, int file2,
 		int dolist);
 extern void DescribeContents(char *name1, int file1, char *name2, int file2);
 extern int Iterate(void);
+extern void ProgressReport(char *state, double now);
+extern int PrintPartialResult(void);
 extern int VerifyMatching(void);
 extern void PrintAutomorphisms(void);
 extern int ResolveAutomorphisms(void);
@@ -18,6 +18,10 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* netfile.c  --  support routines for reading/writing netlist files */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		/* for fopencookie() */
+#endif
+#define MEMTAG MEM_PARSE	/* category of allocations (see config.h) */
 #include "config.h"
 #define FILE_ACCESS_BITS 0777
 
@@ -25,10 +29,18 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include <stdarg.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <errno.h>
 #include <sys/fcntl.h> /* for SGI */
+#ifndef IBMPC
+#include <signal.h>
+#include <sys/wait.h>
+#endif
 #ifdef IBMPC
 #include <stdlib.h>   /* for calloc */
 #endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #ifdef TCL_NETGEN
 #include <tcl.h>
@@ -41,9 +53,26 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "print.h"
 
 static char buffer[LINELENGTH] = "";  /* buffer for FlushString */
+static int bufferlen = 0;	      /* strlen(buffer) */
 int AutoFillColumn = LINELENGTH; /* enable wraparound at LINELENGTH */
 
+/*------------------------------------------------------*/
+/* Output written by FlushString is collected in a	*/
+/* large buffer and written a block at a time, either	*/
+/* to a plain file or, if the file name ends in ".gz",	*/
+/* through zlib.  Setting CompressOutput makes OpenFile	*/
+/* add the ".gz" suffix itself.				*/
+/*------------------------------------------------------*/
+
+#define OUTBUFSIZE (1 << 20)
+
 static FILE *outfile;
+#ifdef HAVE_ZLIB
+static gzFile gzoutfile = NULL;
+#endif
+static char *outbuf = NULL;
+static int outbuflen = 0;
+int CompressOutput = 0;
 static int Graph = 0;
 int File;
 
@@ -132,43 +161,154 @@ int IsPortInPortlist(struct objlist *ob, struct nlist *tp)
 }
 
 
+static void WriteBlock(char *data, int len)
+{
+  if (len <= 0) return;
+#ifdef HAVE_ZLIB
+  if (gzoutfile != NULL) {
+    gzwrite(gzoutfile, data, len);
+    return;
+  }
+#endif
+  fwrite(data, 1, len, outfile);
+}
+
+static void DrainOutput(void)
+{
+  if (outbuf != NULL) WriteBlock(outbuf, outbuflen);
+  outbuflen = 0;
+}
+
+static void WriteOutput(char *data, int len)
+{
+  if (outbuf == NULL) {
+    outbuf = (char *)MALLOC(OUTBUFSIZE);
+    if (outbuf == NULL) {
+      WriteBlock(data, len);
+      return;
+    }
+  }
+  if (outbuflen + len > OUTBUFSIZE) {
+    DrainOutput();
+    if (len > OUTBUFSIZE) {
+      WriteBlock(data, len);
+      return;
+    }
+  }
+  memcpy(outbuf + outbuflen, data, len);
+  outbuflen += len;
+}
+
 void FlushString (char *format, ...)
 {
   va_list argptr;
   char	tmpstr[1000];
+  char	*str, *alloc;
+  int	len;
 
+  /* Plain strings and the common "%s" and " %s" fragments	*/
+  /* are copied without going through vsnprintf.		*/
+
+  alloc = NULL;
   va_start(argptr, format);
-  vsprintf(tmpstr, format, argptr);
+  if (strchr(format, '%') == NULL) {
+    str = format;
+    len = strlen(str);
+  }
+  else if (format[0] == '%' && format[1] == 's' && format[2] == '\0') {
+    str = va_arg(argptr, char *);
+    len = strlen(str);
+  }
+  else if (format[0] == ' ' && format[1] == '%' && format[2] == 's' &&
+		format[3] == '\0' && (str = va_arg(argptr, char *),
+		(len = strlen(str)) < sizeof(tmpstr) - 1)) {
+    tmpstr[0] = ' ';
+    memcpy(tmpstr + 1, str, len + 1);
+    str = tmpstr;
+    len++;
+  }
+  else {
+    va_list argcopy;
+
+    va_end(argptr);
+    va_start(argptr, format);
+    va_copy(argcopy, argptr);
+    len = vsnprintf(tmpstr, sizeof(tmpstr), format, argptr);
+    str = tmpstr;
+    if (len >= (int)sizeof(tmpstr)) {
+      alloc = (char *)MALLOC(len + 1);
+      if (alloc != NULL) {
+        vsnprintf(alloc, len + 1, format, argcopy);
+        str = alloc;
+      }
+      else len = sizeof(tmpstr) - 1;
+    }
+    va_end(argcopy);
+  }
   va_end(argptr);
+  if (len < 0) return;
 
   if (AutoFillColumn) {
-    if (strlen(buffer) + strlen(tmpstr) + 1 > AutoFillColumn) {
-      fprintf(outfile, "%s\n", buffer);
+    if (bufferlen + len + 1 > AutoFillColumn) {
+      buffer[bufferlen++] = '\n';
+      WriteOutput(buffer, bufferlen);
       strcpy(buffer, "     ");
+      bufferlen = 5;
     }
-    strcat(buffer, tmpstr);
-    if (strchr(buffer, '\n') != NULL) {
-      fprintf(outfile, "%s", buffer);
-      strcpy(buffer, "");
+    if (bufferlen + len >= sizeof(buffer)) {
+      /* too long to wrap;  write it as it is */
+      WriteOutput(buffer, bufferlen);
+      WriteOutput(str, len);
+      bufferlen = 0;
+    }
+    else {
+      memcpy(buffer + bufferlen, str, len);
+      bufferlen += len;
+      if (memchr(str, '\n', len) != NULL) {
+        WriteOutput(buffer, bufferlen);
+        bufferlen = 0;
+      }
     }
   }
   else {
     /* check to see if anything is buffered up first */
-    if (strlen(buffer)) {
-      fprintf(outfile, "%s", buffer);
-      strcpy(buffer,"");
+    if (bufferlen) {
+      WriteOutput(buffer, bufferlen);
+      bufferlen = 0;
     }
-    fprintf(outfile, "%s", tmpstr);
+    WriteOutput(str, len);
   }
+  if (alloc != NULL) FREE(alloc);
 }
 
 
 int OpenFile(char *filename, int linelen)
 {
+  int namelen;
+
   if (linelen < LINELENGTH) AutoFillColumn = linelen;
   else AutoFillColumn = LINELENGTH;
-
-  if (strlen(filename) > 0) {
+  bufferlen = 0;
+  outbuflen = 0;
+
+  namelen = strlen(filename);
+  if (namelen > 0) {
+#ifdef HAVE_ZLIB
+    if (CompressOutput && (namelen < 3 || strcmp(filename + namelen - 3, ".gz"))) {
+      char *gzname;
+
+      gzname = (char *)MALLOC(namelen + 4);
+      if (gzname == NULL) return(0);
+      sprintf(gzname, "%s.gz", filename);
+      gzoutfile = gzopen(gzname, "wb");
+      FREE(gzname);
+      return (gzoutfile != NULL);
+    }
+    if (namelen >= 3 && !strcmp(filename + namelen - 3, ".gz")) {
+      gzoutfile = gzopen(filename, "wb");
+      return (gzoutfile != NULL);
+    }
+#endif
     outfile = fopen(filename, "w");
     return (outfile != NULL);
   }
@@ -179,8 +319,26 @@ int OpenFile(char *filename, int linelen)
 
 void CloseFile(char *filename)
 {
-	if (strlen(filename) > 0) 
-		fclose(outfile);
+  /* anything left in the line buffer has no newline; write it as is */
+  if (bufferlen) WriteOutput(buffer, bufferlen);
+  bufferlen = 0;
+  DrainOutput();
+  if (outbuf != NULL) {
+    FREE(outbuf);
+    outbuf = NULL;
+  }
+
+#ifdef HAVE_ZLIB
+  if (gzoutfile != NULL) {
+    gzclose(gzoutfile);
+    gzoutfile = NULL;
+    return;
+  }
+#endif
+  if (strlen(filename) > 0) 
+    fclose(outfile);
+  else
+    fflush(outfile);
 }
 
 /* STUFF TO READ INPUT FILES */
@@ -191,21 +349,81 @@ static int  linesize = 0;	/* amount of memory allocated for line */
 static int  linenum;
 char	*nexttok;
 static FILE *infile = NULL;
+static int  inpid = 0;		/* decompressor feeding infile, or 0 */
 
 /* For purposes of having "include" files, keep a stack of the open	*/
 /* files.								*/
 
 struct filestack {
    FILE *file;
+   int pid;
    struct filestack *next;
 };
 
 static struct filestack *OpenFiles = NULL;
+static int ParseFailed = 0;	/* a file in the stack was not read in full */
 
 struct hashdict *definitions = (struct hashdict *)NULL;
 
 #define WHITESPACE_DELIMITER " \t\n\r"
 
+/*----------------------------------------------------------------------*/
+/* Replay cache for verilog generate loops.  TellFile() marks the start	*/
+/* of a loop body, and the lines that follow are saved (after `define	*/
+/* substitution) as they are read.  When SeekFile() returns to the	*/
+/* marked position, the saved lines are replayed from memory instead	*/
+/* of being read and substituted again.  Reading returns to the file	*/
+/* when the replay runs past the last saved line.  The loop variable	*/
+/* itself is evaluated by the parser, so the saved text does not	*/
+/* depend on it.							*/
+/*----------------------------------------------------------------------*/
+
+struct loopline {
+   char *text;		/* line after `define substitution */
+   long endpos;		/* file position following the line */
+};
+
+static struct loopline *LoopLines = NULL;
+static int  LoopLinesCount = 0;		/* number of lines saved */
+static int  LoopLinesMax = 0;		/* number of lines allocated */
+static long LoopStart = -1;		/* file position of first line */
+static FILE *LoopFile = NULL;		/* file being saved, or NULL */
+static int  LoopRecording = 0;		/* saving lines as they are read */
+static int  LoopReplay = -1;		/* next line to replay, or -1 */
+
+static void FreeLoopLines(void)
+{
+    int i;
+
+    for (i = 0; i < LoopLinesCount; i++) FREE(LoopLines[i].text);
+    if (LoopLines != NULL) FREE(LoopLines);
+    LoopLines = NULL;
+    LoopLinesCount = LoopLinesMax = 0;
+    LoopStart = -1;
+    LoopFile = NULL;
+    LoopRecording = 0;
+    LoopReplay = -1;
+}
+
+static void RecordLoopLine(char *text)
+{
+    struct loopline *newlines;
+
+    if (LoopLinesCount == LoopLinesMax) {
+	LoopLinesMax = (LoopLinesMax == 0) ? 64 : 2 * LoopLinesMax;
+	newlines = (struct loopline *)MALLOC(LoopLinesMax *
+			sizeof(struct loopline));
+	if (LoopLines != NULL) {
+	    memcpy(newlines, LoopLines, LoopLinesCount * sizeof(struct loopline));
+	    FREE(LoopLines);
+	}
+	LoopLines = newlines;
+    }
+    LoopLines[LoopLinesCount].text = strsave(text);
+    LoopLines[LoopLinesCount].endpos = ftell(infile);
+    LoopLinesCount++;
+}
+
 /*----------------------------------------------------------------------*/
 /* Seek and Tell on infile stream, for use with handling generate	*/
 /* loops in verilog.							*/
@@ -213,12 +431,34 @@ struct hashdict *definitions = (struct hashdict *)NULL;
 
 void SeekFile(long offset)
 {
+    if ((LoopFile == infile) && (offset == LoopStart) && (LoopLinesCount > 0)) {
+	/* The loop body is complete;  replay it from memory */
+	LoopRecording = 0;
+	LoopReplay = 0;
+	return;
+    }
+    FreeLoopLines();
     fseek(infile, offset, SEEK_SET);
 }
 
 long TellFile()
 {
-    return ftell(infile);
+    long pos;
+
+    /* Position of the next line to be read, which may be in a replay */
+    if (LoopReplay > 0)
+	pos = LoopLines[LoopReplay - 1].endpos;
+    else if (LoopReplay == 0)
+	pos = LoopStart;
+    else
+	pos = ftell(infile);
+
+    FreeLoopLines();
+    fseek(infile, pos, SEEK_SET);
+    LoopStart = pos;
+    LoopFile = infile;
+    LoopRecording = 1;
+    return pos;
 }
 
 /*----------------------------------------------------------------------*/
@@ -305,10 +545,32 @@ int GetNextLineNoNewline(char *delimiter)
     static int nested = 0;
     int llen;
 
-    if (feof(infile)) return -1;
+    if ((LoopReplay < 0) && (feof(infile) || ferror(infile))) return -1;
 
     while (1) {	    /* May loop indefinitely in an `if[n]def conditional */
 
+	if (LoopReplay >= 0) {
+	    if ((LoopFile == infile) && (LoopReplay < LoopLinesCount)) {
+		/* Replay a saved line of a generate loop body */
+		llen = strlen(LoopLines[LoopReplay].text);
+		if (llen >= linesize) {
+		    FREE(line);
+		    FREE(linetok);
+		    linesize = llen + 500;
+		    line = (char *)MALLOC(linesize + 1);
+		    linetok = (char *)MALLOC(linesize + 1);
+		}
+		strcpy(line, LoopLines[LoopReplay].text);
+		strcpy(linetok, line);
+		LoopReplay++;
+		goto replayed;
+	    }
+	    /* Past the end of the saved lines;  continue from the file */
+	    if ((LoopFile == infile) && (LoopLinesCount > 0))
+		fseek(infile, LoopLines[LoopLinesCount - 1].endpos, SEEK_SET);
+	    LoopReplay = -1;
+	}
+
 	// This is more reliable than feof() ...
 	testc = getc(infile);
 	if (testc == -1) return -1;
@@ -432,6 +694,14 @@ int GetNextLineNoNewline(char *delimiter)
 	    }
 	}
 
+	if (LoopRecording) {
+	    if (LoopFile == infile)
+		RecordLoopLine(linetok);
+	    else
+		FreeLoopLines();	/* an included file;  don't save */
+	}
+
+replayed:
 	TrimQuoted(linetok);
 	linenum++;
 
@@ -849,6 +1119,166 @@ void InputParseError(FILE *f)
   Fprintf(f,"'\n");
 }
 
+/*----------------------------------------------------------------------*/
+/* Compressed input.  A file that begins with the gzip or zstd magic	*/
+/* number is decompressed as it is read, so the tokenizer sees the	*/
+/* same text as it would from the uncompressed file.  gzip files are	*/
+/* read through zlib where fopencookie() is available;  otherwise, and	*/
+/* for zstd, the file is piped through "gzip -dc" or "zstd -dc".	*/
+/*----------------------------------------------------------------------*/
+
+#if defined(HAVE_ZLIB) && defined(__GLIBC__)
+#define GZ_COOKIE
+
+static ssize_t GzRead(void *cookie, char *buf, size_t size)
+{
+  int n;
+
+  /* a corrupt or truncated file is a read error on the stream */
+  n = gzread((gzFile)cookie, buf, (unsigned)size);
+  if (n < 0) {
+    errno = EIO;
+    return -1;
+  }
+  return n;
+}
+
+static int GzSeek(void *cookie, off64_t *offset, int whence)
+{
+  z_off_t pos;
+
+  /* zlib cannot seek from the end of the uncompressed data */
+  if (whence == SEEK_END) return -1;
+  pos = gzseek((gzFile)cookie, (z_off_t)(*offset), whence);
+  if (pos < 0) return -1;
+  *offset = pos;
+  return 0;
+}
+
+static int GzClose(void *cookie)
+{
+  /* gzclose() also reports a stream that ended before its trailer */
+  if (gzclose((gzFile)cookie) != Z_OK) {
+    errno = EIO;
+    return EOF;
+  }
+  return 0;
+}
+#endif
+
+static FILE *OpenFilter(char *prog, char *name, int *pid)
+/* return a stream reading the output of "prog -dc name" */
+{
+#ifdef IBMPC
+  return NULL;
+#else
+  int fd[2], i, maxfd;
+  FILE *f;
+
+  if (pipe(fd) < 0) return NULL;
+  *pid = fork();
+  if (*pid < 0) {
+    close(fd[0]);
+    close(fd[1]);
+    *pid = 0;
+    return NULL;
+  }
+  if (*pid == 0) {
+    signal(SIGPIPE, SIG_DFL);
+    close(fd[0]);
+    dup2(fd[1], 1);
+    close(fd[1]);
+    /* do not pass other input files or the server socket to the child */
+    maxfd = (int)sysconf(_SC_OPEN_MAX);
+    if (maxfd < 0) maxfd = 1024;
+    for (i = 3; i < maxfd; i++) close(i);
+    execlp(prog, prog, "-dc", "--", name, (char *)NULL);
+    _exit(127);
+  }
+  close(fd[1]);
+  fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+  f = fdopen(fd[0], "r");
+  if (f == NULL) {
+    close(fd[0]);
+    waitpid(*pid, NULL, 0);
+    *pid = 0;
+  }
+  return f;
+#endif
+}
+
+static int CloseFilter(int pid)
+{
+#ifndef IBMPC
+  int status;
+
+  if (waitpid(pid, &status, 0) < 0) return -1;
+
+  /* A decompressor killed by SIGPIPE was closed early, which is fine */
+  if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+    if (WEXITSTATUS(status) == 127)
+      Fprintf(stderr, "Unable to run the decompressor for input file.\n");
+    else
+      Fprintf(stderr, "Decompression of input file failed.\n");
+    return -1;
+  }
+  if (WIFSIGNALED(status) && WTERMSIG(status) != SIGPIPE) {
+    Fprintf(stderr, "Decompression of input file failed.\n");
+    return -1;
+  }
+#endif
+  return 0;
+}
+
+static FILE *OpenInput(char *name, int *pid)
+{
+  FILE *f;
+  unsigned char magic[4];
+  int n;
+
+  *pid = 0;
+  f = fopen(name, "r");
+  if (f == NULL) return NULL;
+  n = fread(magic, 1, 4, f);
+
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    fclose(f);
+#ifdef GZ_COOKIE
+    {
+      gzFile gz;
+      cookie_io_functions_t gzio = {GzRead, NULL, GzSeek, GzClose};
+
+      gz = gzopen(name, "rb");
+      if (gz == NULL) return NULL;
+      gzbuffer(gz, 1 << 18);
+      f = fopencookie(gz, "r", gzio);
+      if (f == NULL) gzclose(gz);
+      return f;
+    }
+#else
+    return OpenFilter("gzip", name, pid);
+#endif
+  }
+  if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+		magic[3] == 0xfd) {
+    fclose(f);
+    return OpenFilter("zstd", name, pid);
+  }
+  rewind(f);
+  return f;
+}
+
+/* Length of a ".gz" or ".zst" suffix on "name", or 0 */
+
+int CompressedSuffix(char *name)
+{
+  int len = strlen(name);
+
+  if (len > 3 && !strcmp(name + len - 3, ".gz")) return 3;
+  if (len > 4 && !strcmp(name + len - 4, ".zst")) return 4;
+  return 0;
+}
+
 /*----------------------------------------------------------------------*/
 
 int OpenParseFile(char *name, int fnum)
@@ -857,20 +1287,38 @@ int OpenParseFile(char *name, int fnum)
   
   FILE *locfile;
   struct filestack *newfile;
+  int pid;
+
+  locfile = OpenInput(name, &pid);
 
-  locfile = fopen(name, "r");
+  /* If the file does not exist, look for a compressed copy */
+  if (locfile == NULL && CompressedSuffix(name) == 0) {
+     char *zname;
+
+     zname = (char *)MALLOC(strlen(name) + 5);
+     sprintf(zname, "%s.gz", name);
+     locfile = OpenInput(zname, &pid);
+     if (locfile == NULL) {
+	sprintf(zname, "%s.zst", name);
+	locfile = OpenInput(zname, &pid);
+     }
+     FREE(zname);
+  }
   linenum = 0;
   /* reset the token scanner */
   nexttok = NULL;  
 
   if (locfile != NULL) {
-     if (infile != NULL) {
+     if (infile == NULL) ParseFailed = 0;
+     else {
         newfile = (struct filestack *)MALLOC(sizeof(struct filestack));
         newfile->file = infile;
+        newfile->pid = inpid;
         newfile->next = OpenFiles;
         OpenFiles = newfile;
      }
      infile = locfile;
+     inpid = pid;
 
      if (fnum != -1)
 	return fnum;
@@ -882,29 +1330,65 @@ int OpenParseFile(char *name, int fnum)
   return -1;
 }
 
+/* Return the file number that will be given to the next netlist read */
+
+int NextFileNumber(void)
+{
+  return Graph;
+}
+
 int EndParseFile(void)
 {
-  return (feof(infile));
+  if ((LoopReplay >= 0) && (LoopReplay < LoopLinesCount)) return 0;
+  /* a read error also ends the file;  CloseParseFile() reports it */
+  return (feof(infile) || ferror(infile));
 }
 
+/* Return 0, or EOF if this file or any file included from it could not	*/
+/* be read in full (a read error, or a failed decompression).		*/
+
 int CloseParseFile(void)
 {
   struct filestack *lastfile;
   int rval;
-  rval = fclose(infile);
+  if (LoopFile == infile) FreeLoopLines();
+  rval = ferror(infile) ? EOF : 0;
+  if (fclose(infile) != 0) rval = EOF;
+  if (inpid > 0 && CloseFilter(inpid) < 0) rval = EOF;
+  if (rval != 0) ParseFailed = 1;
   infile = (FILE *)NULL;
+  inpid = 0;
 
   /* Pop filestack if not empty */
   lastfile = OpenFiles;
   if (lastfile != NULL) {
      OpenFiles = lastfile->next;
      infile = lastfile->file;
+     inpid = lastfile->pid;
      FREE(lastfile);
   }
+  else if (ParseFailed)
+     rval = EOF;
   
   return rval;
 }
 
+/* Close the file read by one of the netlist readers.  If it could not	*/
+/* be read in full, report the error and discard the cells read, so	*/
+/* that a partial netlist is never compared.  A netlist read into an	*/
+/* existing file number ("fnum" not -1) cannot be told apart from the	*/
+/* cells already there, and is left in place.  Return 0 on success and	*/
+/* -1 if the read failed.						*/
+
+int CloseNetlistFile(char *fname, int fnum, int filenum)
+{
+  if (CloseParseFile() == 0) return 0;
+
+  Fprintf(stderr, "Error reading file %s; netlist discarded.\n", fname);
+  if ((fnum == -1) && (filenum >= 0)) CellDeleteFiles(filenum);
+  return -1;
+}
+
 /*************************** general file reader *******************/
 
 char *ReadNetlist(char *fname, int *fnum)
@@ -957,11 +1441,12 @@ char *ReadNetlist(char *fname, int *fnum)
     };
 #endif /* not mips */
 
-  /* make first pass looking for extension */
+  /* make first pass looking for extension, ignoring ".gz" or ".zst" */
   for (index = 0; formats[index].extension != NULL; index++) {
     int extlen = strlen(formats[index].extension);
-    int flen = strlen(fname);
-    if (!strcmp(fname + flen - extlen, formats[index].extension)) {
+    int flen = strlen(fname) - CompressedSuffix(fname);
+    if (flen >= extlen && !strncmp(fname + flen - extlen,
+		formats[index].extension, extlen)) {
       return (*(formats[index].proc))(fname, fnum);
     }
   }
@@ -971,7 +1456,11 @@ char *ReadNetlist(char *fname, int *fnum)
     strcpy(testname, fname);
     strcat(testname, formats[index].extension);
     if (OpenParseFile(testname, *fnum) >= 0) {
-      CloseParseFile();
+      if (CloseParseFile() != 0) {
+	Printf("ReadNetlist: unable to read file '%s'\n", testname);
+	*fnum = -1;
+	return NULL;
+      }
       return (*(formats[index].proc))(testname, fnum);
     }
   }
@@ -983,7 +1472,11 @@ char *ReadNetlist(char *fname, int *fnum)
     /* SPICE files have many extensions.  Look for first character "*" */
 
     if (fgets(test, 2, infile) == NULL) test[0] = '\0';
-    CloseParseFile();
+    if (CloseParseFile() != 0) {
+      Printf("ReadNetlist: unable to read file '%s'\n", fname);
+      *fnum = -1;
+      return NULL;
+    }
     if (test[0] == '*') {		/* Probably a SPICE deck */
       return ReadSpice(fname, fnum);
     }
@@ -1085,10 +1578,10 @@ char *ReadNetgenFile (char *fname, int *fnum)
     }    
   }
   
-  while (!feof(infile)) {
+  while (!EndParseFile()) {
     char string[400];
     fscanf(infile, "%400s", string);
-    if (feof(infile)) break; /* out of while loop */
+    if (EndParseFile()) break; /* out of while loop */
     if (match(string,"Cell:")) {
       fscanf(infile, "%400s", string);
       CellDef(string, -1);
@@ -1100,7 +1593,7 @@ char *ReadNetgenFile (char *fname, int *fnum)
 	  fscanf(infile,"%400s", string); /* get extra cell name */
 	  break; /* get out of inner while loop */
 	}
-	if (feof(infile)) break; /* something awful happened */
+	if (EndParseFile()) break; /* something awful happened */
 	/* it must be an object */
 	ob = (struct objlist *)CALLOC(1,sizeof(struct objlist));
 	ob->name = strsave(string);
@@ -1128,7 +1621,10 @@ char *ReadNetgenFile (char *fname, int *fnum)
     }
   }
 
-  CloseParseFile();
+  if (CloseNetlistFile(fname, *fnum, filenum) != 0) {
+    *fnum = -1;
+    return NULL;
+  }
   *fnum = filenum;
   return LastCellRead;
 }
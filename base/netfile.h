@@ -30,6 +30,7 @@ extern void FlushString (char *format, ...);
 extern char *SetExtension(char *buffer, char *path, char *extension);
 
 extern int File;
+extern int CompressOutput;	/* write netlists through gzip */
 extern struct hashdict *definitions;
 
 /* input routines */
@@ -47,8 +48,11 @@ extern void SpiceTokNoNewline(void);	/* handles SPICE "+" continuation line */
 extern void SpiceSkipNewLine(void);	/* handles SPICE "+" continuation line */
 extern void InputParseError(FILE *f);
 extern int OpenParseFile(char *name, int fnum);
+extern int CompressedSuffix(char *name);	/* ".gz" or ".zst" */
+extern int NextFileNumber(void);
 extern int EndParseFile(void);
 extern int CloseParseFile(void);
+extern int CloseNetlistFile(char *fname, int fnum, int filenum);
 extern void SeekFile(long offset);	/* handles verilog 'for' loops */
 extern long TellFile();			/* handles verilog 'for' loops */
 
@@ -20,6 +20,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
                 embedded-language specification routines.
 */
 
+#define MEMTAG MEM_CELL	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -28,6 +29,8 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include <string.h>
 #include <strings.h>
 #include <ctype.h>	/* toupper() */
+#include <unistd.h>	/* sysconf() */
+#include <pthread.h>
 #ifdef IBMPC
 #include <alloc.h>
 #endif
@@ -42,6 +45,8 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "netfile.h"
 #include "print.h"
 #include "netcmp.h"
+#include "timing.h"
+#include "memstats.h"
 
 int Debug = 0;
 int VerboseOutput = 1;  /* by default, we get verbose output */
@@ -260,289 +265,624 @@ int TokGetValue(char *estr, struct nlist *parent, struct objlist *parprops,
 }
 
 /*--------------------------------------------------------------*/
-/* Work through the property list of an instance, looking for	*/
-/* properties that are marked as expressions.  For each 	*/
-/* expression, parse and attempt to reduce to a simpler		*/
-/* expression, preferably a single value.  "glob" is TRUE when	*/
-/* reading in a netlist, and substitutions should be made from	*/
-/* the global parameter list.  "glob" is FALSE when elaborating	*/
-/* the netlist, and substitutions should be made from the	*/
-/* property list of the parent.	 If an expression resolves to a	*/
-/* single value, then replace the property type.		*/
+/* Expression compiler.  The same expression strings (e.g.,	*/
+/* "w*nf" or "l+0.01") appear in property lists of many	*/
+/* instances.  Each distinct string is tokenized once into a	*/
+/* flat array of tokens and kept in a cache.  Numerical	*/
+/* constants are converted at compile time, and the remaining	*/
+/* operands are left as parameter names to be resolved for	*/
+/* each instance.						*/
 /*--------------------------------------------------------------*/
 
-int ReduceOneExpression(struct valuelist *kv, struct objlist *parprops,
-        struct nlist *parent, int glob) {
+struct exprtok {
+    int toktype;		/* TOK_DOUBLE, TOK_STRING, or operator	*/
+    int dropnull;		/* Discard operand if unresolved	*/
+    union {
+	double dvalue;
+	char *string;
+    } data;
+};
+
+struct exprcomp {
+    char *text;			/* Original expression string	*/
+    int ntok;			/* Number of tokens		*/
+    int maxtok;			/* Allocated size of tok[]	*/
+    int simple;			/* No IF() construct in expression */
+    struct exprtok *tok;	/* Tokens in expression order	*/
+    struct exprcomp *next;	/* Next entry in hash bin	*/
+};
+
+#define EXPRHASHSIZE	1021
+#define EXPRMAXTOK	64	/* Largest expression evaluated in place */
+#define EXPRMAX		4096	/* Flush the cache beyond this many	*/
+
+static struct exprcomp **exprcache = NULL;
+static int exprcount = 0;
 
-    struct tokstack *expstack, *stackptr, *lptr, *nptr;
-    struct property *kl = NULL;
-    char *estr, *tstr, *sstr;
-    int toktype, functype, result, modified, numlast, savetok;
+/*--------------------------------------------------------------*/
+/* Append a token to a compiled expression			*/
+/*--------------------------------------------------------------*/
+
+static struct exprtok *ExprAddTok(struct exprcomp *ecomp, int toktype)
+{
+    struct exprtok *etok;
+
+    if (ecomp->ntok == ecomp->maxtok) {
+	struct exprtok *newtok;
+
+	ecomp->maxtok = (ecomp->maxtok == 0) ? 8 : (ecomp->maxtok << 1);
+	newtok = (struct exprtok *)CALLOC(ecomp->maxtok, sizeof(struct exprtok));
+	if (ecomp->ntok > 0) {
+	    memcpy(newtok, ecomp->tok, ecomp->ntok * sizeof(struct exprtok));
+	    FREE(ecomp->tok);
+	}
+	ecomp->tok = newtok;
+    }
+    etok = ecomp->tok + ecomp->ntok;
+    ecomp->ntok++;
+    etok->toktype = toktype;
+    etok->dropnull = FALSE;
+    etok->data.string = NULL;
+
+    if ((toktype == TOK_FUNC_IF) || (toktype == TOK_FUNC_THEN) ||
+		(toktype == TOK_FUNC_ELSE))
+	ecomp->simple = FALSE;
+    return etok;
+}
+
+/*--------------------------------------------------------------*/
+/* Append an operand to a compiled expression.  Empty operands	*/
+/* are ignored.  Numerical values are converted immediately;	*/
+/* anything else is saved as a parameter name.  If "dropnull"	*/
+/* is TRUE, then an operand that cannot be resolved to a value	*/
+/* is discarded when the expression is evaluated.		*/
+/*--------------------------------------------------------------*/
+
+static void ExprAddOperand(struct exprcomp *ecomp, char *estr, int dropnull)
+{
+    struct exprtok *etok;
     double dval;
 
-    if (kv->type == PROP_EXPRESSION)
-	expstack = kv->value.stack;
+    if (*estr == '\0') return;
 
-    else if (kv->type == PROP_STRING) {
+    if (StringIsValue(estr)) {
+	if (ConvertStringToFloat(estr, &dval) == 1) {
+	    etok = ExprAddTok(ecomp, TOK_DOUBLE);
+	    etok->data.dvalue = dval;
+	    return;
+	}
+    }
+    etok = ExprAddTok(ecomp, TOK_STRING);
+    etok->data.string = strsave(estr);
+    etok->dropnull = dropnull;
+}
 
-	/* Compile the string into an expression stack */
-	expstack = NULL;
-	estr = kv->value.string;
-	tstr = estr;
+/*--------------------------------------------------------------*/
+/* Tokenize an expression string.  This does not depend on the	*/
+/* context of the instance, so the result can be reused for	*/
+/* every occurrence of the same string.				*/
+/*--------------------------------------------------------------*/
 
-	numlast = 0;
-	while (*tstr != '\0') {
-	    switch(*tstr) {
-		    
-		case '+':
-		    if (numlast == 0) {
-			/* This is part of a number */
-			dval = strtod(estr, &sstr);
-			if (sstr > estr && sstr > tstr) {
-		            tstr = sstr - 1;
-		            numlast = 1;
-			}
-			/* But might not be. . . */
-			if ((dval != 0) || (sstr > estr))
-			   break;
-		    }
-		    /* Not a number, so must be arithmetic */
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_PLUS, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+static struct exprcomp *CompileExpression(char *string)
+{
+    struct exprcomp *ecomp;
+    char *estr, *tstr, *sstr, *buffer;
+    int numlast, savetok, i;
+    double dval;
 
-		case '-':
-		    if (numlast == 0) {
-			/* This is part of a number */
-			dval = strtod(estr, &sstr);
-			if (sstr > estr && sstr > tstr) {
-			    tstr = sstr - 1;
-			    numlast = 1;
-			}
-			/* But might not be. . . */
-			if ((dval != 0) || (sstr > estr))
-			   break;
+    ecomp = (struct exprcomp *)CALLOC(1, sizeof(struct exprcomp));
+    ecomp->text = strsave(string);
+    ecomp->simple = TRUE;
+
+    /* Work on a copy, as the string is broken up in place */
+    buffer = strsave(string);
+    estr = buffer;
+    tstr = estr;
+
+    numlast = 0;
+    while (*tstr != '\0') {
+	switch(*tstr) {
+		    
+	    case '+':
+		if (numlast == 0) {
+		    /* This is part of a number */
+		    dval = strtod(estr, &sstr);
+		    if (sstr > estr && sstr > tstr) {
+			tstr = sstr - 1;
+			numlast = 1;
 		    }
-		    /* Not a number, so must be arithmetic */
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_MINUS, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+		    /* But might not be. . . */
+		    if ((dval != 0) || (sstr > estr))
+			break;
+		}
+		/* Not a number, so must be arithmetic */
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_PLUS);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
 
-		case '1': case '2': case '3': case '4': case '5':
-		case '6': case '7': case '8': case '9': case '0':
-		    /* Numerical value.  Use strtod() to capture */
-		    if (numlast == 1) break;
+	    case '-':
+		if (numlast == 0) {
+		    /* This is part of a number */
 		    dval = strtod(estr, &sstr);
 		    if (sstr > estr && sstr > tstr) {
 			tstr = sstr - 1;
 			numlast = 1;
 		    }
-		    break;
+		    /* But might not be. . . */
+		    if ((dval != 0) || (sstr > estr))
+			break;
+		}
+		/* Not a number, so must be arithmetic */
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_MINUS);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '1': case '2': case '3': case '4': case '5':
+	    case '6': case '7': case '8': case '9': case '0':
+		/* Numerical value.  Use strtod() to capture */
+		if (numlast == 1) break;
+		dval = strtod(estr, &sstr);
+		if (sstr > estr && sstr > tstr) {
+		    tstr = sstr - 1;
+		    numlast = 1;
+		}
+		break;
+
+	    case '/':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_DIVIDE);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '*':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_MULTIPLY);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '(':
+		*tstr = '\0';
+
+		/* Check for predefined function keywords */
+
+		if (!strcmp(estr, "IF")) {
+		    ExprAddTok(ecomp, TOK_FUNC_IF);
+		}
+		else {
+		    /* Treat as a parenthetical grouping */
+		    ExprAddOperand(ecomp, estr, FALSE);
+		    ExprAddTok(ecomp, TOK_FUNC_OPEN);
+		}
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case ')':
+		*tstr = '\0';
+
+		if (ecomp->ntok == 0) break;
+		savetok = ecomp->tok[ecomp->ntok - 1].toktype;
+
+		ExprAddOperand(ecomp, estr, FALSE);
+
+		switch (savetok) {
+		    case TOK_FUNC_THEN:
+			ExprAddTok(ecomp, TOK_FUNC_ELSE);
+			break;
+		    default:
+			ExprAddTok(ecomp, TOK_FUNC_CLOSE);
+			break;
+		}
+		numlast = 1;
+		estr = tstr + 1;
+		break;
 
-		case '/':
+	    case '\'':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_SGL_QUOTE);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '"':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_DBL_QUOTE);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '{':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		ExprAddTok(ecomp, TOK_GROUP_OPEN);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case '}':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, TRUE);
+		ExprAddTok(ecomp, TOK_GROUP_CLOSE);
+		estr = tstr + 1;
+		numlast = 1;
+		break;
+
+	    case '!':
+		if (*(tstr + 1) == '=') {
 		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_DIVIDE, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+		    ExprAddOperand(ecomp, estr, FALSE);
+		    ExprAddTok(ecomp, TOK_NE);
+		}
+		numlast = 0;
+		break;
 
-		case '*':
+	    case '=':
+		if (*(tstr + 1) == '=') {
 		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_MULTIPLY, NULL, &expstack);
-		    estr = tstr + 1;
+		    ExprAddOperand(ecomp, estr, FALSE);
+		    ExprAddTok(ecomp, TOK_EQ);
 		    numlast = 0;
-		    break;
+		}
+		break;
 
-		case '(':
-		    *tstr = '\0';
+	    case '>':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
 
-		    /* Check for predefined function keywords */
+		if (*(tstr + 1) == '=') {
+		    ExprAddTok(ecomp, TOK_GE);
+		    tstr++;
+		}
+		else
+		    ExprAddTok(ecomp, TOK_GT);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
 
-		    if (!strcmp(estr, "IF")) {
-			PushTok(TOK_FUNC_IF, NULL, &expstack);
+	    case '<':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+
+		if (*(tstr + 1) == '=') {
+		    ExprAddTok(ecomp, TOK_LE);
+		    tstr++;
+		}
+		else
+		    ExprAddTok(ecomp, TOK_LT);
+		estr = tstr + 1;
+		numlast = 0;
+		break;
+
+	    case ',':
+		*tstr = '\0';
+		ExprAddOperand(ecomp, estr, FALSE);
+		if (ecomp->ntok == 0) break;
+		for (i = ecomp->ntok - 2; i >= 0; i--) {
+		    if (ecomp->tok[i].toktype == TOK_FUNC_THEN) {
+			ExprAddTok(ecomp, TOK_FUNC_ELSE);
+			break;
 		    }
-		    else {
-		        /* Treat as a parenthetical grouping */
-
-		        result = TokGetValue(estr, parent, parprops,
-				glob, &dval);
-		        if (result == 1)
-			    PushTok(TOK_DOUBLE, &dval, &expstack);
-		        else if (result == -1)
-			    PushTok(TOK_STRING, estr, &expstack);
-		        PushTok(TOK_FUNC_OPEN, NULL, &expstack);
+		    else if (ecomp->tok[i].toktype == TOK_FUNC_IF) {
+			ExprAddTok(ecomp, TOK_FUNC_THEN);
+			break;
 		    }
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+		}
+		estr = tstr + 1;
+		numlast = 0;
+		break;
 
-		case ')':
-		    *tstr = '\0';
+	    default:
+		break;
+	}
+	tstr++;
+    }
+    ExprAddOperand(ecomp, estr, FALSE);
 
-		    if (expstack == NULL) break;
-		    savetok = expstack->toktype;
+    FREE(buffer);
+    return ecomp;
+}
 
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
+/*--------------------------------------------------------------*/
+/* Return the compiled form of an expression string, compiling	*/
+/* and caching it if it has not been seen before.  The cache is	*/
+/* always case-sensitive, since unresolved parameter names are	*/
+/* copied back into the property value.  The cache holds at	*/
+/* most EXPRMAX expressions, and is emptied when full, so that	*/
+/* reading many netlists does not grow it without bound.	*/
+/*--------------------------------------------------------------*/
 
-		    switch (savetok) {
-			case TOK_FUNC_THEN:
-			    PushTok(TOK_FUNC_ELSE, NULL, &expstack);
-			    break;
-			default:
-			    PushTok(TOK_FUNC_CLOSE, NULL, &expstack);
-			    break;
-		    }
-		    numlast = 1;
-		    estr = tstr + 1;
-		    break;
+static struct exprcomp *LookupExpression(char *string)
+{
+    struct exprcomp *ecomp;
+    unsigned long hashval;
 
-		case '\'':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_SGL_QUOTE, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+    if (exprcache == NULL)
+	exprcache = (struct exprcomp **)CALLOC(EXPRHASHSIZE,
+			sizeof(struct exprcomp *));
 
-		case '"':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_DBL_QUOTE, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+    hashval = hashcase(string, EXPRHASHSIZE);
+    for (ecomp = exprcache[hashval]; ecomp != NULL; ecomp = ecomp->next)
+	if (!strcmp(ecomp->text, string)) return ecomp;
 
-		case '{':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    PushTok(TOK_GROUP_OPEN, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+    if (exprcount >= EXPRMAX) {
+	FreeExpressionCache();
+	exprcache = (struct exprcomp **)CALLOC(EXPRHASHSIZE,
+			sizeof(struct exprcomp *));
+    }
 
-		case '}':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    PushTok(TOK_GROUP_CLOSE, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 1;
-		    break;
+    ecomp = CompileExpression(string);
+    ecomp->next = exprcache[hashval];
+    exprcache[hashval] = ecomp;
+    exprcount++;
+    return ecomp;
+}
 
-		case '!':
-		    if (*(tstr + 1) == '=') {
-			*tstr = '\0';
-			result = TokGetValue(estr, parent, parprops,
-				glob, &dval);
-			if (result == 1)
-			    PushTok(TOK_DOUBLE, &dval, &expstack);
-			else if (result == -1)
-			    PushTok(TOK_STRING, estr, &expstack);
-			PushTok(TOK_NE, NULL, &expstack);
-		    }
-		    numlast = 0;
-		    break;
+/*--------------------------------------------------------------*/
+/* Free all compiled expressions.				*/
+/*--------------------------------------------------------------*/
 
-		case '=':
-		    if (*(tstr + 1) == '=') {
- 			*tstr = '\0';
- 			result = TokGetValue(estr, parent, parprops,
-					glob, &dval);
- 			if (result == 1)
-			    PushTok(TOK_DOUBLE, &dval, &expstack);
- 			else if (result == -1)
-			    PushTok(TOK_STRING, estr, &expstack);
-			PushTok(TOK_EQ, NULL, &expstack);
-			numlast = 0;
-		    }
-		    break;
+void FreeExpressionCache(void)
+{
+    struct exprcomp *ecomp, *enext;
+    int i, j;
+
+    if (exprcache == NULL) return;
+
+    for (i = 0; i < EXPRHASHSIZE; i++) {
+	for (ecomp = exprcache[i]; ecomp != NULL; ecomp = enext) {
+	    enext = ecomp->next;
+	    for (j = 0; j < ecomp->ntok; j++)
+		if (ecomp->tok[j].toktype == TOK_STRING)
+		    FREE(ecomp->tok[j].data.string);
+	    if (ecomp->tok) FREE(ecomp->tok);
+	    FREE(ecomp->text);
+	    FREE(ecomp);
+	}
+    }
+    FREE(exprcache);
+    exprcache = NULL;
+    exprcount = 0;
+}
 
-		case '>':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
+/*--------------------------------------------------------------*/
+/* Evaluate a compiled expression in the context of an		*/
+/* instance, without allocating memory.  This is the same	*/
+/* reduction done by ReduceOneExpression() on the token stack,	*/
+/* but on a fixed array linked by index.  Return 1 and set	*/
+/* "dval" if the expression reduces to a single value.  Return	*/
+/* 0 if it does not (unresolved parameters, IF() constructs,	*/
+/* or an expression too large to handle in place), in which	*/
+/* case the caller must do the full reduction.			*/
+/*--------------------------------------------------------------*/
 
-		    if (*(tstr + 1) == '=') {
-			PushTok(TOK_GE, NULL, &expstack);
-			tstr++;
-		    }
-		    else
-			PushTok(TOK_GT, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+static int EvalExpression(struct exprcomp *ecomp, struct objlist *parprops,
+	struct nlist *parent, int glob, double *dval)
+{
+    int toktype[EXPRMAXTOK];
+    double value[EXPRMAXTOK];
+    int left[EXPRMAXTOK], right[EXPRMAXTOK];
+    int i, l, r, first, modified;
+
+    if (!ecomp->simple || ecomp->ntok == 0 || ecomp->ntok > EXPRMAXTOK)
+	return 0;
+
+    for (i = 0; i < ecomp->ntok; i++) {
+	toktype[i] = ecomp->tok[i].toktype;
+	if (toktype[i] == TOK_DOUBLE)
+	    value[i] = ecomp->tok[i].data.dvalue;
+	else if (toktype[i] == TOK_STRING) {
+	    if (TokGetValue(ecomp->tok[i].data.string, parent, parprops,
+			glob, &value[i]) != 1)
+		return 0;
+	    toktype[i] = TOK_DOUBLE;
+	}
+	left[i] = i - 1;
+	right[i] = (i == ecomp->ntok - 1) ? -1 : i + 1;
+    }
+    first = 0;
 
-		case '<':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
+    modified = 1;
+    while (modified) {
+	modified = 0;
 
-		    if (*(tstr + 1) == '=') {
-			PushTok(TOK_LE, NULL, &expstack);
-			tstr++;
-		    }
-		    else
-			PushTok(TOK_LT, NULL, &expstack);
-		    estr = tstr + 1;
-		    numlast = 0;
-		    break;
+	// Reduce conditionals, then (value) * (value) and (value) / (value),
+	// then (value) + (value) and (value) - (value)
 
-		case ',':
-		    *tstr = '\0';
-		    result = TokGetValue(estr, parent, parprops, glob, &dval);
-		    if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-		    else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
-		    if (expstack == NULL) break;
-		    lptr = expstack;
-		    while (lptr->next) {
-			lptr = lptr->next;
-			if (lptr->toktype == TOK_FUNC_THEN) {
-			    PushTok(TOK_FUNC_ELSE, NULL, &expstack);
-			    break;
-			}
-			else if (lptr->toktype == TOK_FUNC_IF) {
-			    PushTok(TOK_FUNC_THEN, NULL, &expstack);
-			    break;
-			}
-		    }
-		    estr = tstr + 1;
-		    numlast = 0;
+	for (i = first; i >= 0; i = right[i]) {
+	    l = left[i];
+	    r = right[i];
+	    if (l < 0 || r < 0) continue;
+	    if (toktype[l] != TOK_DOUBLE || toktype[r] != TOK_DOUBLE) continue;
+	    switch (toktype[i]) {
+		case TOK_LE:
+		    value[i] = (value[l] <= value[r]) ? 1.0 : 0.0;
 		    break;
-
-		default:
+		case TOK_LT:
+		    value[i] = (value[l] < value[r]) ? 1.0 : 0.0;
+		    break;
+		case TOK_GE:
+		    value[i] = (value[l] >= value[r]) ? 1.0 : 0.0;
+		    break;
+		case TOK_GT:
+		    value[i] = (value[l] > value[r]) ? 1.0 : 0.0;
+		    break;
+		case TOK_EQ:
+		    value[i] = (value[l] == value[r]) ? 1.0 : 0.0;
 		    break;
+		case TOK_NE:
+		    value[i] = (value[l] != value[r]) ? 1.0 : 0.0;
+		    break;
+		default:
+		    continue;
 	    }
-	    tstr++;
+	    modified = 1;
+	    toktype[i] = TOK_DOUBLE;
+	    left[i] = left[l];
+	    if (left[l] >= 0) right[left[l]] = i;
+	    else first = i;
+	    right[i] = right[r];
+	    if (right[r] >= 0) left[right[r]] = i;
+	}
+
+	for (i = first; i >= 0; i = right[i]) {
+	    l = left[i];
+	    r = right[i];
+	    if (l < 0 || r < 0) continue;
+	    if (toktype[l] != TOK_DOUBLE || toktype[r] != TOK_DOUBLE) continue;
+	    if (toktype[i] == TOK_MULTIPLY)
+		value[i] = value[l] * value[r];
+	    else if (toktype[i] == TOK_DIVIDE)
+		value[i] = value[l] / value[r];
+	    else
+		continue;
+	    modified = 1;
+	    toktype[i] = TOK_DOUBLE;
+	    left[i] = left[l];
+	    if (left[l] >= 0) right[left[l]] = i;
+	    else first = i;
+	    right[i] = right[r];
+	    if (right[r] >= 0) left[right[r]] = i;
+	}
+
+	for (i = first; i >= 0; i = right[i]) {
+	    l = left[i];
+	    r = right[i];
+	    if (l < 0 || r < 0) continue;
+	    if (toktype[l] != TOK_DOUBLE || toktype[r] != TOK_DOUBLE) continue;
+	    if (toktype[i] == TOK_PLUS)
+		value[i] = value[l] + value[r];
+	    else if (toktype[i] == TOK_MINUS)
+		value[i] = value[l] - value[r];
+	    else
+		continue;
+	    modified = 1;
+	    toktype[i] = TOK_DOUBLE;
+	    left[i] = left[l];
+	    if (left[l] >= 0) right[left[l]] = i;
+	    else first = i;
+	    right[i] = right[r];
+	    if (right[r] >= 0) left[right[r]] = i;
+	}
+
+	// Reduce {value}, (value), and 'value'
+
+	for (i = first; i >= 0; i = right[i]) {
+	    if (toktype[i] != TOK_DOUBLE) continue;
+	    l = left[i];
+	    r = right[i];
+	    if (l < 0 || r < 0) continue;
+	    if (((toktype[l] == TOK_FUNC_OPEN) && (toktype[r] == TOK_FUNC_CLOSE))
+		    || ((toktype[l] == TOK_GROUP_OPEN) &&
+			(toktype[r] == TOK_GROUP_CLOSE))
+		    || ((toktype[l] == TOK_DBL_QUOTE) &&
+			(toktype[r] == TOK_DBL_QUOTE))
+		    || ((toktype[l] == TOK_SGL_QUOTE) &&
+			(toktype[r] == TOK_SGL_QUOTE))) {
+		modified = 1;
+		left[i] = left[l];
+		if (left[l] >= 0) right[left[l]] = i;
+		else first = i;
+		right[i] = right[r];
+		if (right[r] >= 0) left[right[r]] = i;
+	    }
+	}
+    }
+
+    if ((right[first] < 0) && (toktype[first] == TOK_DOUBLE)) {
+	*dval = value[first];
+	return 1;
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------*/
+/* Generate the expression stack for a compiled expression in	*/
+/* the context of an instance, substituting parameter values	*/
+/* where they are known.					*/
+/*--------------------------------------------------------------*/
+
+static struct tokstack *ExpandExpression(struct exprcomp *ecomp,
+	struct objlist *parprops, struct nlist *parent, int glob)
+{
+    struct tokstack *expstack = NULL;
+    struct exprtok *etok;
+    double dval;
+    int i, result;
+
+    for (i = 0; i < ecomp->ntok; i++) {
+	etok = ecomp->tok + i;
+	switch (etok->toktype) {
+	    case TOK_DOUBLE:
+		PushTok(TOK_DOUBLE, &etok->data.dvalue, &expstack);
+		break;
+	    case TOK_STRING:
+		result = TokGetValue(etok->data.string, parent, parprops,
+			glob, &dval);
+		if (result == 1)
+		    PushTok(TOK_DOUBLE, &dval, &expstack);
+		else if ((result == -1) && (etok->dropnull == FALSE))
+		    PushTok(TOK_STRING, etok->data.string, &expstack);
+		break;
+	    default:
+		PushTok(etok->toktype, NULL, &expstack);
+		break;
+	}
+    }
+    return expstack;
+}
+
+/*--------------------------------------------------------------*/
+/* Work through the property list of an instance, looking for	*/
+/* properties that are marked as expressions.  For each 	*/
+/* expression, parse and attempt to reduce to a simpler		*/
+/* expression, preferably a single value.  "glob" is TRUE when	*/
+/* reading in a netlist, and substitutions should be made from	*/
+/* the global parameter list.  "glob" is FALSE when elaborating	*/
+/* the netlist, and substitutions should be made from the	*/
+/* property list of the parent.	 If an expression resolves to a	*/
+/* single value, then replace the property type.		*/
+/*--------------------------------------------------------------*/
+
+int ReduceOneExpression(struct valuelist *kv, struct objlist *parprops,
+        struct nlist *parent, int glob) {
+
+    struct tokstack *expstack, *stackptr, *lptr, *nptr;
+    struct exprcomp *ecomp;
+    int result, modified;
+    double dval;
+
+    if (kv->type == PROP_EXPRESSION)
+	expstack = kv->value.stack;
+
+    else if (kv->type == PROP_STRING) {
+
+	/* Find or create the compiled form of the string */
+	ecomp = LookupExpression(kv->value.string);
+
+	/* Quick evaluation for the common case of an expression	*/
+	/* that reduces to a single value.				*/
+
+	if (EvalExpression(ecomp, parprops, parent, glob, &dval) == 1) {
+	    FREE(kv->value.string);
+	    kv->type = PROP_DOUBLE;
+	    kv->value.dval = dval;
+	    return 0;
 	}
-	result = TokGetValue(estr, parent, parprops, glob, &dval);
-	if (result == 1) PushTok(TOK_DOUBLE, &dval, &expstack);
-	else if (result == -1) PushTok(TOK_STRING, estr, &expstack);
+
+	/* Otherwise, generate the expression stack and reduce it */
+	expstack = ExpandExpression(ecomp, parprops, parent, glob);
 
 	FREE(kv->value.string);
 	kv->value.stack = expstack;
@@ -944,6 +1284,113 @@ void SetSeriesCombine(int value)
   RecurseCellHashTable2(SetSeriesCombineFlag, (void *)(&value));
 }
 
+/*----------------------------------------------------------------------*/
+/* Property key index.  Each cell keeps a dense array of its property	*/
+/* records (tc->propindex), and each property record holds its position	*/
+/* in the array (kl->pindex, where zero means "not yet indexed").	*/
+/* Values in instance property lists cache the index of their key	*/
+/* (vl->pindex), so that finding the property record for an instance	*/
+/* value is an array access instead of a hash table lookup on the key	*/
+/* string.  This is separate from kl->idx, which ResolveProperties()	*/
+/* uses to put the properties of two matched cells in the same order.	*/
+/* Indices are assigned on first use and are not reused, so a deleted	*/
+/* property leaves an empty slot.					*/
+/*----------------------------------------------------------------------*/
+
+#define PROPINDEX_MAX	65535
+
+/*----------------------------------------------------------------------*/
+/* Give property kl an index in cell tc.  Return the index, or zero if	*/
+/* the index is full (in which case lookups use the hash table).	*/
+/*----------------------------------------------------------------------*/
+
+static int PropertyIndexAdd(struct nlist *tc, struct property *kl)
+{
+    struct property **newindex;
+
+    if (tc->propcount == 0) tc->propcount = 1;	/* Index 0 is not used */
+    if (tc->propcount >= PROPINDEX_MAX) return 0;
+
+    if (tc->propcount >= tc->propalloc) {
+	tc->propalloc = (tc->propalloc == 0) ? 16 : (tc->propalloc << 1);
+	newindex = (struct property **)CALLOC(tc->propalloc,
+			sizeof(struct property *));
+	if (tc->propindex != NULL) {
+	    memcpy(newindex, tc->propindex,
+			tc->propcount * sizeof(struct property *));
+	    FREE(tc->propindex);
+	}
+	tc->propindex = newindex;
+    }
+    kl->pindex = tc->propcount;
+    tc->propindex[tc->propcount++] = kl;
+    return kl->pindex;
+}
+
+/*----------------------------------------------------------------------*/
+/* Free the property index of a cell.  This must be done whenever all	*/
+/* properties of the cell are removed.					*/
+/*----------------------------------------------------------------------*/
+
+void FreePropertyIndex(struct nlist *tc)
+{
+    if (tc->propindex != NULL) FREE(tc->propindex);
+    tc->propindex = NULL;
+    tc->propcount = 0;
+    tc->propalloc = 0;
+}
+
+/*----------------------------------------------------------------------*/
+/* Give every property of cell tc an index, so that PropertyLookup()	*/
+/* no longer modifies the cell and may be called from several threads	*/
+/* at once.  Return the number of string properties that have no	*/
+/* default value yet, which SetPropertyDefault() would fill in from	*/
+/* whichever instance is checked first.					*/
+/*----------------------------------------------------------------------*/
+
+int PropertyIndexCell(struct nlist *tc)
+{
+    struct hashlist *he;
+    struct property *kl;
+    int i, unset = 0;
+
+    for (i = 0; i < tc->propdict.hashsize; i++) {
+	for (he = tc->propdict.hashtab[i]; he != NULL; he = he->next) {
+	    kl = (struct property *)he->ptr;
+	    if (kl == NULL) continue;
+	    if (kl->pindex == 0) PropertyIndexAdd(tc, kl);
+	    if (kl->type == PROP_STRING && kl->pdefault.string == NULL)
+		unset++;
+	}
+    }
+    return unset;
+}
+
+/*----------------------------------------------------------------------*/
+/* Find the property record in cell tc corresponding to the key of the	*/
+/* instance value vl.  This is equivalent to a HashLookup() of vl->key	*/
+/* in tc->propdict, but uses the index cached in vl when available.	*/
+/*----------------------------------------------------------------------*/
+
+struct property *PropertyLookup(struct nlist *tc, struct valuelist *vl)
+{
+    struct property *kl;
+
+    if (vl->key == NULL) return NULL;
+
+    if ((vl->pindex > 0) && (vl->pindex < tc->propcount)) {
+	kl = tc->propindex[vl->pindex];
+	if ((kl != NULL) && (*matchfunc)(kl->key, vl->key)) return kl;
+    }
+
+    kl = (struct property *)HashLookup(vl->key, &(tc->propdict));
+    if (kl != NULL) {
+	if (kl->pindex == 0) PropertyIndexAdd(tc, kl);
+	vl->pindex = kl->pindex;
+    }
+    return kl;
+}
+
 /*----------------------------------------------------------------------*/
 /* Delete a property from the master cell record.			*/
 /*----------------------------------------------------------------------*/
@@ -973,10 +1420,13 @@ PropertyDelete(char *name, int fnum, char *key)
 	RecurseHashTable(&(tc->propdict), freeprop);
 	HashKill(&(tc->propdict));
 	InitializeHashTable(&(tc->propdict), OBJHASHSIZE);
+	FreePropertyIndex(tc);
     }
     else {
 	kl = (struct property *)HashLookup(key, &(tc->propdict));
 	if (kl != NULL) {
+	    if ((kl->pindex > 0) && (kl->pindex < tc->propcount))
+		tc->propindex[kl->pindex] = NULL;
 	    if (kl->type == PROP_STRING || kl->type == PROP_EXPRESSION)
 		FREE(kl->pdefault.string);
 	    FREE(kl->key);
@@ -1323,6 +1773,186 @@ void CellDef(char *name, int fnum)
     if (matchfunc == matchnocase) CurrentCell->flags |= CELL_NOCASE;
 }
 
+/*----------------------------------------------------------------------*/
+/* Copy cell tl into file fnum under the name "name", along with any	*/
+/* of its subcells that are not already defined there.  Used to give a	*/
+/* netlist its own, modifiable copy of a read-only library cell.	*/
+/* Returns the new cell.						*/
+/*----------------------------------------------------------------------*/
+
+static struct nlist *CopyCellToFile(struct nlist *tl, char *name, int fnum)
+{
+    struct nlist *tp, *tsub;
+    struct objlist *ob, *pob;
+    struct property *kl, *klnew;
+    struct Permutation *perm, *newperm;
+
+    /* Copy subcells first, so that the instances below find them */
+    for (ob = tl->cell; ob != NULL; ob = ob->next) {
+	if (ob->type != FIRSTPIN) continue;
+	if (LookupCellFile(ob->model.class, fnum) != NULL) continue;
+	tsub = LookupCellFile(ob->model.class, tl->file);
+	if (tsub != NULL) CopyCellToFile(tsub, tsub->name, fnum);
+    }
+
+    tp = InstallInCellHashTable(name, fnum);
+    if (tp == NULL) return NULL;
+    tp->class = tl->class;
+    tp->flags = tl->flags & ~(CELL_LIBRARY | CELL_TOP | CELL_MATCHED |
+		CELL_PROPSMATCHED);
+    tp->classhash = tl->classhash;
+
+    tp->cell = CopyObjList(tl->cell, 1);
+    for (ob = tp->cell; ob != NULL; ob = ob->next) {
+	if (ob->type == PROPERTY) continue;
+	HashPtrInstall(ob->name, ob, &(tp->objdict));
+	if (ob->type == FIRSTPIN) {
+	    HashPtrInstall(ob->instance.name, ob, &(tp->instdict));
+	    tsub = LookupCellFile(ob->model.class, fnum);
+	    if (tsub != NULL) tsub->number++;
+	}
+    }
+
+    /* Pin names in permutations and properties point to port names */
+
+    for (perm = tl->permutes; perm != NULL; perm = perm->next) {
+	newperm = (struct Permutation *)CALLOC(1, sizeof(struct Permutation));
+	pob = LookupObject(perm->pin1, tp);
+	newperm->pin1 = (pob) ? pob->name : NULL;
+	pob = LookupObject(perm->pin2, tp);
+	newperm->pin2 = (pob) ? pob->name : NULL;
+	newperm->next = tp->permutes;
+	tp->permutes = newperm;
+    }
+
+    for (kl = (struct property *)HashFirst(&(tl->propdict)); kl != NULL;
+		kl = (struct property *)HashNext(&(tl->propdict))) {
+	klnew = NewProperty();
+	klnew->key = strsave(kl->key);
+	klnew->idx = 0;
+	klnew->type = kl->type;
+	klnew->merge = kl->merge;
+	klnew->slop = kl->slop;
+	if (kl->type == PROP_STRING)
+	    klnew->pdefault.string = (kl->pdefault.string) ?
+			strsave(kl->pdefault.string) : NULL;
+	else if (kl->type == PROP_EXPRESSION)
+	    klnew->pdefault.stack = CopyTokStack(kl->pdefault.stack);
+	else
+	    klnew->pdefault = kl->pdefault;
+	if (kl->pin != NULL) {
+	    pob = LookupObject(kl->pin, tp);
+	    klnew->pin = (pob) ? pob->name : NULL;
+	}
+	HashPtrInstall(klnew->key, klnew, &(tp->propdict));
+    }
+    return tp;
+}
+
+/*----------------------------------------------------------------------*/
+/* After reading a netlist into file fnum, replace each placeholder	*/
+/* (a call to a subcircuit that the netlist never defined) with a copy	*/
+/* of the library cell of the same name, if there is one.		*/
+/*									*/
+/* A placeholder with pins "1", "2", ... was created from a positional	*/
+/* (SPICE) call, and the caller must rename the pins of its instances	*/
+/* afterwards.  Returns the number of such cells replaced.  Pins of a	*/
+/* placeholder with named pins (verilog) are matched by name.		*/
+/*----------------------------------------------------------------------*/
+
+static struct nlist **PlaceList;
+static int PlaceCount;
+
+static int listplaceholders(struct hashlist *p, int fnum)
+{
+    struct nlist *ptr;
+
+    ptr = (struct nlist *)(p->ptr);
+    if ((ptr->file == fnum) && (ptr->flags & CELL_PLACEHOLDER) &&
+		(LookupLibraryCell(ptr->name, NULL) != NULL)) {
+	if (PlaceList != NULL) PlaceList[PlaceCount] = ptr;
+	PlaceCount++;
+    }
+    return 1;
+}
+
+int ResolveLibraryCells(int fnum)
+{
+    struct nlist *tp, *tl, *tplace, *savecircuit1, *savecircuit2;
+    struct NodeClass *saveclasses;
+    struct objlist *ob;
+    struct printcapture pc;
+    char *name, pname[12];
+    int i, j, numcells, numlibs, result, renamed = 0;
+
+    PlaceList = NULL;
+    PlaceCount = 0;
+    RecurseCellFileHashTable(listplaceholders, fnum);
+    if (PlaceCount == 0) return 0;
+
+    numcells = PlaceCount;
+    PlaceList = (struct nlist **)CALLOC(numcells, sizeof(struct nlist *));
+    PlaceCount = 0;
+    RecurseCellFileHashTable(listplaceholders, fnum);
+
+    for (i = 0; i < numcells; i++) {
+	tp = PlaceList[i];
+	tl = LookupLibraryCell(tp->name, &numlibs);
+	name = strsave(tp->name);
+	Printf("Using library cell %s for undefined subcircuit.\n", name);
+	if (numlibs > 1)
+	    Fprintf(stderr, "Warning:  cell %s is defined in %d libraries; "
+			"using the one read first (file %d).\n", name,
+			numlibs, tl->file);
+
+	j = 1;
+	for (ob = tp->cell; ob && ob->type == PORT; ob = ob->next) {
+	    sprintf(pname, "%d", j);
+	    if (!matchnocase(ob->name, pname)) break;
+	    j++;
+	}
+	if (tp == CurrentCell) CurrentCell = NULL;
+	if ((ob == NULL) || (ob->type != PORT)) {
+	    /* Positional placeholder:  pins are in the library order */
+	    CellDelete(name, fnum);
+	    FREE(tp);
+	    CopyCellToFile(tl, name, fnum);
+	    renamed++;
+	}
+	else {
+	    /* Named pins:  match the placeholder against the library	*/
+	    /* cell and reorder the pins of all instances to suit, as	*/
+	    /* is done for a verilog placeholder in ReadSpiceFile().	*/
+	    /* Pins are matched by name, so any node classes left by	*/
+	    /* an earlier comparison are set aside.  The pin table is	*/
+	    /* shown only if the pins do not match.			*/
+	    tplace = CopyCellToFile(tl, "_PLACEHOLDER_", fnum);
+	    savecircuit1 = Circuit1;
+	    savecircuit2 = Circuit2;
+	    saveclasses = NodeClasses;
+	    Circuit1 = tplace;
+	    Circuit2 = tp;
+	    NodeClasses = NULL;
+	    pc.first = pc.last = NULL;
+	    PrintCaptureStart(&pc);
+	    result = MatchPins(tplace, tp, 0);
+	    PrintCaptureStart(NULL);
+	    PrintCaptureFlush(&pc, (result == 0));
+	    Circuit1 = savecircuit1;
+	    Circuit2 = savecircuit2;
+	    NodeClasses = saveclasses;
+	    FreePortsFile(name, fnum);
+	    CellDelete(name, fnum);
+	    FREE(tp);
+	    CellRehash("_PLACEHOLDER_", name, fnum);
+	}
+	FREE(name);
+    }
+    FREE(PlaceList);
+    PlaceList = NULL;
+    return renamed;
+}
+
 /*----------------------------------------------------------------------*/
 /* Return 0 if class 'name' is not being ignored (per the 'ignore'	*/
 /* command);  1 if it is ignored, and 2 if shorted instances should be	*/
@@ -2815,7 +3445,10 @@ void join(char *node1, char *node2)
 		/* now search through entire list, updating nodes as needed */
 		for (tp3 = CurrentCell->cell; tp3 != NULL; tp3 = tp3->next) 
 			if (tp3->node == oldnode)  tp3->node = nodenum;
+		NodeNameMerge(CurrentCell, nodenum, oldnode);
 	}
+	NodeNameAdd(CurrentCell, tp1);
+	NodeNameAdd(CurrentCell, tp2);
 	if (Debug) Printf("Node = %d)\n",tp1->node);
 }
 
@@ -2974,7 +3607,10 @@ void ConnectAllNodes(char *model, int file)
     if (ob->node >= nodenum) nodenum = ob->node + 1;
 
   for (ob = tp->cell; ob != NULL; ob = ob->next)
-    if (ob->node == -1) ob->node = nodenum++;
+    if (ob->node == -1) {
+      ob->node = nodenum++;
+      NodeNameAdd(tp, ob);
+    }
 }
 
 /*----------------------------------------------------------------------*/
@@ -3068,8 +3704,10 @@ int add_prop_tag(struct objlist *obr, char tagc)
 	    if (kv->type == PROP_ENDLIST)
 	       break;
          }
-	 kv2 = (struct valuelist *)MALLOC((k + 2) * sizeof(struct valuelist));
+	 kv2 = (struct valuelist *)MALLOCTAG((k + 2) *
+		sizeof(struct valuelist), MEM_PROPERTY);
 	 kv2->key = strsave("_tag");
+	 kv2->pindex = 0;
 	 kv2->type = PROP_STRING;
 	 /* Value is set to tagc */
 	 kv2->value.string = (char *)MALLOC(2);
@@ -3198,22 +3836,301 @@ int remove_group_tags(struct objlist *ob)
    return 0;
 }
 
+/*----------------------------------------------------------------------*/
+/* Table of devices used by CombineParallel() to find parallel		*/
+/* combinations.  Devices are keyed by class name and the tuple of node	*/
+/* numbers on their pins.  The table uses open addressing with linear	*/
+/* probing and is sized up front from the number of devices in the	*/
+/* cell, so it never needs to grow.  Node tuples of installed devices	*/
+/* are kept in a single pool and referenced by offset.			*/
+/*----------------------------------------------------------------------*/
+
+#define PAR_NOCONNECT	(-0x7fffffff)	/* Node value of no-connect pins */
+
+/* One device of the cell being combined */
+struct pardev {
+   struct objlist *ob;		/* First pin record of the device */
+   struct nlist *tsub;		/* Cell of the device class */
+   int rep;			/* Earlier device it is parallel to, or -1 */
+   int next;			/* Next device in the same partition, or -1 */
+};
+
+struct pardevice {
+   unsigned long hashval;
+   int dev;			/* Index of device, or -1 if empty */
+   int nodes;			/* Offset of node tuple in pool */
+   int npins;
+};
+
+struct partable {
+   struct pardevice *entries;
+   struct pardev *devs;
+   unsigned long mask;		/* Table size - 1 (size is a power of 2) */
+   int *pool;
+   int poolsize;
+   int poolalloc;
+};
+
+static void ParallelTableInit(struct partable *pt, struct pardev *devs,
+	int ndevices)
+{
+   unsigned long size = 16, h;
+
+   while (size < (unsigned long)ndevices * 2) size <<= 1;
+   pt->entries = (struct pardevice *)MALLOC(size * sizeof(struct pardevice));
+   for (h = 0; h < size; h++) pt->entries[h].dev = -1;
+   pt->devs = devs;
+   pt->mask = size - 1;
+   pt->pool = NULL;
+   pt->poolsize = 0;
+   pt->poolalloc = 0;
+}
+
+static void ParallelTableFree(struct partable *pt)
+{
+   FREE(pt->entries);
+   if (pt->pool != NULL) FREE(pt->pool);
+}
+
+/*----------------------------------------------------------------------*/
+/* Look up device "dev" by class and node tuple.  If an equivalent	*/
+/* device is already in the table, return its index.  Otherwise,	*/
+/* install "dev" under the key and return -1.				*/
+/*----------------------------------------------------------------------*/
+
+static int ParallelFind(struct partable *pt, int dev, int *nodes, int npins)
+{
+   struct pardevice *pd;
+   struct objlist *ob = pt->devs[dev].ob;
+   unsigned long hashval, h;
+   int i;
+
+   hashval = (*hashfunc)(ob->model.class, 0);
+   for (i = 0; i < npins; i++) {
+      hashval ^= (unsigned long)(unsigned int)nodes[i];
+      hashval *= 16777619ul;
+   }
+
+   for (h = hashval & pt->mask; ; h = (h + 1) & pt->mask) {
+      pd = &(pt->entries[h]);
+      if (pd->dev < 0) break;
+      if ((pd->hashval == hashval) && (pd->npins == npins) &&
+		!memcmp(pt->pool + pd->nodes, nodes, npins * sizeof(int)) &&
+		(*matchfunc)(pt->devs[pd->dev].ob->model.class,
+		ob->model.class))
+	 return pd->dev;
+   }
+
+   if (pt->poolsize + npins > pt->poolalloc) {
+      int *newpool;
+
+      pt->poolalloc = (pt->poolalloc == 0) ? 1024 : (pt->poolalloc << 1);
+      while (pt->poolsize + npins > pt->poolalloc) pt->poolalloc <<= 1;
+      newpool = (int *)MALLOC(pt->poolalloc * sizeof(int));
+      if (pt->pool != NULL) {
+	 memcpy(newpool, pt->pool, pt->poolsize * sizeof(int));
+	 FREE(pt->pool);
+      }
+      pt->pool = newpool;
+   }
+   memcpy(pt->pool + pt->poolsize, nodes, npins * sizeof(int));
+
+   pd->hashval = hashval;
+   pd->dev = dev;
+   pd->nodes = pt->poolsize;
+   pd->npins = npins;
+   pt->poolsize += npins;
+   return -1;
+}
+
+/*----------------------------------------------------------------------*/
+/* Finding parallel devices.  Devices are split into partitions by	*/
+/* class, so that devices that may be parallel are always in the same	*/
+/* partition.  For each device, the partition's table gives the first	*/
+/* earlier device with the same key, which is where the device will be	*/
+/* merged.  Since merging does not change the nodes of the device that	*/
+/* remains, this is the same device that a single pass over the cell	*/
+/* would find.  Large cells have their partitions searched on up to	*/
+/* PropertyThreads threads;  the merging itself, which relinks the	*/
+/* object list of the cell, is done afterwards in order.		*/
+/*----------------------------------------------------------------------*/
+
+#define PAR_THREAD_MIN	 20000	/* Fewest devices to search in threads */
+#define PAR_PARTITIONS	 8	/* Partitions per thread */
+
+/* partitions shared by the threads of one search */
+struct parjob {
+   struct pardev *devs;
+   int *head;			/* First device of each partition */
+   int *count;			/* Number of devices in each partition */
+   int nparts;
+   int *nodecount;		/* Uses of each node, for no-connects */
+   int maxpins;
+   int next;			/* Next partition to search */
+   pthread_mutex_t lock;
+   int threaded;
+};
+
+/*----------------------------------------------------------------------*/
+/* Search one partition, setting the "rep" of each of its devices.	*/
+/*----------------------------------------------------------------------*/
+
+static void ParallelSearch(struct parjob *job, int part, int *nodes)
+{
+   struct partable devtable;
+   struct pardev *pdev;
+   struct Permutation *perm;
+   struct objlist *ob, *ob2;
+   char *pname;
+   int d, i, npins, pin1, pin2;
+
+   ParallelTableInit(&devtable, job->devs, job->count[part]);
+
+   for (d = job->head[part]; d >= 0; d = pdev->next) {
+      pdev = &(job->devs[d]);
+      ob = pdev->ob;
+
+      /* NOTE:  This is only set up for a single permutation	*/
+      /* per cell and needs to be expanded to the general	*/
+      /* case.						*/
+
+      if ((pdev->tsub != NULL) && (pdev->tsub->permutes != NULL))
+	 perm = pdev->tsub->permutes;
+      else
+	 perm = NULL;	/* Device has no pin permutations */
+
+      npins = 0;
+      pin1 = pin2 = -1;
+      for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob);
+		ob2 = ob2->next) {
+	 if ((ob2->node >= 0) && (job->nodecount[ob2->node] == 1))
+	    nodes[npins] = PAR_NOCONNECT;
+	 else
+	    nodes[npins] = ob2->node;
+
+	 if (perm != NULL) {
+	    pname = ob2->name + strlen(ob2->instance.name) + 1;
+	    if ((*matchfunc)(perm->pin1, pname))
+	       pin1 = npins;
+	    else if ((*matchfunc)(perm->pin2, pname))
+	       pin2 = npins;
+	 }
+	 npins++;
+      }
+      if ((pin1 >= 0) && (pin2 >= 0) && (nodes[pin1] > nodes[pin2])) {
+	 i = nodes[pin1];
+	 nodes[pin1] = nodes[pin2];
+	 nodes[pin2] = i;
+      }
+      pdev->rep = ParallelFind(&devtable, d, nodes, npins);
+   }
+   ParallelTableFree(&devtable);
+}
+
+static void *ParallelWorker(void *arg)
+/* search partitions of the job until none are left */
+{
+   struct parjob *job = (struct parjob *)arg;
+   int part, *nodes;
+
+   nodes = (int *)MALLOC((job->maxpins + 1) * sizeof(int));
+   while (1) {
+      if (job->threaded) pthread_mutex_lock(&job->lock);
+      part = job->next++;
+      if (job->threaded) pthread_mutex_unlock(&job->lock);
+      if (part >= job->nparts) break;
+      if (job->head[part] >= 0) ParallelSearch(job, part, nodes);
+   }
+   FREE(nodes);
+   return(NULL);
+}
+
+/*----------------------------------------------------------------------*/
+/* Set the "rep" of each of the ndevices devices in "devs".  Devices	*/
+/* with a NULL "ob" are not to be merged and are skipped.		*/
+/*----------------------------------------------------------------------*/
+
+static void ParallelFindAll(struct pardev *devs, int ndevices,
+	int *nodecount, int maxpins)
+{
+   struct parjob job;
+   pthread_t *threads = NULL;
+   int *tail, d, part, nthreads, started;
+
+   nthreads = PropertyThreads;
+   if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if (ndevices < PAR_THREAD_MIN) nthreads = 1;
+   if (nthreads > 1)
+      threads = (pthread_t *)CALLOC(nthreads, sizeof(pthread_t));
+   if (threads == NULL) nthreads = 1;
+
+   job.devs = devs;
+   job.nodecount = nodecount;
+   job.maxpins = maxpins;
+   job.nparts = (nthreads > 1) ? nthreads * PAR_PARTITIONS : 1;
+   job.head = (int *)MALLOC(job.nparts * sizeof(int));
+   job.count = (int *)CALLOC(job.nparts, sizeof(int));
+   tail = (int *)MALLOC(job.nparts * sizeof(int));
+   for (part = 0; part < job.nparts; part++) job.head[part] = tail[part] = -1;
+
+   /* Link the devices of each partition in order */
+   for (d = 0; d < ndevices; d++) {
+      devs[d].rep = -1;
+      devs[d].next = -1;
+      if (devs[d].ob == NULL) continue;
+      if (job.nparts > 1)
+	 part = (int)((*hashfunc)(devs[d].ob->model.class, 0) % job.nparts);
+      else
+	 part = 0;
+      if (tail[part] < 0)
+	 job.head[part] = d;
+      else
+	 devs[tail[part]].next = d;
+      tail[part] = d;
+      job.count[part]++;
+   }
+   FREE(tail);
+
+   job.next = 0;
+   job.threaded = (nthreads > 1);
+   if (job.threaded) {
+      pthread_mutex_init(&job.lock, NULL);
+      MemSetThreaded(TRUE);
+
+      /* the calling thread searches too */
+      started = 0;
+      for (d = 1; d < nthreads; d++)
+	 if (pthread_create(threads + started, NULL, ParallelWorker, &job) == 0)
+	    started++;
+      ParallelWorker(&job);
+      for (d = 0; d < started; d++) pthread_join(threads[d], NULL);
+
+      MemSetThreaded(FALSE);
+      pthread_mutex_destroy(&job.lock);
+      FREE(threads);
+   }
+   else
+      ParallelWorker(&job);
+
+   FREE(job.head);
+   FREE(job.count);
+}
+
 /*----------------------------------------------------------------------*/
 /* Find all devices that are of the same class and check for parallel	*/
 /* combinations, and combine them where found, adjusting property "M"	*/
 /* as needed.								*/
 /*									*/
-/* Procedure:  Hash each cell by the model name and a space-separated	*/
-/* list of node numbers connected to each pin, and the value of the 	*/
-/* property that affects number of devices (if any).  The hash stores	*/
-/* the instance record and property record (if any) of the first cell.	*/
-/* If there is a hash match, then the cell instance gets deleted and	*/
-/* the property M of the instance pointed to in the hash gets		*/
-/* incremented.	 If it has no property M, one is created and the value	*/
-/* set to 2.								*/
+/* Procedure:  Key each cell by the model name and the list of node	*/
+/* numbers connected to each pin.  The table stores the instance	*/
+/* record of the first cell.  If there is a match, then the cell	*/
+/* instance gets deleted and the property M of the instance found in	*/
+/* the table gets incremented.	 If it has no property M, one is	*/
+/* created and the value set to 2.					*/
 /*									*/
-/* If the device has permutable pins, then duplicate hashes are made	*/
-/* for each permutation.						*/
+/* If the device has permutable pins, then the nodes on the permutable	*/
+/* pins are put in sorted order in the key, so that either ordering of	*/
+/* the pins produces the same key.					*/
 /*									*/
 /* If the device has isolated (unconnected) pins, then treat them as	*/
 /* all belonging to the same net for the purpose of parallel merging.	*/
@@ -3227,11 +4144,8 @@ int CombineParallel(char *model, int file)
    struct objlist *ob, *ob2, *nextob;
    struct objlist *sob, *lob, *nob, *pob, *obr;
    struct objlist *propfirst, *proplast, *spropfirst, *sproplast;
-   struct hashdict devdict;
-   struct Permutation *perm;
-   size_t pcnt;
-   int i, dcnt = 0, hastag;
-   char *pstr, *p2str, *pptr;
+   struct pardev *devs;
+   int d, dcnt = 0, hastag, npins, ndevices, maxpins;
    int *nodecount;
    struct valuelist *kv;
 
@@ -3239,13 +4153,14 @@ int CombineParallel(char *model, int file)
       Printf("Cell: %s does not exist.\n", model);
       return -1;
    }
-
-   InitializeHashTable(&devdict, OBJHASHSIZE);
+   StatStart(STAT_COMBINE_PARALLEL);
 
    /* Make one pass to count the number of times each node number is	*/
    /* used.  This list indicates which pins are no-connects, so they	*/
    /* can be treated as equivalent for the purpose of parallelization.	*/
+   /* The same pass counts devices and pins to size the device table.	*/
 
+   CheckNodeNames(tp);
    nodecount = (int *)CALLOC((tp->nodename_cache_maxnodenum + 1), sizeof(int));
 
    /* Do not combine open connections on top level cells.  The situation */
@@ -3257,6 +4172,17 @@ int CombineParallel(char *model, int file)
    /* can cause parallelizing devices with similar "no-connect" pins to	 */
    /* produce incorrect results.					 */
 
+   ndevices = maxpins = npins = 0;
+   for (ob = tp->cell; ob; ob = ob->next) {
+      if (ob->type == FIRSTPIN) {
+	 ndevices++;
+	 npins = 0;
+      }
+      if (ob->type >= FIRSTPIN) {
+	 npins++;
+	 if (npins > maxpins) maxpins = npins;
+      }
+   }
    if (GlobalParallelOpen && !(tp->flags & CELL_TOP)) {
       for (ob = tp->cell; ob; ob = ob->next) {
          if (ob->node >= 0)
@@ -3265,38 +4191,43 @@ int CombineParallel(char *model, int file)
       }
    }
 
-   lob = NULL;
-   for (ob = tp->cell; ob; ) {
-      if (ob->type == FIRSTPIN) {
-
-         /* Watch for devices prohibited from parallel combination.	*/
-	 /* All devices allow parallel combination by default.		*/
+   /* List the devices, watching for devices prohibited from parallel	*/
+   /* combination (all devices allow parallel combination by default),	*/
+   /* and flag the no-connect nodes.					*/
 
-	 tsub = LookupCellFile(ob->model.class, file);
-         if ((tsub != NULL) && (tsub->flags & COMB_NO_PARALLEL)) {
-            lob = ob;
-	    ob = ob->next;
-	    continue;
-         }
+   devs = (struct pardev *)MALLOC(((ndevices > 0) ? ndevices : 1) *
+		sizeof(struct pardev));
+   d = 0;
+   for (ob = tp->cell; ob; ob = ob->next) {
+      if (ob->type != FIRSTPIN) continue;
+      tsub = LookupCellFile(ob->model.class, file);
+      devs[d].tsub = tsub;
+      if ((tsub != NULL) && (tsub->flags & COMB_NO_PARALLEL))
+	 devs[d].ob = NULL;
+      else {
+	 devs[d].ob = ob;
+	 for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob);
+		ob2 = ob2->next) {
+	    if ((ob2->node >= 0) && (nodecount[ob2->node] == 1)) {
+	       nob = (tp->nodename_cache)[ob2->node];
+	       if (nob != NULL) nob->flags = NO_CONNECT;
+	    }
+	 }
+      }
+      d++;
+   }
 
-	 /* ------------------------------------*/
-	 /* Generate hash key from pins 	*/
-	 /* Handle pin permuations		*/
-	 /* ------------------------------------*/
+   ParallelFindAll(devs, ndevices, nodecount, maxpins);
 
-	 if ((tsub != NULL) && (tsub->permutes != NULL))
-	    perm = tsub->permutes;
-	 else
-	    perm = NULL;	/* Device has no pin permutations */
+   lob = NULL;
+   d = 0;
+   for (ob = tp->cell; ob; ) {
+      if (ob->type == FIRSTPIN) {
 
-	 pcnt = strlen(ob->model.class) + 2;
-	 pptr = (char *)pcnt;
+	 for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob); ob2 = ob2->next)
+	    pob = ob2;
 
 	 propfirst = proplast = NULL;
-	 for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob); ob2 = ob2->next) {
-	    pob = ob2;
-	    pcnt += 10;
-	 }
 	 if (ob2 && (ob2->type == PROPERTY)) propfirst = ob2;
 
 	 /* Find last record in device and first record in next object */
@@ -3306,80 +4237,10 @@ int CombineParallel(char *model, int file)
 	 }
 	 nextob = ob2;
 
-	 pstr = (char *)MALLOC(pcnt);
-	 sprintf(pstr, "%s", ob->model.class);
-	 pptr += pstr - (char *)2;
-	 
-	 for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob); ob2 = ob2->next) {
-	    if ((ob2->node >= 0) && (nodecount[ob2->node] == 1))
-	    {
-	       nob = (tp->nodename_cache)[ob2->node];
-	       nob->flags = NO_CONNECT;
-	       strcat(pptr, "_nc");
-	    }
-	    else
-	       sprintf(pptr, "_%d", ob2->node);
-	    pptr += strlen(pptr);
-	 }
-
-	 /* Now check the hash table for any similar instance */
-	 sob = (struct objlist *)HashLookup(pstr, &devdict);
+	 /* Find the earlier device that this one is parallel to */
+	 sob = (devs[d].rep >= 0) ? devs[devs[d].rep].ob : NULL;
+	 d++;
 	 if (sob == NULL) {
-	    /* Generate hash entry */
-	    HashPtrInstall(pstr, ob, &devdict);
-
-	    /* If pins are permutable, generate alternative hash entries */
-
-	    if (perm != NULL) {
-		char *pname;
-		struct objlist *pob1, *pob2;
-
-		/* NOTE:  This is only set up for a single permutation	*/
-		/* per cell and needs to be expanded to the general	*/
-		/* case, which requires one nested loop per permute	*/
-		/* pair							*/
-
-		p2str = (char *)MALLOC(pcnt);
-		sprintf(p2str, "%s", ob->model.class);
-		pptr = p2str + strlen(ob->model.class);
-
-		for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob);
-				ob2 = ob2->next) {
-		    pname = ob2->name + strlen(ob2->instance.name) + 1;
-		    if ((*matchfunc)(perm->pin1, pname))
-			pob1 = ob2;
-		    else if ((*matchfunc)(perm->pin2, pname))
-			pob2 = ob2;
-		}
-		for (ob2 = ob; ob2 && (ob2->type > FIRSTPIN || ob2 == ob);
-				ob2 = ob2->next) {
-		    if (ob2 == pob1)
-		    {
-	     		if ((pob2->node >= 0) && (nodecount[pob2->node] == 1))
-	       		   strcat(pptr, "_nc");
-			else
-		           sprintf(pptr, "_%d", pob2->node);
-		    }
-		    else if (ob2 == pob2)
-		    {
-	     		if ((pob1->node >= 0) && (nodecount[pob1->node] == 1))
-	       		   strcat(pptr, "_nc");
-			else
-		           sprintf(pptr, "_%d", pob1->node);
-		    }
-		    else
-		    {
-	     		if ((ob2->node >= 0) && (nodecount[ob2->node] == 1))
-	       		   strcat(pptr, "_nc");
-			else
-		           sprintf(pptr, "_%d", ob2->node);
-		    }
-		    pptr += strlen(pptr);
-		}
-		HashPtrInstall(p2str, ob, &devdict);
-		FREE((char *)p2str);
-	    }
-
 	    /* Move last object marker to end of sob record */
 	    if (proplast != NULL)
 	       lob = proplast;
@@ -3481,7 +4342,6 @@ int CombineParallel(char *model, int file)
 	    }
 	    dcnt++;
 	 }
-	 FREE((char *)pstr);
       }
       else {
          lob = ob;
@@ -3489,12 +4349,14 @@ int CombineParallel(char *model, int file)
       }
       ob = nextob;
    }
-   HashKill(&devdict);
+   FREE(devs);
    if (dcnt > 0) {
       Fprintf(stdout, "Class %s (%d):  Merged %d parallel devices.\n",
 		model, file, dcnt);
    }
    FREE(nodecount);
+   StatCount(STAT_COMBINE_PARALLEL, (long)dcnt);
+   StatStop(STAT_COMBINE_PARALLEL);
    return dcnt;
 }
 
@@ -3548,30 +4410,48 @@ int check_pin_nodes(struct objlist *ob1, struct objlist *ob2)
 int CombineSeries(char *model, int file)
 {
    struct nlist *tp, *tp2;
-   struct objlist ***instlist;
+   struct objlist **instlist;
    struct objlist *ob, *ob2, *obs, *obp, *obn;
-   int i, j, scnt = 0;
+   unsigned char *nodeseen, *portnodes, *deadnodes;
+   int i, j, scnt = 0, maxnode;
    struct valuelist *kv;
 
    if ((tp = LookupCellFile(model, file)) == NULL) {
       Printf("Cell: %s does not exist.\n", model);
       return -1;
    }
+   StatStart(STAT_COMBINE_SERIES);
+
    /* Diagnostic */
    /* Printf("CombineSeries start model = %s file = %d\n", model, file); */
 
-   instlist = (struct objlist ***)CALLOC((tp->nodename_cache_maxnodenum + 1),
-		sizeof(struct objlist **));
+   /* instlist holds two device entries per node (the first pin record	*/
+   /* of each device), flattened as instlist[2 * node + n].  An entry	*/
+   /* of NULL in the first position marks a node that cannot be a	*/
+   /* series connection.  nodeseen marks nodes that have entries.	*/
+   /* portnodes and deadnodes are bitmaps of nodes that are ports of	*/
+   /* the cell, and of nodes whose NODE record is to be removed.	*/
+
+   CheckNodeNames(tp);
+   maxnode = tp->nodename_cache_maxnodenum;
+   instlist = (struct objlist **)CALLOC(2 * (maxnode + 1),
+		sizeof(struct objlist *));
+   nodeseen = (unsigned char *)CALLOC(maxnode + 1, sizeof(unsigned char));
+   portnodes = (unsigned char *)CALLOC((maxnode >> 3) + 1, sizeof(unsigned char));
+   deadnodes = (unsigned char *)CALLOC((maxnode >> 3) + 1, sizeof(unsigned char));
+
+   for (obn = tp->cell; obn && obn->type == PORT; obn = obn->next)
+      if ((obn->node >= 0) && (obn->node <= maxnode))
+	 portnodes[obn->node >> 3] |= (1 << (obn->node & 7));
 
    for (ob = tp->cell; ob; ob = ob->next) {
       if ((ob->type >= FIRSTPIN) && (ob->node >= 0)) {
           if (ob->type == FIRSTPIN)
 	     obp = ob;	// Save pointer to first pin of device
 
-          if (instlist[ob->node] == NULL) {
+          if (nodeseen[ob->node] == 0) {
              /* Node has not been seen before, so add it to list */
-	     instlist[ob->node] = (struct objlist **)CALLOC(2,
-			sizeof(struct objlist *));
+	     nodeseen[ob->node] = 1;
 
 	     /* Device must be marked as able to be combined in	series.	*/
 	     /* Note that devices with more than two pins are expected	*/
@@ -3586,59 +4466,56 @@ int CombineSeries(char *model, int file)
 	
              tp2 = LookupCellFile(ob->model.class, file);
              if ((tp2->flags & COMB_SERIES) && (ob->type <= 2)) {
-	         instlist[ob->node][0] = obp;
-
 		 /* Node may not be a port of the subcircuit */
-		 for (obn = tp->cell; obn && obn->type == PORT; obn = obn->next) {
-		     if (obn->node == ob->node) {
-			/* invalidate node */
-			instlist[ob->node][0] = NULL;
-			break;
-		     }
-		 }
+		 if (portnodes[ob->node >> 3] & (1 << (ob->node & 7)))
+		    instlist[2 * ob->node] = NULL;
+		 else
+		    instlist[2 * ob->node] = obp;
 	     }
 	     else
 	         /* invalidate node */
-	         instlist[ob->node][0] = NULL;
+	         instlist[2 * ob->node] = NULL;
+	     instlist[2 * ob->node + 1] = NULL;
           }
-          else if (instlist[ob->node][0] == NULL) {
+          else if (instlist[2 * ob->node] == NULL) {
              /* Node is not valid for series connection */
           }
-          else if (instlist[ob->node][1] == NULL) {
+          else if (instlist[2 * ob->node + 1] == NULL) {
              /* Check if first instance is the same type */
-             if ((*matchfunc)(instlist[ob->node][0]->model.class, ob->model.class)) {
-                 if (check_pin_nodes(instlist[ob->node][0], obp))
-	             instlist[ob->node][1] = obp;
+             if ((*matchfunc)(instlist[2 * ob->node]->model.class,
+			ob->model.class)) {
+                 if (check_pin_nodes(instlist[2 * ob->node], obp))
+	             instlist[2 * ob->node + 1] = obp;
 		 else
 		    /* invalidate node */
-		    instlist[ob->node][0] = NULL;
+		    instlist[2 * ob->node] = NULL;
 	     }
 	     else
 		/* invalidate node */
-		instlist[ob->node][0] = NULL;
+		instlist[2 * ob->node] = NULL;
           }
 	  else {
 	     /* More than two devices connect here, so invalidate */
-	     instlist[ob->node][0] = NULL;
+	     instlist[2 * ob->node] = NULL;
 	  }
       }
    }
-   for (i = 0; i <= tp->nodename_cache_maxnodenum; i++) {
-      if (instlist[i] != NULL) {
-         if ((instlist[i][0] != NULL) && (instlist[i][1] != NULL)) {
+   for (i = 0; i <= maxnode; i++) {
+      if (nodeseen[i] != 0) {
+         if ((instlist[2 * i] != NULL) && (instlist[2 * i + 1] != NULL)) {
 	    int k, l;
 	    struct valuelist *kv2;
 
             /* Diagnostic */
 	    /* Fprintf(stdout, "Found series instances %s and %s\n",
-			instlist[i][0]->instance.name,
-			instlist[i][1]->instance.name); */
+			instlist[2 * i]->instance.name,
+			instlist[2 * i + 1]->instance.name); */
             scnt++;
 
 	    /* To maintain knowledge of the topology, 2nd device gets	*/
 	    /* a parameter '_tag', string value set to "+".		*/
 
-            for (obn = instlist[i][1]; obn->next &&
+            for (obn = instlist[2 * i + 1]; obn->next &&
 			obn->next->type > FIRSTPIN; obn = obn->next);
 	    obp = obn->next;
 
@@ -3676,9 +4553,10 @@ int CombineSeries(char *model, int file)
 	       for (k = 0; ; k++) {
 		  kv = &(obp->instance.props[k]);
 		  if (kv->type == PROP_ENDLIST) {
-		     kv2 = (struct valuelist *)MALLOC((k + 2) *
-				sizeof(struct valuelist));
+		     kv2 = (struct valuelist *)MALLOCTAG((k + 2) *
+				sizeof(struct valuelist), MEM_PROPERTY);
 		     kv2->key = strsave("_tag");
+		     kv2->pindex = 0;
 		     kv2->type = PROP_STRING;
 		     /* Value is set to "+" */
 		     kv2->value.string = (char *)MALLOC(2);
@@ -3701,26 +4579,28 @@ int CombineSeries(char *model, int file)
 	    }
 
             /* Combine these two instances and remove node i */
-            for (ob2 = instlist[i][0]; ob2; ob2 = ob2->next) {
+            for (ob2 = instlist[2 * i]; ob2; ob2 = ob2->next) {
 	       if (ob2->node == i)
 		  break;
 	    }
-            for (obs = instlist[i][1]; obs; obs = obs->next) {
+            for (obs = instlist[2 * i + 1]; obs; obs = obs->next) {
 	       if (obs->node != i) {
+		  NodeNameRemove(tp, ob2);
 		  ob2->node = obs->node;
+		  NodeNameAdd(tp, ob2);
 		  break;
 	       }
 	    }
 
-	    /* Excise the 2nd instance.  instlist[i][1] remains as the	*/
+	    /* Excise the 2nd instance.  instlist[2 * i + 1] remains as the	*/
 	    /* only pointer to it.					*/
-            for (obp = instlist[i][0]; obp->next && (obp->next->type > FIRSTPIN ||
+            for (obp = instlist[2 * i]; obp->next && (obp->next->type > FIRSTPIN ||
 			obp->next->type == PROPERTY); obp = obp->next);
-            for (ob2 = obp; ob2 && ob2->next != instlist[i][1]; ob2 = ob2->next);
+            for (ob2 = obp; ob2 && ob2->next != instlist[2 * i + 1]; ob2 = ob2->next);
 
 	    /* Device may have been moved by the above code.  If so, look for	*/
 	    /* it from the beginning of the list. */
-	    if ((ob2 == NULL) && (tp->cell == instlist[i][1]))
+	    if ((ob2 == NULL) && (tp->cell == instlist[2 * i + 1]))
 	    {
 	       ob2 = tp->cell;
 	       for (obs = ob2; obs->next && (obs->next->type > FIRSTPIN
@@ -3730,7 +4610,7 @@ int CombineSeries(char *model, int file)
 	    else
 	    {
 	       if (ob2 == NULL)
-                  for (ob2 = tp->cell; ob2->next != instlist[i][1]; ob2 = ob2->next);
+                  for (ob2 = tp->cell; ob2->next != instlist[2 * i + 1]; ob2 = ob2->next);
 	       for (obs = ob2->next; obs->next && (obs->next->type > FIRSTPIN
 			|| obs->next->type == PROPERTY); obs = obs->next);
 	       ob2->next = obs->next;
@@ -3739,10 +4619,10 @@ int CombineSeries(char *model, int file)
 
 	    /* If 1st device has unbalanced 'open' records, then add 'close'	*/
 	    /* records to the 2nd device to balance.				*/
-            add_balancing_close(instlist[i][0], instlist[i][1]);
+            add_balancing_close(instlist[2 * i], instlist[2 * i + 1]);
 
 	    /* Move property record(s) of the 2nd device to the first */
-	    for (obs = instlist[i][1]; obs && obs->type != PROPERTY; obs = obs->next);
+	    for (obs = instlist[2 * i + 1]; obs && obs->type != PROPERTY; obs = obs->next);
 	    while (obs && (obs->type == PROPERTY)) {
 	       obn = obs->next;
 	       obs->next = obp->next;
@@ -3751,48 +4631,62 @@ int CombineSeries(char *model, int file)
 	    }
 
 	    /* If 2nd device appears anywhere else in the series device	*/
-	    /* list, replace it with the 1st device.			*/
-	    for (j = i + 1; j <= tp->nodename_cache_maxnodenum; j++) {
-               if (instlist[j] == NULL) continue;
-
-	       if (instlist[j][0] == instlist[i][1])
-		  instlist[j][0] = instlist[i][0];
-	       if (instlist[j][1] == instlist[i][1])
-		  instlist[j][1] = instlist[i][0];
-
-               /* If instlist[j]'s two entries point to the same device */
+	    /* list, replace it with the 1st device.  The 2nd device can	*/
+	    /* only be listed on the nodes of its own pins.		*/
+	    for (obs = instlist[2 * i + 1]; obs && (obs->type > FIRSTPIN ||
+			obs == instlist[2 * i + 1]); obs = obs->next) {
+	       j = obs->node;
+               if ((j <= i) || (j > maxnode) || (nodeseen[j] == 0)) continue;
+
+	       if (instlist[2 * j] == instlist[2 * i + 1])
+		  instlist[2 * j] = instlist[2 * i];
+	       if (instlist[2 * j + 1] == instlist[2 * i + 1])
+		  instlist[2 * j + 1] = instlist[2 * i];
+
+               /* If node j's two entries point to the same device	*/
 	       /* then invalidate it.					*/
-	       if (instlist[j][0] == instlist[j][1]) {
-		  FREE(instlist[j]);
-		  instlist[j] = NULL;
-	       }
+	       if (instlist[2 * j] == instlist[2 * j + 1])
+		  nodeseen[j] = 0;
 	    }
 
 	    /* Free 2nd device's object */
-	    for (obs = instlist[i][1]; obs && obs->type != PROPERTY; ) {
+	    for (obs = instlist[2 * i + 1]; obs && obs->type != PROPERTY; ) {
                obn = obs->next;
 	       FreeObjectAndHash(obs, tp);
 	       obs = obn;
 	    }
 
-	    /* Free node i and remove from object hash */
-	    for (obp = tp->cell; obp->next; obp = obp->next) {
-	       if ((obp->next->type == NODE) && (obp->next->node == i)) {
-	          obn = obp->next;
-		  obp->next = obp->next->next;
-		  FreeObjectAndHash(obn, tp);
-	          break;
-	       }
-	    }
+	    /* Mark node i to be freed */
+	    deadnodes[i >> 3] |= (1 << (i & 7));
          }
-         FREE(instlist[i]);
+      }
+   }
+
+   /* Free the NODE record of each merged node and remove it from the	*/
+   /* object hash.							*/
+   if (scnt > 0) {
+      for (obp = tp->cell; obp && obp->next; ) {
+	 obn = obp->next;
+	 if ((obn->type == NODE) && (obn->node >= 0) && (obn->node <= maxnode)
+			&& (deadnodes[obn->node >> 3] & (1 << (obn->node & 7)))) {
+	    deadnodes[obn->node >> 3] &= ~(1 << (obn->node & 7));
+	    obp->next = obn->next;
+	    FreeObjectAndHash(obn, tp);
+	 }
+	 else
+	    obp = obn;
       }
    }
    FREE(instlist);
+   FREE(nodeseen);
+   FREE(portnodes);
+   FREE(deadnodes);
    if (scnt > 0) {
       Fprintf(stdout, "Class %s (%d):  Merged %d series devices.\n",
 		model, file, scnt);
    }
+   StatCount(STAT_COMBINE_SERIES, (long)scnt);
+   StatStop(STAT_COMBINE_SERIES);
    return scnt;
 }
 
@@ -3823,7 +4717,7 @@ void EndCell(void)
     }
   }
   LastPlaced = NULL;
-  CacheNodeNames(CurrentCell);
+  FreeNodeNames(CurrentCell);
   if (NoDisconnectedNodes)  ConnectAllNodes(CurrentCell->name, CurrentCell->file);
   CurrentCell = NULL;
   CurrentTail = NULL;
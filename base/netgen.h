@@ -22,6 +22,7 @@
 extern void ReopenCellDef(char *name, int file);
 extern void CellDef(char *name, int file);
 extern void CellDefNoCase(char *name, int file);
+extern int ResolveLibraryCells(int fnum);
 extern void EndCell(void);
 extern void Port(char *name);
 extern int CountPorts(char *name, int file);
@@ -35,6 +36,9 @@ extern struct property *PropertyInteger(char *name, int fnum, char *key,
 extern struct property *PropertyString(char *name, int fnum, char *key,
 		double slop, char *pdefault);
 extern int  PropertyDelete(char *name, int fnum, char *key);
+extern struct property *PropertyLookup(struct nlist *tc, struct valuelist *vl);
+extern void FreePropertyIndex(struct nlist *tc);
+extern int PropertyIndexCell(struct nlist *tc);
 extern void SetParallelCombine(int value);
 extern void SetSeriesCombine(int value);
 extern int  PropertyTolerance(char *name, int fnum, char *key, int ival,
@@ -50,6 +54,7 @@ extern int SetPropertyDefault(struct property *, struct valuelist *);
 extern struct objlist *LinkProperties(char *model, struct keyvalue *topptr);
 extern int ReduceExpressions(struct objlist *instprop, struct objlist *parprops,
 		struct nlist *parent, int glob);
+extern void FreeExpressionCache(void);
 extern void Node(char *name);
 extern void Global(char *name);
 extern void UniqueGlobal(char *name);
@@ -142,6 +147,7 @@ extern int  PropertyValueMatch(char *, char *);
 
 /* objlist.c */
 extern void CellDelete(char *name, int file);
+extern void CellDeleteFiles(int fnum);
 extern void InstanceRename(char *from, char *to, int file);
 
 extern int Debug;
@@ -168,7 +174,7 @@ extern void PrintAllElements(char *cell, int file);
 #else
 extern void PrintElement(char *cell, char *list_template);
 #endif
-extern void Fanout(char *cell, char *node, int filter);
+extern void Fanout(char *cell, char *node, int filter, int fnum);
 extern void PrintCell(char *name, int file);
 extern void Query(void);
 
@@ -208,9 +214,4 @@ extern void PROTOCHIP(void);
 extern void NETCOMP(void);
 extern int Compare(char *cell1, char *cell2);
 
-/* this is defined in tclnetgen.c */
-#ifdef TCL_NETGEN
-extern char *tcl_calloc(size_t, size_t);
-#endif
-
 #endif	/* _NETGEN_H */
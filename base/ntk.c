@@ -362,7 +362,10 @@ char *ReadNtk (char *fname, int *fnum)
       InputParseError(stderr);
     }
   }
-  CloseParseFile();
+  if (CloseNetlistFile(fname, *fnum, filenum) != 0) {
+    *fnum = -1;
+    return NULL;
+  }
 
   *fnum = filenum;
   return LastCellRead;
@@ -18,9 +18,11 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* objlist.c  --  manipulating lists of elements */
 
+#define MEMTAG MEM_CELL	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <limits.h>
 #ifdef IBMPC
@@ -68,6 +70,8 @@ int UnixWildcards = 1;
 #define GARBAGESIZE 100
 /* list of allocated nodes awaiting garbage collection */
 static struct objlist *garbage[GARBAGESIZE]; 
+/* nonzero if the list was allocated as a single block */
+static unsigned char garbageblock[GARBAGESIZE];
 static int nextfree;
 static int ObjectsAllocated = 0;
 #ifdef DEBUG_GARBAGE
@@ -82,8 +86,10 @@ void InitGarbageCollection()
 {
 	int i;
 	
-	for (i=0; i < GARBAGESIZE; i++)
+	for (i=0; i < GARBAGESIZE; i++) {
 		garbage[i] = NULL;
+		garbageblock[i] = 0;
+	}
 	nextfree = 0;
 }
 
@@ -92,6 +98,11 @@ void ThrowOutGarbage(int i)
 	struct objlist *tp, *tpnext;
 	
 	tp = garbage[i];
+	if (garbageblock[i]) {
+		FREE(tp);
+		tp = NULL;
+		garbageblock[i] = 0;
+	}
 	while (tp != NULL) {
 		tpnext = tp->next;
 		FREE(tp);
@@ -105,6 +116,17 @@ void ThrowOutGarbage(int i)
 }
 
 
+/* Free every list awaiting garbage collection */
+
+void FreeGarbageList(void)
+{
+	int i;
+
+	for (i = 0; i < GARBAGESIZE; i++)
+		if (garbage[i] != NULL) ThrowOutGarbage(i);
+	nextfree = 0;
+}
+
 void AddToGarbageList(struct objlist *head)
 {
 	if (garbage[nextfree] != NULL) ThrowOutGarbage(nextfree);
@@ -112,6 +134,20 @@ void AddToGarbageList(struct objlist *head)
 	nextfree = (nextfree + 1) % GARBAGESIZE;
 }
 
+#ifndef TCL_NETGEN
+
+/* Same as above, for a list allocated as one contiguous block */
+
+static void AddBlockToGarbageList(struct objlist *head)
+{
+	if (garbage[nextfree] != NULL) ThrowOutGarbage(nextfree);
+	garbage[nextfree] = head;
+	garbageblock[nextfree] = (head != NULL);
+	nextfree = (nextfree + 1) % GARBAGESIZE;
+}
+
+#endif
+
 #ifdef DEBUG_GARBAGE
 /* otherwise, inline these functions with macros */
 
@@ -128,7 +164,8 @@ struct property *NewProperty(void)
 {
 	struct property *kl;
 	
-	kl = (struct property *)CALLOC(1,sizeof(struct property));
+	kl = (struct property *)CALLOCTAG(1,sizeof(struct property),
+		MEM_PROPERTY);
 	if (kl == NULL) Fprintf(stderr,"NewProperty: Core allocation error\n");
 	kl->pin = (char *)NULL;
 	return (kl);
@@ -138,7 +175,8 @@ struct valuelist *NewPropValue(int entries)
 {
 	struct valuelist *vl;
 	
-	vl = (struct valuelist *)CALLOC(entries, sizeof(struct valuelist));
+	vl = (struct valuelist *)CALLOCTAG(entries, sizeof(struct valuelist),
+		MEM_PROPERTY);
 	if (vl == NULL) Fprintf(stderr,"NewPropValue: Core allocation error\n");
 	return (vl);
 }
@@ -309,24 +347,6 @@ int is_delimiter(char testc)
     return (to_lower[testc] == '<') ? TRUE : FALSE;
 }
 
-#ifdef HAVE_MALLINFO
-void PrintMemoryStats(void)
-{
-  struct mallinfo minfo;
-
-  /* HPUX 7.0 defines mallinfo(void); use mallinfo(0) for HPUX 6.5 */
-  minfo = mallinfo();
-
-  Printf("total space = %d\n", minfo.arena);
-  Printf("small blocks    = %5d, space = %7d, free space = %7d\n", 
-	 minfo.smblks, minfo.usmblks, minfo.fsmblks);
-  Printf("ordinary blocks = %5d, space = %7d, free space = %7d\n", 
-	 minfo.ordblks, minfo.uordblks, minfo.fordblks);
-  Printf("holding blocks  = %5d, size of header = %d\n", 
-	 minfo.hblks, minfo.hblkhd);
-}
-#endif
-
 
 /**************************************************************************
 
@@ -338,12 +358,50 @@ void PrintMemoryStats(void)
 #define CELLHASHSIZE 1000
 static struct hashdict cell_dict;
 
+/* Number of read-only library cells (flag CELL_LIBRARY) */
+static int LibraryCount = 0;
+static int SetLibrary;
+
+/* Start a new, empty cell hash table.  Library cells are carried over	*/
+/* from the old table, so that "reinitialize" does not discard them.	*/
+
 void InitCellHashTable(void)
 {
-    hashfunc = hashcase;
-    matchfunc = NULL;
-    matchintfunc = matchfile;
+    struct nlist **libcells = NULL;
+    struct hashlist *np;
+    struct nlist *tp;
+    int i, numcells = 0, nocase = 0;
+
+    if ((LibraryCount > 0) && (cell_dict.hashtab != NULL)) {
+	libcells = (struct nlist **)CALLOC(LibraryCount, sizeof(struct nlist *));
+	for (i = 0; i < cell_dict.hashsize; i++)
+	    for (np = cell_dict.hashtab[i]; np != NULL; np = np->next) {
+		tp = (struct nlist *)np->ptr;
+		if ((tp == NULL) || !(tp->flags & CELL_LIBRARY)) continue;
+		if (numcells < LibraryCount) libcells[numcells++] = tp;
+		if (tp->flags & CELL_NOCASE) nocase = 1;
+	    }
+    }
+
+    if (nocase) {
+	/* Keep the library cells findable under the case rules	*/
+	/* they were read with.						*/
+	hashfunc = hashnocase;
+	matchfunc = matchnocase;
+	matchintfunc = matchfilenocase;
+    }
+    else {
+	hashfunc = hashcase;
+	matchfunc = NULL;
+	matchintfunc = matchfile;
+    }
     InitializeHashTable(&cell_dict, CELLHASHSIZE);
+
+    for (i = 0; i < numcells; i++)
+	HashIntPtrInstall(libcells[i]->name, libcells[i]->file, libcells[i],
+		&cell_dict);
+    LibraryCount = numcells;
+    if (libcells != NULL) FREE(libcells);
 }
 
 struct nlist *LookupCell(char *s)
@@ -363,6 +421,78 @@ struct nlist *LookupCellFile(char *s, int f)
    return HashIntLookup(s, f, &cell_dict);
 }
 
+/* Mark every cell of file "fnum" as a read-only library cell, or,	*/
+/* if "library" is FALSE, make the cells of the file ordinary cells	*/
+/* again.								*/
+
+static int setlibrarycell(struct hashlist *p, int fnum)
+{
+   struct nlist *ptr;
+
+   ptr = (struct nlist *)(p->ptr);
+   if (ptr->file != fnum) return 1;
+
+   if (SetLibrary && !(ptr->flags & CELL_LIBRARY)) {
+      ptr->flags |= CELL_LIBRARY;
+      LibraryCount++;
+   }
+   else if (!SetLibrary && (ptr->flags & CELL_LIBRARY)) {
+      ptr->flags &= ~CELL_LIBRARY;
+      LibraryCount--;
+   }
+   return 1;
+}
+
+void CellSetLibrary(int fnum, int library)
+{
+   SetLibrary = library;
+   RecurseCellFileHashTable(setlibrarycell, fnum);
+}
+
+static int islibrarycell(struct hashlist *p, int fnum)
+{
+   struct nlist *ptr;
+
+   ptr = (struct nlist *)(p->ptr);
+   return ((ptr->file == fnum) && (ptr->flags & CELL_LIBRARY)) ? 1 : 0;
+}
+
+/* Return TRUE if file "fnum" holds a library read with "readlib" */
+
+int CellFileIsLibrary(int fnum)
+{
+   if (LibraryCount == 0) return FALSE;
+   return (RecurseCellFileHashTable(islibrarycell, fnum) > 0) ? TRUE : FALSE;
+}
+
+/* Find a library cell by name, regardless of the file it was read	*/
+/* from.  If more than one library defines "s", the library read	*/
+/* first (the lowest file number) takes precedence.  If "count" is	*/
+/* not NULL, it is set to the number of libraries that define "s".	*/
+/* Returns NULL if there is no library cell "s".			*/
+
+struct nlist *LookupLibraryCell(char *s, int *count)
+{
+   struct hashlist *np;
+   struct nlist *tp, *found = NULL;
+   int n = 0;
+
+   if (count != NULL) *count = 0;
+   if (LibraryCount == 0) return NULL;
+
+   for (np = cell_dict.hashtab[(*hashfunc)(s, cell_dict.hashsize)];
+		np != NULL; np = np->next) {
+      tp = (struct nlist *)np->ptr;
+      if ((tp != NULL) && (tp->flags & CELL_LIBRARY) &&
+		(*matchintfunc)(s, np->name, tp->file, tp->file)) {
+	 if ((found == NULL) || (tp->file < found->file)) found = tp;
+	 n++;
+      }
+   }
+   if (count != NULL) *count = n;
+   return found;
+}
+
 struct nlist *InstallInCellHashTable(char *name, int fnum)
 {
   struct hashlist *ptr;
@@ -515,6 +645,7 @@ int deleteclass(struct hashlist *p, int file)
     * the node is deleted in a child, then disconnecting all nodes
     * that ended up with a zero count.
     */
+   CheckNodeNames(ptr);
    checknodes = (unsigned char *)CALLOC(ptr->nodename_cache_maxnodenum + 1,
 		sizeof(unsigned char));
 
@@ -562,6 +693,7 @@ int deleteclass(struct hashlist *p, int file)
          }
          if ((ob == NULL) && (portnode != NULL)) {
 	    /* Port became disconnected when child was deleted */
+	    NodeNameRemove(ptr, portnode);
 	    portnode->node = -1;
          }
       }
@@ -657,6 +789,7 @@ void CellDelete(char *name, int fnum)
    */
    struct objlist *ob, *obnext;
    struct nlist *tp;
+   struct Permutation *perm;
 
    tp = LookupCellFile(name, fnum);
    if (tp == NULL) {
@@ -671,7 +804,13 @@ void CellDelete(char *name, int fnum)
    HashKill(&(tp->instdict));
    RecurseHashTable(&(tp->propdict), freeprop);
    HashKill(&(tp->propdict));
+   FreePropertyIndex(tp);
    FreeNodeNames(tp);
+   while (tp->permutes != NULL) {
+      perm = tp->permutes->next;
+      FREE(tp->permutes);
+      tp->permutes = perm;
+   }
    ob = tp->cell;
    while (ob != NULL) {
       obnext = ob->next;
@@ -680,6 +819,50 @@ void CellDelete(char *name, int fnum)
    }
 }
 
+/* Delete every cell read from file number "fnum" or any later file,	*/
+/* and free its records.  Used to discard the netlists of a job while	*/
+/* keeping libraries read earlier.  Library cells are never deleted.	*/
+
+static struct nlist **DeleteList;
+static int DeleteCount;
+
+static int listfilecells(struct hashlist *p, int fnum)
+{
+   struct nlist *ptr;
+
+   ptr = (struct nlist *)(p->ptr);
+   if ((ptr->file >= fnum) && !(ptr->flags & CELL_LIBRARY)) {
+      if (DeleteList != NULL) DeleteList[DeleteCount] = ptr;
+      DeleteCount++;
+   }
+   return 1;
+}
+
+void CellDeleteFiles(int fnum)
+{
+   int i, numcells;
+   struct nlist *tp;
+
+   DeleteList = NULL;
+   DeleteCount = 0;
+   RecurseCellFileHashTable(listfilecells, fnum);
+   if (DeleteCount == 0) return;
+
+   numcells = DeleteCount;
+   DeleteList = (struct nlist **)CALLOC(numcells, sizeof(struct nlist *));
+   DeleteCount = 0;
+   RecurseCellFileHashTable(listfilecells, fnum);
+
+   for (i = 0; i < numcells; i++) {
+      tp = DeleteList[i];
+      if (tp == CurrentCell) CurrentCell = NULL;
+      CellDelete(tp->name, tp->file);
+      FREE(tp);
+   }
+   FREE(DeleteList);
+   DeleteList = NULL;
+}
+
 static int PrintCellHashTableElement(struct hashlist *p)
 {
    struct nlist *ptr;
@@ -854,20 +1037,125 @@ char *FixTemplate(char *t)
 			
 #ifndef TCL_NETGEN
 
+/*--------------------------------------------------------------*/
+/* Cache of translated and compiled list templates.  Setup	*/
+/* files and Connect() apply the same templates over and over.	*/
+/* "prefix" is the run of literal characters that begins the	*/
+/* template, and "suffix" the run that ends it;  any name	*/
+/* that does not start and end with these can be rejected	*/
+/* without running the regular expression.			*/
+/*--------------------------------------------------------------*/
+
+#define TEMPLATEHASHSIZE 256
+#define TEMPLATEMAX 1024	/* flush the cache beyond this many */
+
+struct listtemplate {
+  char *text;			/* template as given to List() */
+  char *fixed;			/* template translated by FixTemplate() */
+  Regexp regexp;
+  int wildcards;		/* value of UnixWildcards when compiled */
+  int prefixlen;
+  int suffixlen;
+  struct listtemplate *next;
+};
+
+static struct listtemplate **templatecache = NULL;
+static int templatecount = 0;
+
+static void FreeListTemplates(void)
+{
+  struct listtemplate *ltp, *lnext;
+  int i;
+
+  if (templatecache == NULL) return;
+  for (i = 0; i < TEMPLATEHASHSIZE; i++) {
+    for (ltp = templatecache[i]; ltp != NULL; ltp = lnext) {
+      lnext = ltp->next;
+#ifdef REGEXP_FREE_TEMPLATE
+      /* allocated by the regexp library, not by MALLOC() */
+      if (ltp->regexp != NULL) free(ltp->regexp);
+#endif
+      FreeString(ltp->text);
+      FreeString(ltp->fixed);
+      FREE(ltp);
+    }
+    templatecache[i] = NULL;
+  }
+  templatecount = 0;
+}
+
+static struct listtemplate *GetListTemplate(char *list_template)
+{
+  struct listtemplate *ltp;
+  unsigned long hashval;
+  char *cptr;
+  int len;
+
+  if (templatecache == NULL)
+    templatecache = (struct listtemplate **)CALLOC(TEMPLATEHASHSIZE,
+		sizeof(struct listtemplate *));
+
+  hashval = hashcase(list_template, TEMPLATEHASHSIZE);
+  for (ltp = templatecache[hashval]; ltp != NULL; ltp = ltp->next)
+    if (ltp->wildcards == UnixWildcards && !strcmp(ltp->text, list_template))
+      break;
+
+  if (ltp == NULL) {
+    if (templatecount >= TEMPLATEMAX) FreeListTemplates();
+
+    ltp = (struct listtemplate *)MALLOC(sizeof(struct listtemplate));
+    ltp->text = strsave(list_template);
+    ltp->fixed = FixTemplate(list_template);
+    ltp->wildcards = UnixWildcards;
+    DBUG_PRINT("regex",("Compiling regular expression: %s => %s",
+		      list_template, ltp->fixed));
+    ltp->regexp = RegexpCompile(ltp->fixed);
+    DBUG_PRINT("regex",("   Result = %ld",(long)ltp->regexp));
+
+    /* Only translated templates are anchored at both ends */
+    ltp->prefixlen = ltp->suffixlen = 0;
+    if (UnixWildcards) {
+      for (cptr = list_template; *cptr != '\0'; cptr++)
+	if (strchr("*?[]{}\\", *cptr) != NULL) break;
+      ltp->prefixlen = cptr - list_template;
+
+      len = strlen(list_template);
+      if (ltp->prefixlen < len) {
+	for (cptr = list_template + len; cptr > list_template; cptr--)
+	  if (strchr("*?[]{}\\", *(cptr - 1)) != NULL) break;
+	ltp->suffixlen = list_template + len - cptr;
+      }
+    }
+
+    ltp->next = templatecache[hashval];
+    templatecache[hashval] = ltp;
+    templatecount++;
+  }
+#ifdef HAVE_RE_COMP
+  else
+    RegexpCompile(ltp->fixed);	/* re_comp() keeps only one expression */
+#endif
+  return ltp;
+}
+
 /*
  *-------------------------------------------------------------------
  * returns a list of objects in CurrentCell whose names match the
  * regular expression in the 'list_template'
+ *
+ * The list is allocated as a single block of objects, which is
+ * released all at once by the garbage collector.
  *-------------------------------------------------------------------
  */
 	
 struct objlist *List(char *list_template)
 {
-  Regexp RegularExpression;
-  struct objlist *head, *tail;
-  struct objlist *test, *tmp;
-  char *template2;
-  int itmp;
+  static struct objlist **matches = NULL;
+  static int maxmatches = 0;
+  struct listtemplate *ltp;
+  struct objlist *head;
+  struct objlist *test;
+  int itmp, nmatch, i, len, tlen;
 	
   if (CurrentCell == NULL) {
     Fprintf(stderr,"No current cell in List()\n");
@@ -879,7 +1167,6 @@ struct objlist *List(char *list_template)
     test = CurrentCell->cell;
 
   head = NULL;
-  tail = NULL;
 
 #ifdef OPTIMIZE_WILDCARDS
   if (strpbrk(list_template,"*?[{") == NULL && UnixWildcards) {
@@ -899,38 +1186,49 @@ struct objlist *List(char *list_template)
 
 #endif /* OPTIMIZE_WILDCARDS */
 
-  template2 = FixTemplate(list_template);
-  DBUG_PRINT("regex",("Compiling regular expression: %s => %s",
-		      list_template, template2));
-  RegularExpression = RegexpCompile(template2);
-  DBUG_PRINT("regex",("   Result = %ld",(long)RegularExpression));
-  FreeString(template2);
+  ltp = GetListTemplate(list_template);
+#ifndef HAVE_RE_COMP
+  if (ltp->regexp == NULL) return NULL;	/* template failed to compile */
+#endif
+  tlen = strlen(list_template);
+
+  nmatch = 0;
   for ( ; test != NULL; test = test->next) {
-    itmp = RegexpMatch(RegularExpression,test->name);
+    if (test->name == NULL) continue;
+    if (ltp->prefixlen > 0 && strncmp(test->name, list_template,
+		ltp->prefixlen))
+      continue;
+    if (ltp->suffixlen > 0) {
+      len = strlen(test->name);
+      if (len < ltp->suffixlen || strcmp(test->name + len - ltp->suffixlen,
+		list_template + tlen - ltp->suffixlen))
+	continue;
+    }
+    itmp = RegexpMatch(ltp->regexp,test->name);
     DBUG_PRINT("regex",("Testing string %s, result = %d", test->name, itmp));
     if (itmp) {
-      tmp = GetObject();
-      memcpy(tmp, test, sizeof(struct objlist));
-      tmp->next = NULL;
-
-      /* now insert it into list */
-
-      if (head == NULL) {
-	head = tmp;
-	tail = tmp;
-      }
-      else {			/* append it to list 'head' */
-	tail->next = tmp;
-	tail = tmp;
+      if (nmatch == maxmatches) {
+	struct objlist **newmatches;
+	maxmatches = (maxmatches == 0) ? 64 : (maxmatches << 1);
+	newmatches = (struct objlist **)MALLOC(maxmatches *
+		sizeof(struct objlist *));
+	if (nmatch > 0) {
+	  memcpy(newmatches, matches, nmatch * sizeof(struct objlist *));
+	  FREE(matches);
+	}
+	matches = newmatches;
       }
+      matches[nmatch++] = test;
     }
   }
+  if (nmatch == 0) return NULL;
 
-#ifdef REGEXP_FREE_TEMPLATE
-  FREE(RegularExpression);
-#endif
-
-  AddToGarbageList(head);
+  head = (struct objlist *)MALLOC(nmatch * sizeof(struct objlist));
+  for (i = 0; i < nmatch; i++) {
+    memcpy(head + i, matches[i], sizeof(struct objlist));
+    head[i].next = (i < nmatch - 1) ? head + i + 1 : NULL;
+  }
+  AddBlockToGarbageList(head);
   return(head);
 }
 
@@ -1055,9 +1353,7 @@ struct objlist *CopyObjList(struct objlist *oldlist, unsigned char doforall)
   while (tmp != NULL) {
     if ((newob = GetObject()) == NULL) {
       Fprintf(stderr,"CopyObjList: core allocation failure\n");
-#ifdef HAVE_MALLINFO
       PrintMemoryStats();
-#endif
       return(NULL);
     }
     newob->name = (tmp->name) ? strsave(tmp->name) : NULL;
@@ -1149,6 +1445,7 @@ void AddToCurrentCellNoHash(struct objlist *ob)
   else CurrentTail->next = ob;
   CurrentTail = ob;
   ob->next = NULL;
+  NodeNameAdd(CurrentCell, ob);
 }
 
 void AddInstanceToCurrentCell(struct objlist *ob)
@@ -1194,13 +1491,15 @@ void FreeObject(struct objlist *ob)
      /* All other records */
      if (ob->instance.name != NULL) FreeString(ob->instance.name);
   }
-  if (ob->model.class != NULL) FreeString(ob->model.class);
+  /* model.port, not model.class, is set for ports */
+  if ((ob->model.class != NULL) && !IsPort(ob)) FreeString(ob->model.class);
   FREE(ob);
 }
 
 
 void FreeObjectAndHash(struct objlist *ob, struct nlist *ptr)
 {
+   NodeNameRemove(ptr, ob);
    HashDelete(ob->name, &(ptr->objdict));
    FreeObject(ob);
 }
@@ -1226,11 +1525,18 @@ int NumberOfPorts(char *cellname, int file)
 }
   
 void FreePorts(char *cellname)
+{
+  FreePortsFile(cellname, -1);
+}
+
+/* Same as FreePorts(), but only for the cell of that name in file "fnum" */
+
+void FreePortsFile(char *cellname, int fnum)
 {
   struct nlist *tp;
   struct objlist *ob, *obnext, *oblast;
 
-  tp = LookupCell(cellname);
+  tp = LookupCellFile(cellname, fnum);
   if (tp == NULL) return;
   ob = tp->cell;
   if (ob == NULL) return;
@@ -1284,153 +1590,101 @@ struct objlist *InstanceNumber(struct nlist *tp, int inst)
 
 
 
-static char *OldNodeName(struct nlist *tp, int node)
-{
-  /* return a legitimate node name for node number 'node' in cell *tp */
-  /* Order of preference:
-     1) Named ports of cells
-     2) Named internal nodes of cells
-     3) Unique global ports (these names are descriptive, but long)
-     4) Global ports
-     5) Pins on instances
-     */
+/* Each cell keeps an array "nodename_cache" giving, for each node	*/
+/* number, the object whose name is the preferred name of the node:	*/
+/* in order of preference,						*/
+/*   1) Named ports of cells						*/
+/*   2) Named internal nodes of cells					*/
+/*   3) Unique global ports (these names are descriptive, but long)	*/
+/*   4) Global ports							*/
+/*   5) Pins on instances						*/
+/* and otherwise the first such object in the cell.			*/
+/*									*/
+/* The cache is built on first use.  Routines that change a cell's	*/
+/* node numbers keep it up to date with NodeNameAdd(), NodeNameMerge()	*/
+/* and NodeNameRemove(), or else discard it with FreeNodeNames().	*/
+/* Each of these also discards the connectivity index (see ConnIndex).	*/
 
-  struct objlist *ob;
-  struct objlist *firstport;
-  struct objlist *firstnode;
-  struct objlist *firstuniqueglobal;
-  struct objlist *firstglobal;
-  struct objlist *firstpin;
-  static char StrBuffer[MAX_STR_LEN];
+/* Return TRUE if "ob" is preferred to "present" as a node name */
 
-#if 0
-  /* make second pass, looking for ports */
-  ob = tp->cell;
-  while (ob != NULL) {
-    if ((node == ob->node) && IsPort(ob)) {
-      strcpy(StrBuffer, ob->name);
-      return(StrBuffer);
-    }
-    ob = ob->next;
-  }
-
-  /* make third pass, looking for named internal nodes */
-  ob = tp->cell;
-  while (ob != NULL) {
-    if ((node == ob->node) && (ob->type == NODE)) {
-      strcpy(StrBuffer, ob->name);
-      return(StrBuffer);
-    }
-    ob = ob->next;
-  }
+static int NodeNamePreferred(struct objlist *present, struct objlist *ob)
+{
+  int present_type, new_type;
 
-  /* make zeroth pass, looking for unique global ports */
-  ob = tp->cell;
-  while (ob != NULL) {
-    if ((node == ob->node) && (ob->type == UNIQUEGLOBAL)) {
-      strcpy(StrBuffer, ob->name);
-      return(StrBuffer);
-    }
-    ob = ob->next;
-  }
+  present_type = present->type;
+  new_type = ob->type;
 
-  /* make first pass, looking for global ports */
-  ob = tp->cell;
-  while (ob != NULL) {
-    if ((node == ob->node) && (ob->type == GLOBAL)) {
-      strcpy(StrBuffer, ob->name);
-      return(StrBuffer);
-    }
-    ob = ob->next;
-  }
+  if (new_type == present_type) return FALSE;
+  if (new_type >= FIRSTPIN && present_type >= FIRSTPIN) return FALSE;
 
-  /* make fourth pass, looking for first pin */
-  ob = tp->cell;
-  while (ob != NULL) {
-    if (node == ob->node) {
-      strcpy(StrBuffer, ob->name);
-      return(StrBuffer);
-    }
-    ob = ob->next;
+  switch (new_type) {
+    case PORT: 
+      return TRUE;
+    case NODE:
+      return (present_type != PORT);
+    case UNIQUEGLOBAL:
+      return (present_type != PORT && present_type != NODE);
+    case GLOBAL:
+      return (present_type != PORT && present_type != NODE &&
+		present_type != UNIQUEGLOBAL);
+    default:   /* we have a pin or property, which we can ignore */
+      return FALSE;
   }
-#endif
+}
 
-  firstport = NULL;
-  firstnode = NULL;
-  firstuniqueglobal = NULL;
-  firstglobal = NULL;
-  firstpin = NULL;
-  if (node < 1) {
-    sprintf(StrBuffer, "Disconnected(%d)",node);
-    return(StrBuffer);
-  }
-  for (ob = tp->cell; ob != NULL; ob = ob->next) {
-    if (node == ob->node) {
-      if (ob->type >= FIRSTPIN) firstpin = ob;
-      else if (IsPort(ob)) {
-	firstport = ob;
-	strcpy(StrBuffer,ob->name);
-	return(StrBuffer);
-      }
-      else if (ob->type == NODE) firstnode = ob;
-      else if (ob->type == UNIQUEGLOBAL) firstuniqueglobal = ob;
-      else if (ob->type == GLOBAL) firstglobal = ob;
-      else 
-	Fprintf(stderr,"??? ob->type = %d on %s\n",ob->type,ob->name);
-    }
-  }
+/* Make sure the cache is valid, rebuilding it if it has been	*/
+/* discarded or if the preferred name of a node was removed.	*/
 
-  if (firstport != NULL) ob = firstport;
-  else if (firstnode != NULL) ob = firstnode;
-  else if (firstuniqueglobal != NULL) ob = firstuniqueglobal;
-  else if (firstglobal != NULL) ob = firstglobal;
-  else if (firstpin != NULL) ob = firstpin;
-  else {
-    /* if we got to here, we have a serious problem */
-    Fprintf (stderr, "NodeName(%d) called with bogus parameter\n", node);
-    sprintf(StrBuffer, "bogus(%d)",node);
-    return(StrBuffer);
-  }
-  strcpy(StrBuffer,ob->name);
-  return(StrBuffer);
+void CheckNodeNames(struct nlist *tp)
+{
+  if (tp == NULL) return;
+  if (tp->nodename_cache == NULL || tp->nodename_cache_stale)
+    CacheNodeNames(tp);
 }
 
-
 char *NodeName(struct nlist *tp, int node)
 {
-  if (node == -1) return("Disconnected");
-  if (tp->nodename_cache != NULL) {
-    if (node > tp->nodename_cache_maxnodenum || 
+  if (node < 0) return("Disconnected");
+  CheckNodeNames(tp);
+  if (tp->nodename_cache == NULL || node > tp->nodename_cache_size ||
 	tp->nodename_cache[node] == NULL)
-      return ("IllegalNode");
-    else
-      return (tp->nodename_cache[node]->name);
-  }
-  return (OldNodeName(tp, node));
+    return ("IllegalNode");
+  else
+    return (tp->nodename_cache[node]->name);
 }
 
 char *NodeAlias(struct nlist *tp, struct objlist *ob)
 /* return the best name for 'ob'; safer than calling NodeName,
    as it correctly handles disconnected nodes */
 {
+  static char StrBuffer[MAX_STR_LEN];
+
   if (ob == NULL) return("NULL");
   if (ob->node == -1) {
 /*    Fprintf(stderr,"Disconnected node in NodeAlias: %s\n",ob->name); */
     return(ob->name);
   }
-  if ((ob->node >= 0) && (tp->nodename_cache != NULL) &&
-		(ob->node <= tp->nodename_cache_maxnodenum))
-    return (tp->nodename_cache[ob->node]->name);
-  return (OldNodeName(tp, ob->node));
+  if (ob->node < 0) {
+    sprintf(StrBuffer, "Disconnected(%d)", ob->node);
+    return(StrBuffer);
+  }
+  CheckNodeNames(tp);
+  if (tp->nodename_cache == NULL || ob->node > tp->nodename_cache_size ||
+	tp->nodename_cache[ob->node] == NULL)
+    return(ob->name);
+  return (tp->nodename_cache[ob->node]->name);
 }
 
 void FreeNodeNames(struct nlist *tp)
 {
   if (tp == NULL) return;
+  FreeConnIndex(tp);
   if (tp->nodename_cache != NULL)
     FREE(tp->nodename_cache);
   tp->nodename_cache = NULL;
   tp->nodename_cache_maxnodenum = 0;
+  tp->nodename_cache_size = 0;
+  tp->nodename_cache_stale = 0;
 }
 
 void CacheNodeNames(struct nlist *tp)
@@ -1439,7 +1693,7 @@ void CacheNodeNames(struct nlist *tp)
   struct objlist *ob;
 
   if (tp == NULL) return;
-  if (tp->nodename_cache != NULL) FreeNodeNames(tp);
+  FreeNodeNames(tp);
   nodes = 0;
 
   for (ob = tp->cell; ob != NULL; ob = ob->next)
@@ -1451,39 +1705,163 @@ void CacheNodeNames(struct nlist *tp)
     (struct objlist **)CALLOC(nodes+1, sizeof(*(tp->nodename_cache)));
   if (tp->nodename_cache == NULL) return;
   tp->nodename_cache_maxnodenum = nodes;
+  tp->nodename_cache_size = nodes;
 
   for (ob = tp->cell; ob != NULL; ob = ob->next) {
-    int present, new_type;
-
     if (ob->node < 0) continue;  /* do not cache it */
-    if ((tp->nodename_cache)[ob->node] == NULL) 
+    if (((tp->nodename_cache)[ob->node] == NULL) || 
+		NodeNamePreferred((tp->nodename_cache)[ob->node], ob))
       (tp->nodename_cache)[ob->node] = ob;
+  }
+}
 
-    present = ((tp->nodename_cache)[ob->node])->type;
-    new_type = ob->type;
+/* Make room in the cache for node number "node".  The cache grows	*/
+/* geometrically, so its size can exceed the largest node number.	*/
 
-    if (new_type == present) continue;
-    if (new_type >= FIRSTPIN && present >= FIRSTPIN) continue;
+static void NodeNameGrow(struct nlist *tp, int node)
+{
+  struct objlist **newcache;
+  long newsize;
+
+  if (node > tp->nodename_cache_maxnodenum)
+    tp->nodename_cache_maxnodenum = node;
+  if (node <= tp->nodename_cache_size) return;
+
+  newsize = tp->nodename_cache_size;
+  while (newsize < node) newsize = 2 * newsize + 1;
+  newcache = (struct objlist **)CALLOC(newsize + 1,
+		sizeof(*(tp->nodename_cache)));
+  memcpy(newcache, tp->nodename_cache, (tp->nodename_cache_size + 1)
+		* sizeof(*(tp->nodename_cache)));
+  FREE(tp->nodename_cache);
+  tp->nodename_cache = newcache;
+  tp->nodename_cache_size = newsize;
+}
 
-    switch (new_type) {
-    case PORT: 
-      (tp->nodename_cache)[ob->node] = ob;
-      break;
-    case NODE:
-      if (present != PORT)
-	(tp->nodename_cache)[ob->node] = ob;
-      break;
-    case UNIQUEGLOBAL:
-      if (present != PORT && present != NODE)
-	(tp->nodename_cache)[ob->node] = ob;
-      break;
-    case GLOBAL:
-      if (present != PORT && present != NODE && present != UNIQUEGLOBAL)
-	(tp->nodename_cache)[ob->node] = ob;
-      break;
-    default:   /* we have a pin or property, which we can ignore */
-      break;
+/* Object "ob" has been added to cell "tp" or given a new node number */
+
+void NodeNameAdd(struct nlist *tp, struct objlist *ob)
+{
+  if (tp == NULL) return;
+  if (tp->connindex != NULL) FreeConnIndex(tp);
+  if (tp->nodename_cache == NULL || ob->node < 0) return;
+  if (ob->node > tp->nodename_cache_maxnodenum) NodeNameGrow(tp, ob->node);
+  if (((tp->nodename_cache)[ob->node] == NULL) ||
+		NodeNamePreferred((tp->nodename_cache)[ob->node], ob))
+    (tp->nodename_cache)[ob->node] = ob;
+}
+
+/* All objects on node "oldnode" of cell "tp" have been moved to "node" */
+
+void NodeNameMerge(struct nlist *tp, int node, int oldnode)
+{
+  struct objlist *ob;
+
+  if (tp == NULL) return;
+  if (tp->connindex != NULL) FreeConnIndex(tp);
+  if (tp->nodename_cache == NULL) return;
+  if (oldnode < 0 || oldnode > tp->nodename_cache_size) return;
+  ob = (tp->nodename_cache)[oldnode];
+  (tp->nodename_cache)[oldnode] = NULL;
+  if (ob == NULL || node < 0) return;
+  if (node > tp->nodename_cache_maxnodenum) NodeNameGrow(tp, node);
+  if (((tp->nodename_cache)[node] == NULL) ||
+		NodeNamePreferred((tp->nodename_cache)[node], ob))
+    (tp->nodename_cache)[node] = ob;
+}
+
+/* Object "ob" is about to be removed from cell "tp".  If it names	*/
+/* its node, the next best name is found when the cache is next used.	*/
+
+void NodeNameRemove(struct nlist *tp, struct objlist *ob)
+{
+  if (tp == NULL) return;
+  if (tp->connindex != NULL) FreeConnIndex(tp);
+  if (tp->nodename_cache == NULL) return;
+  if (ob->node < 0 || ob->node > tp->nodename_cache_size) return;
+  if ((tp->nodename_cache)[ob->node] == ob) {
+    (tp->nodename_cache)[ob->node] = NULL;
+    tp->nodename_cache_stale = 1;
+  }
+}
+
+/* Each cell may also keep an index from node numbers to the objects	*/
+/* on them, so that interactive queries on large cells take time in	*/
+/* proportion to their result.  The index is built on first use and	*/
+/* discarded along with the node name cache.				*/
+
+void FreeConnIndex(struct nlist *tp)
+{
+  struct connindex *ci;
+
+  if (tp == NULL || tp->connindex == NULL) return;
+  ci = tp->connindex;
+  if (ci->start != NULL) FREE(ci->start);
+  if (ci->obj != NULL) FREE(ci->obj);
+  if (ci->named != NULL) FREE(ci->named);
+  if (ci->types != NULL) FREE(ci->types);
+  FREE(ci);
+  tp->connindex = NULL;
+}
+
+/* Return the connectivity index of cell "tp", building it if needed.	*/
+/* Returns NULL if out of memory.					*/
+
+struct connindex *ConnIndex(struct nlist *tp)
+{
+  struct connindex *ci;
+  struct objlist *ob;
+  int maxnode, count, node;
+
+  if (tp == NULL) return NULL;
+  if (tp->connindex != NULL) return tp->connindex;
+
+  maxnode = 0;
+  count = 0;
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->node < 0) continue;
+    if (ob->node > maxnode) maxnode = ob->node;
+    count++;
+  }
+
+  ci = (struct connindex *)CALLOC(1, sizeof(struct connindex));
+  if (ci == NULL) return NULL;
+  ci->maxnode = maxnode;
+  ci->start = (int *)CALLOC(maxnode + 2, sizeof(int));
+  ci->obj = (struct objlist **)CALLOC(count + 1, sizeof(struct objlist *));
+  ci->named = (struct objlist **)CALLOC(maxnode + 1, sizeof(struct objlist *));
+  ci->types = (unsigned char *)CALLOC(maxnode + 1, sizeof(unsigned char));
+  tp->connindex = ci;
+  if (ci->start == NULL || ci->obj == NULL || ci->named == NULL ||
+		ci->types == NULL) {
+    FreeConnIndex(tp);
+    return NULL;
+  }
+
+  /* Count the objects on each node, then place them in cell order */
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->node < 0) continue;
+    ci->start[ob->node + 1]++;
+  }
+  for (node = 0; node <= maxnode; node++)
+    ci->start[node + 1] += ci->start[node];
+
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->node < 0) continue;
+    node = ob->node;
+    ci->obj[ci->start[node]++] = ob;
+    switch (ob->type) {
+      case NODE: ci->types[node] |= NET_NODE; break;
+      case PORT: ci->types[node] |= NET_PORT; break;
+      case GLOBAL: ci->types[node] |= NET_GLOBAL; break;
+      case UNIQUEGLOBAL: ci->types[node] |= NET_UNIQUEGLOBAL; break;
+      default: continue;
     }
+    if (ci->named[node] == NULL) ci->named[node] = ob;
   }
+  for (node = maxnode; node > 0; node--)
+    ci->start[node] = ci->start[node - 1];
+  ci->start[0] = 0;
+  return ci;
 }
 
@@ -95,6 +95,7 @@ struct keyvalue {
 struct valuelist {
   char *key;
   unsigned char type;		/* string, integer, double, value, expression */
+  unsigned short pindex;	/* cached index of key in cell propindex */
   union {
      char *string;
      double dval;
@@ -135,6 +136,7 @@ struct property {
   unsigned char idx;		/* index into valuelist */
   unsigned char type;		/* string, integer, double, value, expression */
   unsigned char merge;		/* how property changes when devices are merged */
+  unsigned short pindex;	/* index into cell propindex (0 = none) */
   char *pin;			/* associated pin (or NULL if not associated)	*/
   union {
      char *string;
@@ -199,6 +201,23 @@ struct Permutation {
 #define OBJHASHSIZE 42073 /* the size of the object and instance hash lists */
                         /* prime numbers are good choices as hash sizes */
 
+/* Connectivity index of a cell, built on demand by ConnIndex().  The	*/
+/* objects on node n are obj[start[n]] to obj[start[n + 1] - 1], in	*/
+/* the order in which they appear in the cell.				*/
+
+struct connindex {
+    int maxnode;
+    int *start;
+    struct objlist **obj;
+    struct objlist **named;	/* first node, port or global on each node */
+    unsigned char *types;	/* NET_* bits of the objects on each node */
+};
+
+#define NET_NODE		0x01
+#define NET_PORT		0x02
+#define NET_GLOBAL		0x04
+#define NET_UNIQUEGLOBAL	0x08
+
 /* cell definition for hash table */
 /* NOTE: "file" must come first for the hash matching by name and file */
 
@@ -215,8 +234,14 @@ struct nlist {
   struct hashdict objdict;  /* hash table of object names */
   struct hashdict instdict; /* hash table of instance names */
   struct hashdict propdict; /* hash table of property keys */
+  struct property **propindex;	/* property records by index (see pindex) */
+  int propcount;		/* number of entries in propindex */
+  int propalloc;		/* allocated size of propindex */
   struct objlist **nodename_cache;
-  long nodename_cache_maxnodenum;  /* largest node number in cache */
+  long nodename_cache_maxnodenum;  /* largest node number in cell */
+  long nodename_cache_size;	/* largest node number cache can hold */
+  unsigned char nodename_cache_stale;  /* cache needs rebuilding */
+  struct connindex *connindex;	/* node to object index, or NULL */
   void *embedding;   /* this will be cast to the appropriate data structure */
   struct nlist *next;
 };
@@ -230,6 +255,7 @@ struct nlist {
 #define CELL_PROPSMATCHED	0x010	/* properties matched to matching cell */
 #define CELL_DUPLICATE		0x020	/* cell has a duplicate */
 #define CELL_VERILOG		0x040	/* cell is verilog module */
+#define CELL_LIBRARY		0x080	/* cell is a read-only library cell */
 
 /* Flags for combination allowances and prohibitions */
 
@@ -244,6 +270,7 @@ extern void AddInstanceToCurrentCell(struct objlist *ob);
 extern void FreeObject(struct objlist *ob);
 extern void FreeObjectAndHash(struct objlist *ob, struct nlist *ptr);
 extern void FreePorts(char *cellname);
+extern void FreePortsFile(char *cellname, int fnum);
 extern struct IgnoreList *ClassIgnore;
 
 extern int NumberOfPorts(char *cellname, int file);
@@ -269,6 +296,9 @@ extern void PrintCellHashTable(int full, int file);
 extern struct nlist *LookupCell(char *s);
 extern struct nlist *LookupCellFile(char *s, int f);
 extern struct nlist *InstallInCellHashTable(char *name, int f);
+extern struct nlist *LookupLibraryCell(char *s, int *count);
+extern int CellFileIsLibrary(int fnum);
+extern void CellSetLibrary(int fnum, int library);
 extern void InitCellHashTable(void);
 extern void ClearDumpedList(void);
 extern int RecurseCellHashTable(int (*foo)(struct hashlist *np));
@@ -282,6 +312,12 @@ extern char *NodeName(struct nlist *tp, int node);
 extern char *NodeAlias(struct nlist *tp, struct objlist *ob);
 extern void FreeNodeNames(struct nlist *tp);
 extern void CacheNodeNames(struct nlist *tp);
+extern void CheckNodeNames(struct nlist *tp);
+extern void NodeNameAdd(struct nlist *tp, struct objlist *ob);
+extern void NodeNameMerge(struct nlist *tp, int node, int oldnode);
+extern void NodeNameRemove(struct nlist *tp, struct objlist *ob);
+extern struct connindex *ConnIndex(struct nlist *tp);
+extern void FreeConnIndex(struct nlist *tp);
 
 
 /* enable the following line to debug the core allocator */
@@ -296,8 +332,10 @@ extern void FreeString(char *foo);
 extern char *strsave(char *s);
 #else /* not DEBUG_GARBAGE */
 #define GetObject() ((struct objlist*)CALLOC(1,sizeof(struct objlist)))
-#define NewProperty() ((struct property*)CALLOC(1,sizeof(struct property)))
-#define NewPropValue(a) ((struct valuelist*)CALLOC((a),sizeof(struct valuelist)))
+#define NewProperty() ((struct property*)CALLOCTAG(1,sizeof(struct property), \
+		MEM_PROPERTY))
+#define NewPropValue(a) ((struct valuelist*)CALLOCTAG((a), \
+		sizeof(struct valuelist), MEM_PROPERTY))
 #define NewKeyValue() ((struct keyvalue*)CALLOC(1,sizeof(struct keyvalue)))
 #define FreeString(a) (FREE(a))
 #define strsave(a) (STRDUP(a))
@@ -313,6 +351,7 @@ extern int  is_delimiter(char);
 extern char *get_array_delimiter(char *, char *);
 
 extern void GarbageCollect(void);
+extern void FreeGarbageList(void);
 extern void InitGarbageCollection(void);
 extern void AddToGarbageList(struct objlist *head);
 
@@ -329,9 +368,8 @@ extern void CellRehash(char *name, char *newname, int file);
 /* defined in netgen.c */
 extern int ConvertStringToInteger(char *string, int *ival);
 
-#ifdef HAVE_MALLINFO
-void PrintMemoryStats(void);
-#endif
+/* defined in memstats.c */
+extern void PrintMemoryStats(void);
 
 #endif  /* _OBJLIST_H */
 
@@ -48,31 +48,39 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #define IA 1366
 #define IC 150889L
 
-static long idum = -1;  /* needs to be initialized to avoid seg fault if 0 */
+/* The generator state is kept in a struct randomstate so that		*/
+/* independent streams (e.g., one per annealing chain) can run side	*/
+/* by side.  Random(), RandomUniform() and RandomSeed() use a single	*/
+/* default stream.							*/
 
-float ran2(void)
+static struct randomstate defaultstate = {-1, 0, {0}, 0};
+	/* idum needs to be initialized to avoid seg fault if 0 */
+
+static float ran2r(struct randomstate *rs)
 {
-	static long iy,ir[98];
-	static int iff=0;
 	int j;
-	void nrerror();
 
-	if (idum < 0 || iff == 0) {
-		iff=1;
-		if ((idum=(IC-(idum)) % M) < 0) idum = -idum;
+	if (rs->idum < 0 || rs->iff == 0) {
+		rs->iff=1;
+		if ((rs->idum=(IC-(rs->idum)) % M) < 0) rs->idum = -rs->idum;
 		for (j=1;j<=97;j++) {
-			idum=(IA*idum+IC) % M;
-			ir[j]=idum;
+			rs->idum=(IA*rs->idum+IC) % M;
+			rs->ir[j]=rs->idum;
 		}
-		idum=(IA*idum+IC) % M;
-		iy=idum;
+		rs->idum=(IA*rs->idum+IC) % M;
+		rs->iy=rs->idum;
 	}
-	j=(int)(1 + 97.0*iy/M); /* the cast was added by Glenn for C++ */
+	j=(int)(1 + 97.0*rs->iy/M); /* the cast was added by Glenn for C++ */
 	if (j > 97 || j < 1) perror("RAN2: This cannot happen.");
-	iy=ir[j];
-	idum=(IA*idum+IC) % M;
-	ir[j]=idum;
-	return (float) iy/M;
+	rs->iy=rs->ir[j];
+	rs->idum=(IA*rs->idum+IC) % M;
+	rs->ir[j]=rs->idum;
+	return (float) rs->iy/M;
+}
+
+float ran2(void)
+{
+	return ran2r(&defaultstate);
 }
 
 #undef M
@@ -98,19 +106,36 @@ int Random(int max)
 
 long RandomSeed(long seed)
 /* initialize idum to some negative integer */
+{
+	return RandomStateSeed(&defaultstate, seed);
+}
+
+float RandomUniform(void)
+{
+	return(ran2());
+}
+
+long RandomStateSeed(struct randomstate *rs, long seed)
+/* initialize the stream 'rs'; returns its previous idum */
 {
 	long oldidum;
 
-	oldidum = idum;
+	oldidum = rs->idum;
 	if (seed == 0) seed = -1;
 	if (seed > 0) seed = -seed;
-	idum = seed;
+	rs->idum = seed;
+	rs->iff = 0;
 	return(oldidum);
 }
 
-float RandomUniform(void)
+int RandomState(struct randomstate *rs, int max)
 {
-	return(ran2());
+  return(ran2r(rs) * max);
+}
+
+float RandomStateUniform(struct randomstate *rs)
+{
+	return(ran2r(rs));
 }
 
 /*************************************************************************/
@@ -5,6 +5,18 @@ extern float RandomUniform(void);
 extern long RandomSeed(long seed);
 extern int Random(int max);
 
+/* independent random number streams */
+struct randomstate {
+  long idum;
+  long iy;
+  long ir[98];
+  int iff;
+};
+
+extern long RandomStateSeed(struct randomstate *rs, long seed);
+extern int RandomState(struct randomstate *rs, int max);
+extern float RandomStateUniform(struct randomstate *rs);
+
 #ifdef NEED_STRING
 extern char *strtok(char *s, char *delim);
 extern int strcspn(char *s, char *reject);
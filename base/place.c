@@ -60,15 +60,24 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 int CountAnyCommonNodes;
 
 
-/* abridged ownership and connectivity matrices */
+/* abridged ownership matrices, grown as elements are added */
 /* elements, nodes, leaves are indexed from 1 to N, nodes, leaves */
-unsigned short M[MAX_ELEMENTS][7];  
+int (*M)[7] = NULL;
 /* height, L, R, SWALLOWED, PINS, LEAVES, USED */
 
-unsigned long MSTAR[MAX_ELEMENTS][(MAX_LEAVES / BITS_PER_LONG)  + 1];
+unsigned long (*MSTAR)[MSTARWORDS] = NULL;
 
-unsigned char C[MAX_ELEMENTS][MAX_NODES + 1];
-unsigned char CSTAR[MAX_ELEMENTS][MAX_NODES + 1];
+/* sparse connectivity rows (see embed.h) */
+struct conn *Conn = NULL;
+int *ConnStart = NULL;
+unsigned char *PortNodes = NULL;
+int *NodeUsage = NULL;
+unsigned long *PinBits = NULL;
+int PinWords = 0;	/* words per element in PinBits */
+
+int MaxElements = 0;	/* rows allocated in M and MSTAR */
+int MaxConn = 0;	/* entries allocated in Conn */
+int ElementLimit = 5000; /* most elements in one embedding, 0 = no limit */
 
 /* elements at level i must have TreeFanout[i] or fewer ports */
 int TreeFanout[MAX_TREE_DEPTH + 1];       /* tree fanout at each level */
@@ -93,6 +102,7 @@ int selectivelogging = 0;
 int LogLevel1 = -1; /* automatically log if Level1 == LogLevel1 */
 int LogLevel2 = -1;
 int FatalError = 0; /* internal error */
+int LimitReached = 0; /* embedding stopped at ElementLimit */
 int Exhaustive = 0; /* slow, methodical */
 int PlaceDebug = 0; /* interactive debug */
 
@@ -161,11 +171,115 @@ int RenumberNodes(char *cellname)
 }
 
 void EraseMatrices(void)
+/* free the matrices of the last cell embedded */
+{
+  if (M != NULL) FREE(M);
+  if (MSTAR != NULL) FREE(MSTAR);
+  if (ConnStart != NULL) FREE(ConnStart);
+  if (Conn != NULL) FREE(Conn);
+  if (PortNodes != NULL) FREE(PortNodes);
+  if (NodeUsage != NULL) FREE(NodeUsage);
+  if (PinBits != NULL) FREE(PinBits);
+  if (leftnodes != NULL) FREE(leftnodes);
+  if (rightnodes != NULL) FREE(rightnodes);
+  M = NULL;
+  MSTAR = NULL;
+  ConnStart = NULL;
+  Conn = NULL;
+  PortNodes = NULL;
+  NodeUsage = NULL;
+  PinBits = NULL;
+  leftnodes = rightnodes = NULL;
+  MaxElements = MaxConn = 0;
+}
+
+static int GrowElements(int E)
+/* make room for elements 0 to E; returns 0 if out of memory */
+{
+  int newmax;
+  int (*newM)[7];
+  unsigned long (*newMSTAR)[MSTARWORDS];
+  int *newstart;
+  unsigned long *newbits;
+
+  if (E < MaxElements) return(1);
+  newmax = (MaxElements == 0) ? 1024 : MaxElements;
+  while (newmax <= E) newmax *= 2;
+
+  newM = CALLOC(newmax, sizeof(*M));
+  newMSTAR = CALLOC(newmax, sizeof(*MSTAR));
+  newstart = CALLOC(newmax + 1, sizeof(int));
+  newbits = CALLOC(newmax * PinWords, sizeof(unsigned long));
+  if (newM == NULL || newMSTAR == NULL || newstart == NULL
+	|| newbits == NULL) {
+    if (newM != NULL) FREE(newM);
+    if (newMSTAR != NULL) FREE(newMSTAR);
+    if (newstart != NULL) FREE(newstart);
+    if (newbits != NULL) FREE(newbits);
+    return(0);
+  }
+  if (MaxElements > 0) {
+    memcpy(newM, M, MaxElements * sizeof(*M));
+    memcpy(newMSTAR, MSTAR, MaxElements * sizeof(*MSTAR));
+    memcpy(newstart, ConnStart, (MaxElements + 1) * sizeof(int));
+    memcpy(newbits, PinBits, MaxElements * PinWords * sizeof(unsigned long));
+    FREE(M);
+    FREE(MSTAR);
+    FREE(ConnStart);
+    FREE(PinBits);
+  }
+  M = newM;
+  MSTAR = newMSTAR;
+  ConnStart = newstart;
+  PinBits = newbits;
+  MaxElements = newmax;
+  return(1);
+}
+
+static int GrowConn(int entries)
+/* make room for 'entries' entries in Conn; returns 0 if out of memory */
 {
-  memzero(C, sizeof(C));
-  memzero(CSTAR, sizeof(CSTAR));
-  memzero(M, sizeof(M));
-  memzero(MSTAR, sizeof(MSTAR));
+  int newmax;
+  struct conn *newconn;
+
+  if (entries <= MaxConn) return(1);
+  newmax = (MaxConn == 0) ? 4096 : MaxConn;
+  while (newmax < entries) newmax *= 2;
+
+  newconn = CALLOC(newmax, sizeof(struct conn));
+  if (newconn == NULL) return(0);
+  if (MaxConn > 0) {
+    memcpy(newconn, Conn, MaxConn * sizeof(struct conn));
+    FREE(Conn);
+  }
+  Conn = newconn;
+  MaxConn = newmax;
+  return(1);
+}
+
+static int conncmp(const void *a, const void *b)
+{
+  return(((struct conn *)a)->node - ((struct conn *)b)->node);
+}
+
+static void CloseLeafRow(int E, int end)
+/* sort the entries of leaf E, which end at 'end', merging repeated nodes */
+{
+  int j, k;
+
+  qsort(Conn + FIRSTCONN(E), end - FIRSTCONN(E), sizeof(struct conn),
+	conncmp);
+  j = FIRSTCONN(E);
+  for (k = FIRSTCONN(E); k < end; k++) {
+    if (j > FIRSTCONN(E) && Conn[j - 1].node == Conn[k].node)
+      Conn[j - 1].usage += Conn[k].usage;
+    else {
+      SetPackedArrayBit(PINBITS(E), Conn[k].node);
+      Conn[j++] = Conn[k];
+    }
+  }
+  ENDCONN(E) = j;
+  PINS(E) = j - FIRSTCONN(E);  /* every node of a leaf is one of its pins */
 }
 
 int InitializeMatrices(char *cellname)
@@ -173,35 +287,37 @@ int InitializeMatrices(char *cellname)
 {
   struct nlist *tp;
   struct objlist *ob;
-  int i, j;
+  int i, j, k, pins;
 
   tp = LookupCell(cellname);
   if (tp == NULL) return(0);
   if (tp->class != CLASS_SUBCKT) return(0);
 
-  if ((Nodes = RenumberNodes(cellname)) > MAX_NODES) {
-    Fprintf(stderr,"Too many nodes in cell: %s (%d > MAX_NODES(%d))\n",
-	    cellname, Nodes, MAX_NODES);
+  Nodes = RenumberNodes(cellname);
+  EraseMatrices();
+  LimitReached = 0;
+
+  PortNodes = CALLOC(Nodes + 1, sizeof(unsigned char));
+  NodeUsage = CALLOC(Nodes + 1, sizeof(int));
+  leftnodes = CALLOC(Nodes + 1, sizeof(int));
+  rightnodes = CALLOC(Nodes + 1, sizeof(int));
+  if (PortNodes == NULL || NodeUsage == NULL || leftnodes == NULL
+	|| rightnodes == NULL) {
+    Fprintf(stderr, "Not enough memory to embed cell: %s\n", cellname);
     return(0);
   }
-  EraseMatrices();  /* all elements are set to 0 */
 
-  /* create connectivity matrix C */
+  /* count leaves and pins, and find the total usage of each node */
   Leaves = 0;
+  pins = 0;
   for (ob = tp->cell; ob != NULL; ob = ob->next) {
-    if (ob->type == FIRSTPIN) {
-      struct nlist *tp;
-
-      Leaves++;
-      if (Leaves > MAX_LEAVES) continue; /* keep going within the for loop */
-
-      tp = LookupCell(ob->model.class);
-      if (tp == NULL || (tp->class != CLASS_SUBCKT) || tp->embedding == NULL)
-	LEVEL(Leaves) = 0;
-      else LEVEL(Leaves) = ((struct embed *)(tp->embedding))->level;
-      /* remember, L(Leaves) = R(Leaves) = 0 by EraseMatrices above */
+    if (ob->type == FIRSTPIN) Leaves++;
+    if (ob->type >= FIRSTPIN && ob->node > 0) {
+      NodeUsage[ob->node]++;
+      pins++;
     }
-    if (ob->type >= FIRSTPIN) C[Leaves][ob->node] = 1;
+    /* the port list of the entire cell */
+    if (IsPortInPortlist(ob, tp) && ob->node > 0) PortNodes[ob->node] = 1;
   }
   if (Leaves > MAX_LEAVES) {
     Fprintf(stderr, "Too many leaves in cell: %s (%d > MAX_LEAVES(%d))\n",
@@ -209,15 +325,54 @@ int InitializeMatrices(char *cellname)
     return(0);
   }
   PackedLeaves = Leaves / BITS_PER_LONG;
+  PinWords = Nodes / BITS_PER_LONG + 1;
+  for (j = 1; j <= Nodes; j++)
+    if (PortNodes[j]) NodeUsage[j]++;  /* increment usage of ports */
 
-  /* row 0 of C is special, containing the port list of the entire cell */
-  for (ob = tp->cell; ob != NULL; ob = ob->next) 
-    if (IsPortInPortlist(ob, tp)) C[0][ob->node] = 1;
+  if (!GrowElements(2 * Leaves) || !GrowConn(Nodes + pins)) {
+    Fprintf(stderr, "Not enough memory to embed cell: %s\n", cellname);
+    return(0);
+  }
 
-  /* matrix M partially init. by EraseMatrices, and by Leaves loop above; */
-  /* column PINS of matrix M is special, containing fanout of each element */
-  for (i = 0; i <= Leaves; i++) 
-    for (j = 1; j <= Nodes; j++) PINS(i) += C[i][j];
+  /* row 0 is special, containing every node and the port list of the cell */
+  k = 0;
+  for (j = 1; j <= Nodes; j++) {
+    if (NodeUsage[j] == 0) continue;
+    Conn[k].node = j;
+    Conn[k].usage = NodeUsage[j];
+    Conn[k].pin = PortNodes[j];
+    if (PortNodes[j]) {
+      SetPackedArrayBit(PINBITS(0), j);
+      PINS(0)++;
+    }
+    k++;
+  }
+  ENDCONN(0) = k;
+
+  /* create the connectivity rows of the leaves */
+  i = 0;
+  for (ob = tp->cell; ob != NULL; ob = ob->next) {
+    if (ob->type == FIRSTPIN) {
+      struct nlist *tp;
+
+      if (i > 0) CloseLeafRow(i, k);
+      i++;
+      k = FIRSTCONN(i);
+
+      tp = LookupCell(ob->model.class);
+      if (tp == NULL || (tp->class != CLASS_SUBCKT) || tp->embedding == NULL)
+	LEVEL(i) = 0;
+      else LEVEL(i) = ((struct embed *)(tp->embedding))->level;
+      /* remember, L(i) = R(i) = 0 since the matrices were just allocated */
+    }
+    if (ob->type >= FIRSTPIN && ob->node > 0) {
+      Conn[k].node = ob->node;
+      Conn[k].usage = 1;
+      Conn[k].pin = 1;
+      k++;
+    }
+  }
+  if (i > 0) CloseLeafRow(i, k);
 
   /* initialize the number of leaves contained by each element */
   LEAVES(0) = Leaves;
@@ -229,32 +384,49 @@ int InitializeMatrices(char *cellname)
   for (i = 1; i <= Leaves; i++)  /* used to be i = 0 ??? */
     SetPackedArrayBit(MSTAR[0],i); /* portlist owns all leaves */
 
-  /* create nodal connectivity transitive closure matrix CSTAR */
-  i = 0;
-  for (ob = tp->cell; ob != NULL; ob = ob->next) {
-    if (ob->type == FIRSTPIN) i++;
-    if (ob->type >= FIRSTPIN) CSTAR[i][ob->node]++;
-  }
-  for (j = 1; j <= Nodes; j++){
-    CSTAR[0][j] = 0;
-    for (i = 1; i <= Leaves; i++) CSTAR[0][j] += CSTAR[i][j];
-    if (C[0][j]) CSTAR[0][j]++;  /* increment usage of ports */
-  }
-
   /* initially, number of elements == number of leaves */
   Elements = Leaves;
   return(1);
 }
 
+struct conn *FindConn(int E, int node)
+/* return the entry for 'node' in the row of element E, or NULL */
+{
+  int lo, hi, mid;
+
+  lo = FIRSTCONN(E);
+  hi = ENDCONN(E) - 1;
+  while (lo <= hi) {
+    mid = (lo + hi) / 2;
+    if (Conn[mid].node == node) return(Conn + mid);
+    if (Conn[mid].node < node) lo = mid + 1;
+    else hi = mid - 1;
+  }
+  return(NULL);
+}
+
+int ConnUsage(int E, int node)
+/* return the number of leaf pins of element E on 'node' */
+{
+  struct conn *cp;
+
+  cp = FindConn(E, node);
+  return((cp == NULL) ? 0 : cp->usage);
+}
+
 void PrintC(FILE *outfile)
 {
   int i, j;
+  struct conn *cp;
 
 	if (outfile == NULL) return;
 	Fprintf(outfile,"C:\n");
 	for (i = 0; i <= Elements; i++) {
 		Fprintf(outfile,"%4d: %3d | ",i,PINS(i));
-		for (j = 1; j <= Nodes; j++) Fprintf(outfile," %d",C[i][j]);
+		for (j = 1; j <= Nodes; j++) {
+			cp = FindConn(i, j);
+			Fprintf(outfile," %d",(cp == NULL) ? 0 : cp->pin);
+		}
 		Fprintf(outfile,"\n");
 	}
 	Fprintf(outfile,"\n");
@@ -268,7 +440,7 @@ void PrintCSTAR(FILE *outfile)
 	Fprintf(outfile,"C*:\n");
 	for (i = 0; i <= Elements; i++) {
 		Fprintf(outfile,"%4d: ",i);
-		for (j=1; j <= Nodes; j++) Fprintf(outfile,"%3d",CSTAR[i][j]);
+		for (j=1; j <= Nodes; j++) Fprintf(outfile,"%3d",ConnUsage(i,j));
 		Fprintf(outfile,"\n");
 	}
 	Fprintf(outfile,"\n");
@@ -326,20 +498,35 @@ int UsedLeaves(int E1, int E2)
 #endif
 
 
+#ifndef __GNUC__
+int BitCount(unsigned long w)
+/* number of bits set in w */
+{
+  int count;
+
+  for (count = 0; w != 0; count++) w &= w - 1;
+  return(count);
+}
+#endif
+
 int CommonNodes(int E1, int E2, int IncludeGlobals)
 /* returns the number of nodes that E1 and E2 share */
 /* if IncludeGlobals == 0, do not count large connectivity nodes */
 {
-  int result, node;
+  int result, i;
+  unsigned long *b1, *b2, *ports;
 	
+  b1 = PINBITS(E1);
+  b2 = PINBITS(E2);
+  ports = PINBITS(0);
   result = 0;
   if (IncludeGlobals) {
-    for (node = 1; node <= Nodes; node++) 
-      if (C[E1][node] && C[E2][node]) result++;
+    for (i = 0; i < PinWords; i++)
+      result += BitCount(b1[i] & b2[i]);
   }
   else {
-    for (node = 1; node <= Nodes; node++) 
-      if (C[E1][node] && C[E2][node] && !C[0][node]) result++;
+    for (i = 0; i < PinWords; i++)
+      result += BitCount(b1[i] & b2[i] & ~ports[i]);
   }
 #ifdef PLACE_DEBUG
   Printf("CommonNodes(%d,%d) (%s globals) gives %d\n",
@@ -352,12 +539,14 @@ int GlobalNodes(int E)
 /* return the number of global nodes that E contacts */
 /* for now, global nodes are just cell ports */
 {
-  int node;
+  int i;
   int count;
+  unsigned long *b, *ports;
 
+  b = PINBITS(E);
+  ports = PINBITS(0);
   count = 0;
-  for (node = 1; node <= Nodes; node++) 
-    if (C[E][node] && C[0][node]) count++;
+  for (i = 0; i < PinWords; i++) count += BitCount(b[i] & ports[i]);
   return(count);
 }
 
@@ -367,24 +556,26 @@ int AnyCommonNodes(int E1, int E2)
 /* if DISCOUNT_GLOBAL_NODES, do not count large connectivity nodes,
    unless these are the only connections */
 {
-  int node;
-  int nodesincommon;
+  int i;
+  unsigned long shared, local;
+  unsigned long *b1, *b2, *ports;
 
   CountAnyCommonNodes++;
-  nodesincommon = 0;
-  for (node = 1; node <= Nodes; node++) {
+  b1 = PINBITS(E1);
+  b2 = PINBITS(E2);
+  ports = PINBITS(0);
+  shared = local = 0;
+  for (i = 0; i < PinWords; i++) {
     /* do not count it if it is a port for the entire cell */
-    if (C[E1][node] && C[E2][node]) {
-      if (!(C[0][node])) return(1);
-      nodesincommon = 1;
-    }
+    if (b1[i] & b2[i] & ~ports[i]) return(1);
+    shared |= b1[i] & b2[i];
+    local |= (b1[i] | b2[i]) & ~ports[i];
   }
 
 #if 1
-  if (!nodesincommon) return(0);
+  if (!shared) return(0);
   /* if ANY nodes exist that are not ports, return NO_COMMON_NODES */
-  for (node = 1; node <= Nodes; node++) 
-    if ((C[E1][node] || C[E2][node]) && !(C[0][node])) return (0);
+  if (local) return(0);
 
   /* all nodes are global, and some are shared,  so return 1 */
   return(1);
@@ -401,12 +592,14 @@ int AnyCommonNodes(int E1, int E2)
 /* returns 1 if E1 and E2 share a node */
 /* any node, including a global node, is OK */
 {
-  int node;
-  int nodesincommon;
+  int i;
+  unsigned long *b1, *b2;
 
   CountAnyCommonNodes++;
-  for (node = 1; node <= Nodes; node++) 
-    if (C[E1][node] && C[E2][node]) return(1);
+  b1 = PINBITS(E1);
+  b2 = PINBITS(E2);
+  for (i = 0; i < PinWords; i++)
+    if (b1[i] & b2[i]) return(1);
   return(0);
 }
 #endif /* DISCOUNT_GLOBAL_NODES */
@@ -427,30 +620,67 @@ void IncrementUsedCount(int E)
 
 void AddNewElement(int E1, int E2)
 {
-  int i;
+  int i, k, k1, k2, end1, end2;
 	
   NewN++;
-  if (NewN >= MAX_ELEMENTS) {
+  if (ElementLimit > 0 && NewN >= ElementLimit) {
+    if (!LimitReached) {
+      Fprintf(stderr,"Element limit %d reached\n",ElementLimit);
+      if (outfile != NULL)
+	Fprintf(outfile,"Element limit %d reached\n",ElementLimit);
+    }
+    NewN--;
+    LimitReached = 1;
+    return;
+  }
+  end1 = ENDCONN(E1);
+  end2 = ENDCONN(E2);
+  if (!GrowElements(NewN) || !GrowConn(FIRSTCONN(NewN) +
+	(end1 - FIRSTCONN(E1)) + (end2 - FIRSTCONN(E2)))) {
     Fprintf(stderr,"Too many elements (%d)\n",NewN);
     if (outfile != NULL)
       Fprintf(outfile,"Too many elements (%d)\n",NewN);
+    NewN--;
+    FatalError = 1;
     return;
   }
   NewElements++;
 	
-  /* update ownership matrix */
+  /* update ownership matrix; the row may be left from a discarded element */
+  memzero(M[NewN], sizeof(M[NewN]));
+  memzero(PINBITS(NewN), PinWords * sizeof(unsigned long));
   LEVEL(NewN) = MAX(LEVEL(E1), LEVEL(E2)) + 1; 
   L(NewN) = E1; R(NewN) = E2;
-	
+		
   /* update leaf ownership matrix */
   for (i = 0; i <= PackedLeaves; i++)
     MSTAR[NewN][i] = MSTAR[E1][i] | MSTAR[E2][i];
 	
-  /* update connectivity matrix with actual portlist */
-  for (i = 1; i <= Nodes; i++) 
-    if ((C[E1][i] || C[E2][i]) &&
-	(CSTAR[E1][i] + CSTAR[E2][i] < CSTAR[0][i]))
-      C[NewN][i] = 1;
+  /* merge the rows of E1 and E2, summing node usage; a node is a port
+     of the new element unless all of its usage is inside the element */
+  k = FIRSTCONN(NewN);
+  k1 = FIRSTCONN(E1);
+  k2 = FIRSTCONN(E2);
+  while (k1 < end1 || k2 < end2) {
+    if (k2 == end2 || (k1 < end1 && Conn[k1].node < Conn[k2].node))
+      Conn[k] = Conn[k1++];
+    else if (k1 == end1 || Conn[k2].node < Conn[k1].node)
+      Conn[k] = Conn[k2++];
+    else {
+      Conn[k].node = Conn[k1].node;
+      Conn[k].usage = Conn[k1].usage + Conn[k2].usage;
+      Conn[k].pin = Conn[k1].pin || Conn[k2].pin;
+      k1++;
+      k2++;
+    }
+    if (Conn[k].usage >= NodeUsage[Conn[k].node]) Conn[k].pin = 0;
+    if (Conn[k].pin) {
+      SetPackedArrayBit(PINBITS(NewN), Conn[k].node);
+      PINS(NewN)++;
+    }
+    k++;
+  }
+  ENDCONN(NewN) = k;
 
   /* update number of leaves contained by new element */
   /* for (i = 1; i <= Leaves; i++) 
@@ -461,14 +691,9 @@ void AddNewElement(int E1, int E2)
   IncrementUsedCount(E1);
   IncrementUsedCount(E2); 
 
-  for (i = 1; i <= Nodes; i++) if (C[NewN][i]) PINS(NewN)++;
   SumPINS += PINS(NewN);
   SumCommonNodes += PINS(E1) + PINS(E2) - PINS(NewN);
   SumUsedLeaves += LEAVES(NewN);
-
-  /* update node usage matrix */
-  for (i = 1; i <= Nodes; i++)
-    CSTAR[NewN][i] = CSTAR[E1][i] + CSTAR[E2][i];
 	
   /* add to exist-checking data structure */
   AddToExistSet(E1, E2);
@@ -637,7 +862,6 @@ int CountSubGraphs(char *cellname)
   for (i = 1; i <= Leaves; i++) groups[i] = i;
 
   for (i = 1; i <= Leaves; i++) {
-    int node;
     int j;
     int mingroup;
 
@@ -645,12 +869,7 @@ int CountSubGraphs(char *cellname)
     contact[i] = 1;
     for (j = i + 1; j <= Leaves; j++) {
       /* else, find all elements that contact this node */
-      for (node = 1; node <= Nodes; node++) {
-    	if ((C[i][node] && C[j][node]) && !(C[0][node])) {
-	  contact[j] = 1;
-	  break;
-	}
-      }
+      if (CommonNodes(i, j, 0) > 0) contact[j] = 1;
     }
     mingroup = MAX_LEAVES+2;
     for (j = 1; j <= Leaves; j++) {
@@ -942,6 +1161,7 @@ void ProtoEmbed(char *name, char ch)
   if (toupper(ch) == 'G') strategy = greedy;
   if (toupper(ch) == 'O') strategy = bottomup;
   if (toupper(ch) == 'R') strategy = random_embedding;
+  if (toupper(ch) == 'K') strategy = multilevel;
   if (LookupCell(name) == NULL)
     Fprintf(stderr,"No cell '%s' found.\n",name);
   else {
@@ -955,8 +1175,13 @@ void ProtoPrintParameters(void)
   Printf("PROTOCHIP embedder compiled with:\n");
   Printf("MAX_LEAVES = %d; (MAX_TREE_DEPTH = %d)\n",
 	 MAX_LEAVES, MAX_TREE_DEPTH);
-  Printf("MAX_ELEMENTS = %d, MAX_NODES = %d\n",
-	 MAX_ELEMENTS, MAX_NODES);
+  Printf("Elements and nodes are allocated as needed.\n");
+  if (ElementLimit > 0)
+    Printf("Element limit = %d\n", ElementLimit);
+  else
+    Printf("No element limit\n");
+  Printf("Annealing starts = %d, threads = %d%s\n", AnnealStarts,
+	 AnnealThreads, (AnnealThreads == 0) ? " (one per processor)" : "");
 }
 
 void PROTOCHIP(void)
@@ -1073,11 +1298,26 @@ void PROTOCHIP(void)
     case 'g':
     case 'A':
     case 'a':
+    case 'K':
+    case 'k':
       promptstring("Cell to embed: ", name);
       ProtoEmbed(name, ch);
       break;
 #endif
 
+    case 'm':
+      promptstring("Number of annealing starts: ",name);
+      AnnealStarts = atoi(name);
+      if (AnnealStarts < 1) AnnealStarts = 1;
+      promptstring("Annealing threads (0 = one per processor): ",name);
+      AnnealThreads = atoi(name);
+      if (AnnealThreads < 0) AnnealThreads = 0;
+      break;
+    case 'n':
+      promptstring("Element limit (0 = no limit): ",name);
+      ElementLimit = atoi(name);
+      if (ElementLimit < 0) ElementLimit = 0;
+      break;
     case 's':
       promptstring("Cell to count sub-graphs: ",name);
       CountSubGraphs(name);
@@ -1238,6 +1478,9 @@ void PROTOCHIP(void)
       Printf("Embed: (e)mbed (E); (o)ld embed (O); e(x)haustive old embed\n");
       Printf("       (r)andom cut embedding algorithm\n");
       Printf("       (g)reedy embedding algorithm, simulated (a)nnealing\n");
+      Printf("       (m)ulti-start annealing: number of starts and threads\n");
+      Printf("       (n)umber of elements allowed in one embedding\n");
+      Printf("       multilevel (k)ernighan-Lin/FM partitioning\n");
       Printf("Embed parameters: (f)anout, (c)ommon nodes, leaf (C)ontainment.\n");
       Printf("                  Leaf (F)anout, Rent's rule e(X)ponent\n");
       Printf("(d)escribe cell; print (h)ash table (H); toggle primiti(v)e bit\n");
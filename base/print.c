@@ -23,6 +23,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include <stdio.h>
 #include <stdarg.h>  /* what about varargs support, as in pdutils.h ??? */
 #include <ctype.h>
+#include <pthread.h>
 
 #ifdef TCL_NETGEN
 #include <tcl.h>
@@ -33,6 +34,8 @@ void tcl_vprintf(FILE *, char *, va_list);
 extern int ColumnBase;
 #endif
 
+#include "print.h"
+
 #define MAXFILES 4
 
 struct filestr {
@@ -63,6 +66,77 @@ static int freefile(void)
 FILE *LoggingFile = NULL; /* if LoggingFile is non-null, write to it as well */
 int NoOutput = 0;         /* by default, we allow stdout to be printed */
 
+/* Output capture.  Printf() and Fprintf() are not thread-safe, so a	*/
+/* thread other than the main one must capture its output with		*/
+/* PrintCaptureStart() and leave it to the main thread to print the	*/
+/* captured text with PrintCaptureFlush().  The capture in effect is	*/
+/* kept per thread.							*/
+
+static pthread_key_t capturekey;
+static pthread_once_t captureonce = PTHREAD_ONCE_INIT;
+
+static void capturekeyinit(void)
+{
+  pthread_key_create(&capturekey, NULL);
+}
+
+void PrintCaptureStart(struct printcapture *pc)
+/* send this thread's output to pc, or print it again if pc is NULL */
+{
+  pthread_once(&captureonce, capturekeyinit);
+  pthread_setspecific(capturekey, pc);
+}
+
+static int capture(FILE *f, int isprintf, char *format, va_list ap)
+/* append the output to the capture of this thread, if there is one;
+   return 1 if the output was captured */
+{
+  struct printcapture *pc;
+  struct printseg *seg;
+  va_list aq;
+  int len;
+
+  pthread_once(&captureonce, capturekeyinit);
+  pc = (struct printcapture *)pthread_getspecific(capturekey);
+  if (pc == NULL) return(0);
+
+  va_copy(aq, ap);
+  len = vsnprintf(NULL, 0, format, aq);
+  va_end(aq);
+  if (len < 0) return(1);
+
+  seg = (struct printseg *)MALLOC(sizeof(struct printseg) + len);
+  if (seg == NULL) return(1);
+  seg->f = f;
+  seg->isprintf = isprintf;
+  seg->next = NULL;
+  vsnprintf(seg->text, len + 1, format, ap);
+  if (pc->last == NULL)
+    pc->first = seg;
+  else
+    pc->last->next = seg;
+  pc->last = seg;
+  return(1);
+}
+
+void PrintCaptureFlush(struct printcapture *pc, int print)
+/* print the output captured in pc if "print" is nonzero, and empty pc */
+{
+  struct printseg *seg, *next;
+
+  for (seg = pc->first; seg != NULL; seg = next) {
+    next = seg->next;
+    if (print) {
+      if (seg->isprintf)
+	Printf("%s", seg->text);
+      else
+	Fprintf(seg->f, "%s", seg->text);
+    }
+    FREE(seg);
+  }
+  pc->first = pc->last = NULL;
+}
+
 #ifdef HAVE_X11
 #include "xnetgen.h"
 
@@ -96,6 +170,10 @@ void Fprintf(FILE *f, char *format, ...)
   va_list ap;
 
   va_start(ap, format);
+  if (capture(f, 0, format, ap)) {
+    va_end(ap);
+    return;
+  }
   if (!NoOutput) tcl_vprintf(f, format, ap);
   if (LoggingFile != NULL) vfprintf(LoggingFile, format, ap);
   va_end(ap);
@@ -112,6 +190,10 @@ void Fprintf(FILE *f, char *format, ...)
   int linewrapexceeded;
 
   va_start(ap, format);
+  if (capture(f, 0, format, ap)) {
+    va_end(ap);
+    return;
+  }
   vsprintf(tmpstr, format, ap);
   va_end(ap);
 
@@ -194,7 +276,7 @@ void Printf(char *format, ...)
   va_list ap;
 
   va_start(ap, format);
-  tcl_vprintf(stdout, format, ap);
+  if (!capture(stdout, 1, format, ap)) tcl_vprintf(stdout, format, ap);
   va_end(ap);
 }
 
@@ -206,6 +288,10 @@ void Printf(char *format, ...)
   char tmpstr[MAX_STR_LEN];
 
   va_start(ap, format);
+  if (capture(stdout, 1, format, ap)) {
+    va_end(ap);
+    return;
+  }
   vsprintf(tmpstr, format, ap);
   va_end(ap);
 
@@ -262,6 +348,7 @@ void Ftab(FILE *f, int col)
        Fprintf(f, "%s", padding);
     else
        Printf("%s", padding);
+    FREE(padding);
 #else
     for (i = 0; i < col; i++)
       if (f)
@@ -1,3 +1,8 @@
+/* print.h -- formatted and buffered output */
+
+#ifndef _PRINT_H
+#define _PRINT_H
+
 extern void Fprintf(FILE *f, char *format, ...);
 extern void Printf(char *format, ...);
 extern int Fcursor(FILE *f);
@@ -10,3 +15,22 @@ extern void Finsert(FILE *f);
 
 extern FILE *LoggingFile;
 extern int NoOutput;
+
+/* Output captured from a thread, to be printed by the main thread */
+
+struct printseg {
+  FILE *f;
+  int isprintf;		/* written by Printf() rather than Fprintf() */
+  struct printseg *next;
+  char text[1];
+};
+
+struct printcapture {
+  struct printseg *first;
+  struct printseg *last;
+};
+
+extern void PrintCaptureStart(struct printcapture *pc);
+extern void PrintCaptureFlush(struct printcapture *pc, int print);
+
+#endif /* _PRINT_H */
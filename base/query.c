@@ -173,6 +173,7 @@ void Initialize(void)
   wasted = (char *)MALLOC(2);  /* need to initialize memory allocator */
 #endif
 
+  FreeExpressionCache();
   InitializeCommandLine(0, NULL);
 }
 
@@ -281,25 +282,55 @@ void PrintAllElements(char *cell, int filenum)
 /* a specific type of object (node, element, port, pin, etc.).	*/
 /*--------------------------------------------------------------*/
 
-void Fanout(char *cell, char *node, int filter)
+static void PrintFanoutObject(struct objlist *ob, int filter)
+{
+  char *obname = ob->name;
+
+  if (*obname == '/') obname++;
+  if (filter == ALLOBJECTS) {
+    Printf("  %s (", obname);
+    PrintObjectType(ob->type);
+    Printf(")\n");
+  }
+  else if ((filter == ALLELEMENTS) && (ob->type >= FIRSTPIN)) {
+    Printf("  %s\n", obname);
+  }
+  else if (ob->type == filter) {
+    Printf("  %s\n", obname);
+  }
+}
+
+void Fanout(char *cell, char *node, int filter, int fnum)
 {
   struct nlist *np;
   struct objlist *ob;
-  int nodenum;
+  struct connindex *ci;
+  int nodenum, i;
+
+  if ((fnum == -1) && (Circuit1 != NULL) && (Circuit2 != NULL)) {
+      Fanout(cell, node, filter, Circuit1->file);
+      Fanout(cell, node, filter, Circuit2->file);
+      return;
+  }
 
   if (*cell == '\0') np = CurrentCell;
-  else np = LookupCell(cell);
-	
+  else np = LookupCellFile(cell, fnum);
+
   if (np == NULL) {
     Printf("Cell '%s' not found.\n",cell);
     return;
   }
-	
+
   nodenum = -999;
-  for (ob = np->cell; ob != NULL; ob = ob->next) {
-    if ((*matchfunc)(node, ob->name)) {
-      nodenum = ob->node;
-      break;
+  ob = LookupObject(node, np);
+  if (ob != NULL)
+    nodenum = ob->node;
+  else {
+    for (ob = np->cell; ob != NULL; ob = ob->next) {
+      if ((*matchfunc)(node, ob->name)) {
+        nodenum = ob->node;
+        break;
+      }
     }
   }
 
@@ -315,36 +346,54 @@ void Fanout(char *cell, char *node, int filter)
     else
        Printf("Object");
     Printf (" '%s' in circuit '%s' connects to:\n", node, cell);
-    ob = np->cell;
-    while (ob != NULL) {
-      char *obname = ob->name;
-      if (*obname == '/') obname++;
-      if (ob->node == nodenum) {
-	 if (filter == ALLOBJECTS) {
-	   Printf("  %s (", obname);
-	   PrintObjectType(ob->type);
-	   Printf(")\n");
-	 }
-	 else if ((filter == ALLELEMENTS) && (ob->type >= FIRSTPIN)) {
-	   Printf("  %s\n", obname);
-	 }
-	 else if (ob->type == filter) {
-	   Printf("  %s\n", obname);
-	 }
-      }
-      ob = ob->next;
+    ci = ConnIndex(np);
+    if (ci != NULL && nodenum <= ci->maxnode) {
+      for (i = ci->start[nodenum]; i < ci->start[nodenum + 1]; i++)
+	PrintFanoutObject(ci->obj[i], filter);
+    }
+    else {
+      for (ob = np->cell; ob != NULL; ob = ob->next)
+	if (ob->node == nodenum) PrintFanoutObject(ob, filter);
     }
   }
 }
 	
 #ifdef TCL_NETGEN
 
+/* Print the net connected to pin "ob" of an element */
+
+static void PrintPinNet(struct nlist *np, struct objlist *ob, char *cell,
+		struct connindex *ci)
+{
+  struct objlist *nob;
+
+  if (ci != NULL && ob->node >= 0 && ob->node <= ci->maxnode)
+    nob = ci->named[ob->node];
+  else {
+    for (nob = np->cell; nob != NULL; nob = nob->next)
+      if (nob->node == ob->node && (nob->type == NODE || nob->type == PORT ||
+		nob->type == GLOBAL || nob->type == UNIQUEGLOBAL))
+	break;
+  }
+  if (nob == NULL) return;
+
+  if (nob->type == NODE)
+    Printf(" = %s", nob->name);
+  else if (nob->type == PORT)
+    Printf(" = %s (port of %s)", nob->name, cell);
+  else if (nob->type == GLOBAL)
+    Printf(" = %s (global)", nob->name);
+  else
+    Printf(" = %s (unique global)", nob->name);
+}
+
 /* Print the nodes connected to each pin of the specified element */
 
 void ElementNodes(char *cell, char *element, int fnum)
 {
   struct nlist *np;
-  struct objlist *ob, *nob, *nob2;
+  struct objlist *ob, *inst;
+  struct connindex *ci;
   int ckto;
   char *elementname, *obname;
 
@@ -367,21 +416,32 @@ void ElementNodes(char *cell, char *element, int fnum)
   elementname = element;
   if (*elementname == '/') elementname++;
 
+  /* An instance name leads directly to its pins; otherwise search	*/
+  /* for objects whose names begin with the element name.		*/
+
   ckto = strlen(elementname);
-  for (ob = np->cell; ob != NULL; ob = ob->next) {
-    obname = ob->name;
-    if (*obname == '/') obname++;
-    if (!strncmp(elementname, obname, ckto))
-       if (*(obname + ckto) == '/' || *(obname + ckto) == '\0')
-	  break;
+  inst = LookupInstance(elementname, np);
+  if (inst != NULL && inst->type == FIRSTPIN)
+    ob = inst;
+  else {
+    inst = NULL;
+    for (ob = np->cell; ob != NULL; ob = ob->next) {
+      obname = ob->name;
+      if (*obname == '/') obname++;
+      if (!strncmp(elementname, obname, ckto))
+	 if (*(obname + ckto) == '/' || *(obname + ckto) == '\0')
+	    break;
+    }
   }
   if (ob == NULL) {
     Printf("Device '%s' not found in circuit '%s'.\n", elementname, cell);
     return;
   }
 
+  ci = ConnIndex(np);
   Printf("Device '%s' Pins:\n", elementname);
   for (; ob != NULL; ob = ob->next) {
+    if (inst != NULL && ob != inst && ob->type <= FIRSTPIN) break;
     obname = ob->name;
     if (*obname == '/') obname++;
     if (!strncmp(elementname, obname, ckto)) {
@@ -391,26 +451,7 @@ void ElementNodes(char *cell, char *element, int fnum)
        Printf("   ");
        PrintObjectType(ob->type);
        Printf(" (%s)", obname + ckto + 1);
-       for (nob = np->cell; nob != NULL; nob = nob->next) {
-	 if (nob->node == ob->node) {
-	    if (nob->type == NODE) {
-	       Printf(" = %s", nob->name);
-	       break;
-	    }
-	    else if (nob->type == PORT) {
-	       Printf(" = %s (port of %s)", nob->name, cell);
-	       break;
-	    }
-	    else if (nob->type == GLOBAL) {
-	       Printf(" = %s (global)", nob->name);
-	       break;
-	    }
-	    else if (nob->type == UNIQUEGLOBAL) {
-	       Printf(" = %s (unique global)", nob->name);
-	       break;
-	    }
- 	 }
-       }
+       PrintPinNet(np, ob, cell, ci);
        Printf("\n");
     }
   }
@@ -589,7 +630,8 @@ void PrintNodes(char *name, int filenum)
     nodenum = ob->node;
     if (nodenum < 0) continue;
     /* repeat bits of objlist.c here for speed */
-    if (tp->nodename_cache != NULL) {
+    if ((tp->nodename_cache != NULL) && (nodenum <= tp->nodename_cache_size)
+		&& (tp->nodename_cache[nodenum] != NULL)) {
       nodelist[nodenum].name = tp->nodename_cache[nodenum]->name;
     }
     else {
@@ -708,8 +750,9 @@ void PrintInstances(char *name, int filenum)
 {
   struct nlist *tp;
   struct objlist *ob;
+  struct connindex *ci;
   int instancecount;
-	
+
   if ((filenum == -1) && (Circuit1 != NULL) && (Circuit2 != NULL)) {
       PrintInstances(name, Circuit1->file);
       PrintInstances(name, Circuit2->file);
@@ -722,6 +765,7 @@ void PrintInstances(char *name, int filenum)
     return;
   }
   Printf("Circuit: '%s'\n",tp->name);
+  ci = ConnIndex(tp);
   instancecount = 0;
   for (ob = tp->cell; ob != NULL; ob = ob->next) {
     if (ob->type == FIRSTPIN) {
@@ -737,16 +781,24 @@ void PrintInstances(char *name, int filenum)
 	struct objlist *ob3;
 
 	ports = nodes = globals = uniqueglobals = pins = 0;
-	for (ob3 = tp->cell; ob3 != NULL; ob3 = ob3->next)
-	  if (ob3->node == ob2->node)
-	    switch (ob3->type) {
-	    case UNIQUEGLOBAL: uniqueglobals++; break;
-	    case GLOBAL: globals++; break;
-	    case PORT:   ports++; break;
-	    case NODE:   nodes++; break;
-	    case PROPERTY: break;
-	    default:     pins++; break;
-	    }
+	if (ci != NULL && ob2->node >= 0 && ob2->node <= ci->maxnode) {
+	  uniqueglobals = ci->types[ob2->node] & NET_UNIQUEGLOBAL;
+	  globals = ci->types[ob2->node] & NET_GLOBAL;
+	  ports = ci->types[ob2->node] & NET_PORT;
+	  nodes = ci->types[ob2->node] & NET_NODE;
+	}
+	else {
+	  for (ob3 = tp->cell; ob3 != NULL; ob3 = ob3->next)
+	    if (ob3->node == ob2->node)
+	      switch (ob3->type) {
+	      case UNIQUEGLOBAL: uniqueglobals++; break;
+	      case GLOBAL: globals++; break;
+	      case PORT:   ports++; break;
+	      case NODE:   nodes++; break;
+	      case PROPERTY: break;
+	      default:     pins++; break;
+	      }
+	}
 	pin++;
 	if (uniqueglobals) uniqueglobal++;
 	else if (globals) global++;
@@ -989,7 +1041,7 @@ void Query(void)
       if (CurrentCell == NULL) 
 	promptstring("Enter circuit name:    ", repstr2);
       else strcpy(repstr2, CurrentCell->name);
-      Fanout(repstr2, repstr, ALLOBJECTS);
+      Fanout(repstr2, repstr, ALLOBJECTS, -1);
       break;
     case 'e' : 
       promptstring("Enter element name: ", repstr);
@@ -1139,9 +1191,7 @@ void Query(void)
     case 'q' : break;
     case 'Q' : exit(0);
     case 'P' : PROTOCHIP(); break;
-#ifdef HAVE_MALLINFO
     case 'm': PrintMemoryStats(); break;
-#endif
     case '<' :
       {
 	FILE *oldfile;
@@ -1177,9 +1227,7 @@ void Query(void)
       printf("toggle (D)ebug, (t)ime commands, embed (P)rotochip, ne(T)cmp\n");
       printf("(!) push shell, (<) read input file");
 
-#ifdef HAVE_MALLINFO
       printf(", show (m)emory usage");
-#endif
       printf("\n");
       printf("(q)uit, (Q)uit immediately, re-(I)nitialize \n");
       break;
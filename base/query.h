@@ -14,7 +14,7 @@ extern void ElementNodes(char *cell, char *element, int fnum);
 #else
 extern void PrintElement(char *cell, char *list_template);
 #endif
-extern void Fanout(char *cell, char *node, int filter);
+extern void Fanout(char *cell, char *node, int filter, int fnum);
 extern void PrintNodes(char *name, int file);
 extern void PrintCell(char *name, int file);
 extern void PrintInstances(char *name, int file);
@@ -18,6 +18,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 
 /* spice.c -- Input / output for SPICE and ESACAP formats */
 
+#define MEMTAG MEM_PARSE	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -47,6 +48,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "query.h"
 #include "objlist.h"
 #include "netcmp.h"
+#include "timing.h"
 
 // Global storage for parameters from .PARAM
 struct hashdict spiceparams;
@@ -457,14 +459,17 @@ void CleanupSubcell() {
 	       CurrentCell->cell = sobj->next;
 	    FreeObjectAndHash(sobj, CurrentCell);
 	 }
-	 else if (IsPort(sobj) && sobj->model.port == PROXY)
+	 else if (IsPort(sobj) && sobj->model.port == PROXY) {
 	    sobj->node = maxnode++;
+	    NodeNameAdd(CurrentCell, sobj);
+	 }
 	 else if (IsPort(sobj)) {
 	    for (pobj = CurrentCell->cell; pobj && (pobj->type == PORT);
 			pobj = pobj->next) {
 	       if (pobj == sobj) continue;
 	       if (matchnocase(pobj->name, sobj->name) && pobj->node >= 0) {
 		  sobj->node = pobj->node;
+		  NodeNameAdd(CurrentCell, sobj);
 		  break;
 	       }
 	    }
@@ -1998,7 +2003,7 @@ char *ReadSpiceTop(char *fname, int *fnum, int blackbox)
 {
   struct cellstack *CellStack = NULL;
   struct nlist *tp;
-  int filenum;
+  int filenum, failed;
 
   // Make sure CurrentCell is clear
   CurrentCell = NULL;
@@ -2042,7 +2047,7 @@ char *ReadSpiceTop(char *fname, int *fnum, int blackbox)
   /* will be handled by the main SPICE file processing.	*/
 
   ReadSpiceFile(fname, filenum, &CellStack, blackbox);
-  CloseParseFile();
+  failed = CloseNetlistFile(fname, *fnum, filenum);
 
   // Cleanup
   while (CellStack != NULL) PopStack(&CellStack);
@@ -2050,6 +2055,17 @@ char *ReadSpiceTop(char *fname, int *fnum, int blackbox)
   RecurseHashTable(&spiceparams, freeprop);
   HashKill(&spiceparams);
 
+  if (failed) {
+     *fnum = -1;
+     return NULL;
+  }
+
+  // Subcircuits called but not defined may come from a library.
+  // Instances of a replaced placeholder need their pins renamed.
+
+  if (ResolveLibraryCells(filenum) > 0)
+     RecurseCellFileHashTable(renamepins, filenum);
+
   // Important:  If the file is a library, containing subcircuit
   // definitions but no components, then it needs to be registered
   // as an empty cell.  Otherwise, the filename is lost and cells
@@ -2070,14 +2086,24 @@ char *ReadSpiceTop(char *fname, int *fnum, int blackbox)
 
 char *ReadSpice(char *fname, int *fnum)
 {
-   return ReadSpiceTop(fname, fnum, 0);
+   char *result;
+
+   StatStart(STAT_READ_SPICE);
+   result = ReadSpiceTop(fname, fnum, 0);
+   StatStop(STAT_READ_SPICE);
+   return result;
 }
 
 /*--------------------------------------*/
 
 char *ReadSpiceLib(char *fname, int *fnum)
 {
-   return ReadSpiceTop(fname, fnum, 1);
+   char *result;
+
+   StatStart(STAT_READ_SPICE);
+   result = ReadSpiceTop(fname, fnum, 1);
+   StatStop(STAT_READ_SPICE);
+   return result;
 }
 
 /*--------------------------------------*/
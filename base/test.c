@@ -101,7 +101,7 @@ void test_entry(void)
   PrintCell("test2");
 
   Ntk("test2","test2.ntk");
-  Fanout("test2","M1.gate", ALLOBJECTS);
+  Fanout("test2","M1.gate", ALLOBJECTS, -1);
 	      
   ReadNtk("exphorn.ntk");
 #endif  /* TESTNTK */
@@ -23,10 +23,24 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 /*    General timing stuff:  CPUTime returns process CPU time in seconds */
 /*                           ElapsedCPUTime(t) returns time since t      */
 /*                                                                       */
+/*    Phase instrumentation: StatStart/StatStop time a phase of LVS,     */
+/*                           StatCount adds to its counter               */
+/*                                                                       */
 /*************************************************************************/
 
 #include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#ifdef TCL_NETGEN
+#include <tcl.h>
+#endif
+
 #include "timing.h"
+#include "print.h"
+#include "memstats.h"
 
 #ifdef HAVE_CLOCK
 
@@ -117,3 +131,131 @@ float ElapsedCPUTime(float since)
 }
 
 
+
+/*************************************************************************/
+/*                                                                       */
+/*    Phase instrumentation                                              */
+/*                                                                       */
+/*************************************************************************/
+
+/* All counters start at zero */
+#define STAT(name)	{name, 0, 0, 0.0, 0.0, 0, 0, 0.0, 0.0, 0}
+
+struct netgenstat NetgenStats[STAT_NUMSTATS] = {
+  STAT("read_spice"),
+  STAT("read_verilog"),
+  STAT("read_ext"),
+  STAT("read_sim"),
+  STAT("flatten"),
+  STAT("prematch"),
+  STAT("combine_parallel"),
+  STAT("combine_series"),
+  STAT("create_lists"),
+  STAT("iterate"),
+  STAT("resolve"),
+  STAT("property_check"),
+  STAT("match_pins"),
+  STAT("report"),
+};
+
+#undef STAT
+
+/* CPUTime() may have only one-second resolution, depending on	*/
+/* what the system provides, so phase CPU time uses clock().		*/
+
+static double ProcessTime(void)
+/* return the process CPU time in seconds */
+{
+  return((double)clock() / (double)CLOCKS_PER_SEC);
+}
+
+double WallTime(void)
+/* return the wall-clock time in seconds */
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return((double)tv.tv_sec + (double)tv.tv_usec * 1.0e-6);
+}
+
+void StatStart(int stat)
+{
+  struct netgenstat *ns = &NetgenStats[stat];
+
+  if (ns->depth++ > 0) return;
+  ns->calls++;
+  ns->wallstart = WallTime();
+  ns->cpustart = ProcessTime();
+  ns->savedpeak = MemPhasePeak;
+  MemPhasePeak = MemInUse;
+}
+
+void StatStop(int stat)
+{
+  struct netgenstat *ns = &NetgenStats[stat];
+
+  if (ns->depth == 0) return;
+  if (--ns->depth > 0) return;
+  ns->wall += WallTime() - ns->wallstart;
+  ns->cpu += ProcessTime() - ns->cpustart;
+
+  /* The enclosing phase's high-water mark includes this phase's */
+  if (MemPhasePeak > ns->mempeak) ns->mempeak = MemPhasePeak;
+  if (ns->savedpeak > MemPhasePeak) MemPhasePeak = ns->savedpeak;
+}
+
+void StatCount(int stat, long count)
+{
+  NetgenStats[stat].count += count;
+}
+
+void StatsReset(void)
+{
+  int i;
+
+  for (i = 0; i < STAT_NUMSTATS; i++) {
+    NetgenStats[i].calls = 0;
+    NetgenStats[i].count = 0;
+    NetgenStats[i].wall = 0.0;
+    NetgenStats[i].cpu = 0.0;
+    NetgenStats[i].mempeak = 0;
+    NetgenStats[i].depth = 0;
+  }
+}
+
+void StatsPrint(void)
+{
+  int i;
+  struct netgenstat *ns;
+
+  Printf("%-20s %10s %12s %12s %12s %12s\n", "Phase", "Calls", "Count",
+	"Wall (s)", "CPU (s)", "Peak (MB)");
+  for (i = 0; i < STAT_NUMSTATS; i++) {
+    ns = &NetgenStats[i];
+    Printf("%-20s %10ld %12ld %12.6f %12.6f %12.3f\n", ns->name, ns->calls,
+	ns->count, ns->wall, ns->cpu, (double)ns->mempeak / 1048576.0);
+  }
+}
+
+/* Return the statistics as a JSON object in a string which the	*/
+/* caller must free.							*/
+
+char *StatsJSON(void)
+{
+  int i;
+  char *json, *jptr;
+  struct netgenstat *ns;
+
+  json = (char *)MALLOC(STAT_NUMSTATS * 200 + 8);
+  jptr = json;
+  *jptr++ = '{';
+  for (i = 0; i < STAT_NUMSTATS; i++) {
+    ns = &NetgenStats[i];
+    jptr += sprintf(jptr, "%s\"%s\": {\"calls\": %ld, \"count\": %ld, "
+		"\"wall\": %.6f, \"cpu\": %.6f, \"peak_bytes\": %lu}",
+		(i == 0) ? "" : ", ", ns->name, ns->calls, ns->count,
+		ns->wall, ns->cpu, (unsigned long)ns->mempeak);
+  }
+  strcpy(jptr, "}");
+  return json;
+}
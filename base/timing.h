@@ -1,3 +1,49 @@
 /* timing routines */
 extern float CPUTime(void);
 extern float ElapsedCPUTime(float since);
+extern double WallTime(void);
+
+/* Instrumentation of the LVS phases, reported by the "stats" command.	*/
+/* Each entry accumulates the wall-clock and CPU time spent in calls to	*/
+/* the phase, the number of calls, and a phase-specific count (e.g.,	*/
+/* the number of devices merged), and the high-water mark of allocated	*/
+/* memory during the phase.  Nested or recursive calls to the same	*/
+/* phase are timed once, by the outermost call.				*/
+
+#define STAT_READ_SPICE		0
+#define STAT_READ_VERILOG	1
+#define STAT_READ_EXT		2
+#define STAT_READ_SIM		3
+#define STAT_FLATTEN		4
+#define STAT_PREMATCH		5
+#define STAT_COMBINE_PARALLEL	6
+#define STAT_COMBINE_SERIES	7
+#define STAT_CREATE_LISTS	8
+#define STAT_ITERATE		9
+#define STAT_RESOLVE		10
+#define STAT_PROPERTY_CHECK	11
+#define STAT_MATCH_PINS		12
+#define STAT_REPORT		13
+#define STAT_NUMSTATS		14
+
+struct netgenstat {
+   char *name;
+   long calls;
+   long count;
+   double wall;		/* seconds */
+   double cpu;		/* seconds */
+   size_t mempeak;	/* bytes */
+   int depth;		/* nesting level of active calls */
+   double wallstart;
+   double cpustart;
+   size_t savedpeak;	/* enclosing phase's high-water mark */
+};
+
+extern struct netgenstat NetgenStats[STAT_NUMSTATS];
+
+extern void StatStart(int stat);
+extern void StatStop(int stat);
+extern void StatCount(int stat, long count);
+extern void StatsReset(void);
+extern void StatsPrint(void);
+extern char *StatsJSON(void);
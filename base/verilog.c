@@ -38,6 +38,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 /* vectors that are created on the fly using {...} notation, including	*/
 /* the {n{...}} concatenation method.					*/
 
+#define MEMTAG MEM_PARSE	/* category of allocations (see config.h) */
 #include "config.h"
 
 #include <stdio.h>
@@ -58,6 +59,7 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "print.h"
 #include "hash.h"
 #include "netcmp.h"
+#include "timing.h"
 
 // See netfile.c for explanation of delimiters.  'X'
 // separates single-character delimiters from two-character delimiters.
@@ -795,6 +797,43 @@ int GetBus(char *astr, struct bus *wb)
     return 0;
 }
 
+//--------------------------------------------------------------------
+// Wire buses are kept as a single entry in the "buses" hash table
+// giving the bit range, and the node for each bit of the wire is
+// only created when something connects to it.  LookupBusNet() looks
+// up the node "name" in the current cell, and if it is not found but
+// is a bit "root[index]" of a declared bus, creates the node.
+// Returns NULL if the node does not exist and is not a bus bit.
+//--------------------------------------------------------------------
+
+struct objlist *LookupBusNet(char *name)
+{
+    struct objlist *ob;
+    struct bus *hbus;
+    char *bptr;
+    int idx;
+
+    ob = LookupObject(name, CurrentCell);
+    if (ob != NULL) return ob;
+
+    bptr = strrchr(name, '[');
+    if ((bptr == NULL) || (bptr == name)) return NULL;
+    if (sscanf(bptr + 1, "%d", &idx) != 1) return NULL;
+
+    *bptr = '\0';
+    hbus = (struct bus *)HashLookup(name, &buses);
+    *bptr = '[';
+    if (hbus == NULL) return NULL;
+
+    if (((hbus->start >= hbus->end) && (idx <= hbus->start) && (idx >= hbus->end))
+		|| ((hbus->start < hbus->end) && (idx >= hbus->start)
+		&& (idx <= hbus->end))) {
+	Node(name);
+	ob = LookupObject(name, CurrentCell);
+    }
+    return ob;
+}
+
 //--------------------------------------------------------------------
 // Output a Verilog Module.  Note that since Verilog does not describe
 // low-level devices like transistors, capacitors, etc., then this
@@ -996,14 +1035,17 @@ void CleanupModule() {
       if (sobj->type == FIRSTPIN)
 	 has_submodules = TRUE;
       if (sobj->node < 0) {
-	 if (IsPort(sobj) && sobj->model.port == PROXY)
+	 if (IsPort(sobj) && sobj->model.port == PROXY) {
 	    sobj->node = maxnode++;
+	    NodeNameAdd(CurrentCell, sobj);
+	 }
 	 else if (IsPort(sobj)) {
 	    for (pobj = CurrentCell->cell; pobj && (pobj->type == PORT);
 			pobj = pobj->next) {
 	       if (pobj == sobj) continue;
 	       if (match(pobj->name, sobj->name) && pobj->node >= 0) {
 		  sobj->node = pobj->node;
+		  NodeNameAdd(CurrentCell, sobj);
 		  break;
 	       }
 	    }
@@ -1872,26 +1914,17 @@ skip_endmodule:
 		/* Handle bus notation */
 		SkipTokNoNewline(VLOG_DELIMITERS);
 		strcpy(noderoot, nexttok);
-		if (wb.start > wb.end) {
-		    for (i = wb.end; i <= wb.start; i++) {
-			sprintf(nodename, "%s[%d]", nexttok, i);
-			if (LookupObject(nodename, CurrentCell) == NULL)
-			    Node(nodename);
-			if (i == wb.start) lhs = LookupObject(nodename, CurrentCell);
-		    }
-		}
-		else {
-		    for (i = wb.start; i <= wb.end; i++) {
-			sprintf(nodename, "%s[%d]", nexttok, i);
-			if (LookupObject(nodename, CurrentCell) == NULL)
-			    Node(nodename);
-			if (i == wb.start) lhs = LookupObject(nodename, CurrentCell);
-		    }
+
+		/* Nodes for the bits of the wire are made when	*/
+		/* they are connected (see LookupBusNet()).	*/
+		lhs = NULL;
+		nb = (struct bus *)HashLookup(nexttok, &buses);
+		if (nb == NULL) {
+		    nb = NewBus();
+		    nb->start = wb.start;
+		    nb->end = wb.end;
+		    HashPtrInstall(nexttok, nb, &buses);
 		}
-		nb = NewBus();
-		nb->start = wb.start;
-		nb->end = wb.end;
-		HashPtrInstall(nexttok, nb, &buses);
 	    }
 	    else {
 		if (LookupObject(nexttok, CurrentCell) == NULL) {
@@ -1953,14 +1986,14 @@ skip_endmodule:
 		    /* Find object of first net in bus */
 		    strcpy(noderoot, nexttok);
 		    sprintf(nodename, "%s[%d]", nexttok, wb.start);
-		    lhs = LookupObject(nodename, CurrentCell);
+		    lhs = LookupBusNet(nodename);
 		    *aptr = '[';
 		}
 		else {
 		    strcpy(noderoot, nexttok);
 		    /* Set LHS to the start of the vector */
 		    sprintf(nodename, "%s[%d]", nexttok, wb.start);
-		    lhs = LookupObject(nodename, CurrentCell);
+		    lhs = LookupBusNet(nodename);
 		}
 	    }
 	    else {
@@ -1997,6 +2030,12 @@ skip_endmodule:
 	    char assignname[MAX_STR_LEN], assignroot[MAX_STR_LEN];
 	    int multiplier = 1;
 
+	    /* A wire bus being declared has no nodes yet */
+	    if ((lhs == NULL) && is_wire && (wb.start != -1)) {
+		sprintf(nodename, "%s[%d]", noderoot, wb.start);
+		lhs = LookupBusNet(nodename);
+	    }
+
 	    i = wb.start;
 	    while (1) {
 		SkipTokComments(VLOG_PIN_CHECK_DELIMITERS);
@@ -2031,7 +2070,7 @@ skip_endmodule:
 			    *aptr = '\0';
 			    strcpy(assignroot, nexttok);
 			    sprintf(assignname, "%s[%d]", nexttok, j);
-			    rhs = LookupObject(assignname, CurrentCell);
+			    rhs = LookupBusNet(assignname);
 			    *aptr = '[';
 			}
 			else
@@ -2101,6 +2140,8 @@ skip_endmodule:
 			    goto skip_endmodule;
 			}
 
+			LookupBusNet(nodename);
+			LookupBusNet(assignname);
 			join(nodename, assignname);
 
 			if (i == wb.end) break;
@@ -3006,7 +3047,7 @@ char *ReadVerilogTop(char *fname, int *fnum, int blackbox)
   struct property *kl = NULL;
   struct cellstack *CellStack = NULL;
   struct nlist *tp;
-  int filenum;
+  int filenum, failed;
 
   // Make sure CurrentCell is clear
   CurrentCell = NULL;
@@ -3077,13 +3118,21 @@ char *ReadVerilogTop(char *fname, int *fnum, int blackbox)
   HashPtrInstall(kl->key, kl, &verilogdefs);
 
   ReadVerilogFile(fname, filenum, &CellStack, blackbox);
-  CloseParseFile();
+  failed = CloseNetlistFile(fname, *fnum, filenum);
 
   // Cleanup
   while (CellStack != NULL) PopStack(&CellStack);
 
   definitions = (struct hashdict *)NULL;
 
+  if (failed) {
+     *fnum = -1;
+     return NULL;
+  }
+
+  // Modules used but not defined may come from a library
+  ResolveLibraryCells(filenum);
+
   // Record the top level file.
   if (LookupCellFile(fname, filenum) == NULL) CellDef(fname, filenum);
 
@@ -3100,7 +3149,12 @@ char *ReadVerilogTop(char *fname, int *fnum, int blackbox)
 
 char *ReadVerilog(char *fname, int *fnum)
 {
-   return ReadVerilogTop(fname, fnum, 0);
+   char *result;
+
+   StatStart(STAT_READ_VERILOG);
+   result = ReadVerilogTop(fname, fnum, 0);
+   StatStop(STAT_READ_VERILOG);
+   return result;
 }
 
 /*--------------------------------------*/
@@ -631,7 +631,7 @@ void print_nodes(Widget w, Widget textwidget, caddr_t call_data)
 void print_nodes_connected_to(Widget w, Widget textwidget, caddr_t call_data)
 {
   X_START();
-  Fanout(get_cell(), get_data(), NODE);
+  Fanout(get_cell(), get_data(), NODE, -1);
   X_END();
 }
 
@@ -0,0 +1,87 @@
+#---------------------------------------------------------------------------
+# bench.tcl --- Time the phases of one LVS comparison and append the
+# result to a file as one JSON object per line.
+#
+# Run with:  netgen -batch source bench.tcl
+#
+# The comparison is described by environment variables:
+#
+#   NETGEN_BENCH_NAME	 label for the result (e.g., "sram_64")
+#   NETGEN_BENCH_FILE1	 first SPICE netlist
+#   NETGEN_BENCH_FILE2	 second SPICE netlist
+#   NETGEN_BENCH_CELL	 top cell name in both netlists (default "top")
+#   NETGEN_BENCH_OUT	 file to append the JSON result to
+#
+# Phases are timed separately as wall-clock microseconds.  Series and
+# parallel device combination is done by "compare", so is included in
+# the "compare" phase.  The internal counters of "netgen::stats" are
+# included under "stats".
+#---------------------------------------------------------------------------
+
+proc bench_phase {name script} {
+   upvar 1 phases phases
+   set t0 [clock microseconds]
+   set result [uplevel 1 $script]
+   lappend phases $name [expr {[clock microseconds] - $t0}]
+   return $result
+}
+
+set bname $::env(NETGEN_BENCH_NAME)
+set file1 $::env(NETGEN_BENCH_FILE1)
+set file2 $::env(NETGEN_BENCH_FILE2)
+set outfile $::env(NETGEN_BENCH_OUT)
+if {[info exists ::env(NETGEN_BENCH_CELL)]} {
+   set cell $::env(NETGEN_BENCH_CELL)
+} else {
+   set cell top
+}
+
+set phases {}
+netgen::stats reset
+set start [clock microseconds]
+
+bench_phase read {
+   set fnum1 [netgen::readnet spice $file1]
+   set fnum2 [netgen::readnet spice $file2]
+}
+bench_phase flatten {
+   netgen::flatten "$cell $fnum1"
+   netgen::flatten "$cell $fnum2"
+}
+
+netgen::permute default
+netgen::property default
+
+bench_phase compare {
+   netgen::compare hierarchical "$cell $fnum1" "$cell $fnum2"
+}
+bench_phase converge {
+   netgen::run converge
+}
+set equiv [expr {[netgen::verify equivalent] != 0}]
+if {$equiv} {
+   bench_phase resolve {
+      netgen::run resolve
+   }
+} else {
+   lappend phases resolve 0
+}
+set unique [bench_phase report {
+   netgen::verify unique
+}]
+
+set total [expr {[clock microseconds] - $start}]
+
+set json "\{\"name\": \"$bname\", \"equivalent\": $equiv, \"unique\": $unique"
+append json ", \"total_us\": $total, \"phases\": \{"
+set sep ""
+foreach {name us} $phases {
+   append json "$sep\"$name\": $us"
+   set sep ", "
+}
+append json "\}, \"stats\": [netgen::stats json]\}"
+
+set f [open $outfile a]
+puts $f $json
+close $f
+puts stdout $json
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# runbench.sh --- Generate the synthetic benchmark designs and time LVS
+# on each one.  Results are written to <workdir>/results.json, one JSON
+# object per line.
+#
+# Usage:  runbench.sh <netgen> [<workdir>] [<scale>]
+#
+# <scale> (default 1) enlarges the designs.  It multiplies the <size>
+# argument of spicegen, which is an instance count for the inverter chain
+# and logic designs, so those grow linearly with <scale>.  For the SRAM
+# array and resistor mesh, <size> is the side of a square, so they grow
+# with the square of <scale>.  The DAC <size> is a bit count, and each
+# bit doubles the number of unit devices, so it is given 8 + <scale> bits
+# and doubles in size with each step of <scale>.  spicegen allows at most
+# 20 bits, so the DAC fails for <scale> above 12.
+#
+# Each design is compared against a shuffled copy of itself, and the
+# inverter chain and logic designs are also compared against a copy with
+# mismatches.
+
+NETGEN=${1:?usage: runbench.sh <netgen> [<workdir>] [<scale>]}
+WORK=${2:-bench.out}
+SCALE=${3:-1}
+BENCHDIR=`cd \`dirname $0\` && pwd`
+SPICEGEN=${BENCHDIR}/spicegen
+SEED=1
+
+mkdir -p ${WORK} || exit 1
+WORK=`cd ${WORK} && pwd`
+rm -f ${WORK}/results.json
+
+runone () {
+   # runone <label> <design> <size> [<mismatches>]
+   ${SPICEGEN} $2 $3 -seed ${SEED} -o ${WORK}/$1_a.spice || exit 1
+   ${SPICEGEN} $2 $3 -seed ${SEED} -shuffle -mismatch ${4:-0} \
+	-o ${WORK}/$1_b.spice || exit 1
+   NETGEN_BENCH_NAME=$1 \
+   NETGEN_BENCH_FILE1=${WORK}/$1_a.spice \
+   NETGEN_BENCH_FILE2=${WORK}/$1_b.spice \
+   NETGEN_BENCH_OUT=${WORK}/results.json \
+	${NETGEN} -batch source ${BENCHDIR}/bench.tcl > ${WORK}/$1.log 2>&1
+   tail -1 ${WORK}/$1.log
+}
+
+runone inv inv `expr 2000 \* ${SCALE}`
+runone inv_mismatch inv `expr 2000 \* ${SCALE}` 2
+runone sram sram `expr 32 \* ${SCALE}`
+runone logic logic `expr 2000 \* ${SCALE}`
+runone logic_mismatch logic `expr 2000 \* ${SCALE}` 4
+runone rmesh rmesh `expr 40 \* ${SCALE}`
+runone dac dac `expr 8 + ${SCALE}`
@@ -0,0 +1,505 @@
+/* "NETGEN", a netlist-specification tool for VLSI
+   Copyright (C) 1989, 1990   Massimo A. Sivilotti
+   Author's address: mass@csvax.cs.caltech.edu;
+                     Caltech 256-80, Pasadena CA 91125.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation (any version).
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file copying.  If not, write to
+the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
+
+/* spicegen.c -- generate synthetic SPICE netlists for benchmarking LVS	*/
+/*									*/
+/* Usage:  spicegen <design> <size> [-seed n] [-shuffle] [-mismatch n]	*/
+/*		[-o file]						*/
+/*									*/
+/* Designs:								*/
+/*    inv	chain of <size> inverters				*/
+/*    sram	<size> x <size> array of 6T SRAM cells			*/
+/*    logic	<size> random standard cells (inv, nand2, nor2, aoi21)	*/
+/*    rmesh	<size> x <size> resistor mesh with series pad straps	*/
+/*    dac	<size>-bit binary-weighted capacitor and current DAC	*/
+/*									*/
+/* The design is a function of <design>, <size> and the seed only.	*/
+/* "-shuffle" writes the same circuit with instances in a random order	*/
+/* and internal nets renamed, as a layout extraction would differ from	*/
+/* a schematic.  "-mismatch n" moves n randomly chosen instance pins to	*/
+/* other nets, so that the two netlists no longer match.  The shuffle	*/
+/* and mismatch choices are drawn from a second random sequence, so	*/
+/* that they do not perturb the design itself.				*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXPINS 6
+
+struct instance {
+   char type;			/* SPICE element letter */
+   char *model;			/* Subcircuit or device model name */
+   int npins;
+   int pins[MAXPINS];		/* Net numbers */
+   char *value;			/* Value or parameter string, or NULL */
+};
+
+static struct instance *Insts = NULL;
+static int NumInsts = 0, MaxInsts = 0;
+
+static char **PortNames = NULL;	/* Nets 0 to NumPorts - 1 are ports */
+static int NumPorts = 0, MaxPorts = 0;
+static int NumNets = 0;
+
+static unsigned long DesignSeed, ShuffleSeed;
+
+/*----------------------------------------------------------------------*/
+/* Random numbers.  A fixed generator is used instead of rand() so that	*/
+/* the designs are the same on every platform.				*/
+/*----------------------------------------------------------------------*/
+
+static int Random(unsigned long *seed, int n)
+{
+   *seed = (*seed * 1103515245ul + 12345ul) & 0xffffffff;
+   return (int)((*seed >> 8) % (unsigned long)n);
+}
+
+static void *Alloc(size_t size)
+{
+   void *p = malloc(size);
+   if (p == NULL) {
+      fprintf(stderr, "spicegen:  Out of memory.\n");
+      exit(1);
+   }
+   return p;
+}
+
+static int AddPort(char *fmt, int idx)
+{
+   char name[64];
+
+   if (NumPorts == MaxPorts) {
+      char **newports;
+      MaxPorts = (MaxPorts == 0) ? 64 : (MaxPorts << 1);
+      newports = (char **)Alloc(MaxPorts * sizeof(char *));
+      if (PortNames != NULL) {
+	 memcpy(newports, PortNames, NumPorts * sizeof(char *));
+	 free(PortNames);
+      }
+      PortNames = newports;
+   }
+   sprintf(name, fmt, idx);
+   PortNames[NumPorts] = strdup(name);
+   NumNets++;
+   return NumPorts++;
+}
+
+static int NewNet(void)
+{
+   return NumNets++;
+}
+
+static struct instance *AddInst(char type, char *model, char *value,
+	int npins, int p0, int p1, int p2, int p3, int p4, int p5)
+{
+   struct instance *inst;
+
+   if (NumInsts == MaxInsts) {
+      struct instance *newinsts;
+      MaxInsts = (MaxInsts == 0) ? 1024 : (MaxInsts << 1);
+      newinsts = (struct instance *)Alloc(MaxInsts * sizeof(struct instance));
+      if (Insts != NULL) {
+	 memcpy(newinsts, Insts, NumInsts * sizeof(struct instance));
+	 free(Insts);
+      }
+      Insts = newinsts;
+   }
+   inst = &Insts[NumInsts++];
+   inst->type = type;
+   inst->model = model;
+   inst->value = value;
+   inst->npins = npins;
+   inst->pins[0] = p0;
+   inst->pins[1] = p1;
+   inst->pins[2] = p2;
+   inst->pins[3] = p3;
+   inst->pins[4] = p4;
+   inst->pins[5] = p5;
+   return inst;
+}
+
+/*----------------------------------------------------------------------*/
+/* Transistor-level cell definitions used by the designs		*/
+/*----------------------------------------------------------------------*/
+
+static char *CellInv =
+   ".subckt inv a y vdd gnd\n"
+   "M1 y a vdd vdd pmos W=2u L=0.15u\n"
+   "M2 y a gnd gnd nmos W=1u L=0.15u\n"
+   ".ends\n";
+
+static char *CellNand2 =
+   ".subckt nand2 a b y vdd gnd\n"
+   "M1 y a vdd vdd pmos W=2u L=0.15u\n"
+   "M2 y b vdd vdd pmos W=2u L=0.15u\n"
+   "M3 y a n1 gnd nmos W=2u L=0.15u\n"
+   "M4 n1 b gnd gnd nmos W=2u L=0.15u\n"
+   ".ends\n";
+
+static char *CellNor2 =
+   ".subckt nor2 a b y vdd gnd\n"
+   "M1 n1 a vdd vdd pmos W=4u L=0.15u\n"
+   "M2 y b n1 vdd pmos W=4u L=0.15u\n"
+   "M3 y a gnd gnd nmos W=1u L=0.15u\n"
+   "M4 y b gnd gnd nmos W=1u L=0.15u\n"
+   ".ends\n";
+
+static char *CellAoi21 =
+   ".subckt aoi21 a b c y vdd gnd\n"
+   "M1 n1 a vdd vdd pmos W=4u L=0.15u\n"
+   "M2 n1 b vdd vdd pmos W=4u L=0.15u\n"
+   "M3 y c n1 vdd pmos W=4u L=0.15u\n"
+   "M4 y a n2 gnd nmos W=2u L=0.15u\n"
+   "M5 n2 b gnd gnd nmos W=2u L=0.15u\n"
+   "M6 y c gnd gnd nmos W=1u L=0.15u\n"
+   ".ends\n";
+
+static char *CellSram =
+   ".subckt sram6t bl blb wl vdd gnd\n"
+   "M1 q qb vdd vdd pmos W=0.5u L=0.15u\n"
+   "M2 q qb gnd gnd nmos W=1u L=0.15u\n"
+   "M3 qb q vdd vdd pmos W=0.5u L=0.15u\n"
+   "M4 qb q gnd gnd nmos W=1u L=0.15u\n"
+   "M5 bl wl q gnd nmos W=0.6u L=0.15u\n"
+   "M6 blb wl qb gnd nmos W=0.6u L=0.15u\n"
+   ".ends\n";
+
+/*----------------------------------------------------------------------*/
+/* Design generators.  Each one adds ports, nets, and instances, and	*/
+/* returns a string holding the cell definitions that it uses.		*/
+/*----------------------------------------------------------------------*/
+
+static char *GenInverterChain(int size)
+{
+   int i, a, y, vdd, gnd;
+
+   a = AddPort("in", 0);
+   y = AddPort("out", 0);
+   vdd = AddPort("vdd", 0);
+   gnd = AddPort("gnd", 0);
+
+   for (i = 0; i < size; i++) {
+      int next = (i == size - 1) ? y : NewNet();
+      AddInst('X', "inv", NULL, 4, a, next, vdd, gnd, 0, 0);
+      a = next;
+   }
+   return CellInv;
+}
+
+static char *GenSram(int size)
+{
+   int r, c, vdd, gnd, wl0, bl0, blb0;
+
+   vdd = AddPort("vdd", 0);
+   gnd = AddPort("gnd", 0);
+   wl0 = NumPorts;
+   for (r = 0; r < size; r++) AddPort("wl%d", r);
+   bl0 = NumPorts;
+   for (c = 0; c < size; c++) AddPort("bl%d", c);
+   blb0 = NumPorts;
+   for (c = 0; c < size; c++) AddPort("blb%d", c);
+
+   for (r = 0; r < size; r++)
+      for (c = 0; c < size; c++)
+	 AddInst('X', "sram6t", NULL, 5, bl0 + c, blb0 + c, wl0 + r,
+			vdd, gnd, 0);
+   return CellSram;
+}
+
+static char *GenLogic(int size)
+{
+   int i, nin, nout, in0, out0, vdd, gnd, y, *avail, navail;
+   static char cells[1024];
+
+   nin = (size < 16) ? size : 16;
+   nout = (size < 8) ? size : 8;
+   vdd = AddPort("vdd", 0);
+   gnd = AddPort("gnd", 0);
+   in0 = NumPorts;
+   for (i = 0; i < nin; i++) AddPort("in%d", i);
+   out0 = NumPorts;
+   for (i = 0; i < nout; i++) AddPort("out%d", i);
+
+   /* Gate inputs are drawn from the primary inputs and the outputs of	*/
+   /* earlier gates, so the logic is acyclic.  The last gates drive the	*/
+   /* primary outputs.							*/
+
+   avail = (int *)Alloc((nin + size) * sizeof(int));
+   for (i = 0; i < nin; i++) avail[i] = in0 + i;
+   navail = nin;
+
+   for (i = 0; i < size; i++) {
+      int a = avail[Random(&DesignSeed, navail)];
+      int b = avail[Random(&DesignSeed, navail)];
+      int c = avail[Random(&DesignSeed, navail)];
+
+      y = (i >= size - nout) ? out0 + (i - (size - nout)) : NewNet();
+      switch (Random(&DesignSeed, 4)) {
+	 case 0:
+	    AddInst('X', "inv", NULL, 4, a, y, vdd, gnd, 0, 0);
+	    break;
+	 case 1:
+	    AddInst('X', "nand2", NULL, 5, a, b, y, vdd, gnd, 0);
+	    break;
+	 case 2:
+	    AddInst('X', "nor2", NULL, 5, a, b, y, vdd, gnd, 0);
+	    break;
+	 case 3:
+	    AddInst('X', "aoi21", NULL, 6, a, b, c, y, vdd, gnd);
+	    break;
+      }
+      avail[navail++] = y;
+   }
+   free(avail);
+
+   sprintf(cells, "%s%s%s%s", CellInv, CellNand2, CellNor2, CellAoi21);
+   return cells;
+}
+
+static char *GenResistorMesh(int size)
+{
+   static char *values[] = {"10", "20", "50", "100"};
+   int r, c, k, *grid, pad, prev, next;
+
+   if (size < 2) size = 2;
+   grid = (int *)Alloc(size * size * sizeof(int));
+
+   for (k = 0; k < 4; k++) AddPort("c%d", k);
+   pad = AddPort("pad", 0);
+
+   for (r = 0; r < size; r++)
+      for (c = 0; c < size; c++)
+	 grid[r * size + c] = NewNet();
+
+   /* The corners of the mesh are ports */
+   grid[0] = 0;
+   grid[size - 1] = 1;
+   grid[(size - 1) * size] = 2;
+   grid[size * size - 1] = 3;
+
+   for (r = 0; r < size; r++)
+      for (c = 0; c < size; c++) {
+	 if (c < size - 1)
+	    AddInst('R', NULL, values[Random(&DesignSeed, 4)], 2,
+			grid[r * size + c], grid[r * size + c + 1], 0, 0, 0, 0);
+	 if (r < size - 1)
+	    AddInst('R', NULL, values[Random(&DesignSeed, 4)], 2,
+			grid[r * size + c], grid[(r + 1) * size + c], 0, 0, 0, 0);
+      }
+
+   /* Each row end is strapped to the pad through a chain of series	*/
+   /* resistors, which series merging reduces to one device.		*/
+
+   for (r = 0; r < size; r++) {
+      prev = grid[r * size + size - 1];
+      for (k = 0; k < 4; k++) {
+	 next = (k == 3) ? pad : NewNet();
+	 AddInst('R', NULL, "5", 2, prev, next, 0, 0, 0, 0);
+	 prev = next;
+      }
+   }
+   free(grid);
+   return "";
+}
+
+static char *GenDac(int size)
+{
+   int b, u, top, gnd, iout, bias, b0;
+
+   top = AddPort("top", 0);
+   gnd = AddPort("gnd", 0);
+   iout = AddPort("iout", 0);
+   bias = AddPort("bias", 0);
+   b0 = NumPorts;
+   for (b = 0; b < size; b++) AddPort("b%d", b);
+
+   /* Bit b has 2^b unit capacitors and 2^b unit current sources in	*/
+   /* parallel, plus one dummy unit capacitor on the LSB.		*/
+
+   AddInst('C', NULL, "10f", 2, top, gnd, 0, 0, 0, 0);
+   for (b = 0; b < size; b++) {
+      int sw = NewNet();
+      for (u = 0; u < (1 << b); u++) {
+	 AddInst('C', NULL, "10f", 2, top, b0 + b, 0, 0, 0, 0);
+	 AddInst('M', "nmos", "W=1u L=1u", 4, sw, bias, gnd, gnd, 0, 0);
+      }
+      AddInst('M', "nmos", "W=0.5u L=0.15u", 4, iout, b0 + b, sw, gnd, 0, 0);
+   }
+   return "";
+}
+
+/*----------------------------------------------------------------------*/
+/* Shuffle the instance order and the internal net names.		*/
+/*----------------------------------------------------------------------*/
+
+static int *NetMap = NULL;
+
+static void Shuffle(void)
+{
+   int i, j, t;
+   struct instance tmp;
+
+   for (i = NumInsts - 1; i > 0; i--) {
+      j = Random(&ShuffleSeed, i + 1);
+      tmp = Insts[i];
+      Insts[i] = Insts[j];
+      Insts[j] = tmp;
+   }
+   for (i = NumNets - 1; i > NumPorts; i--) {
+      j = NumPorts + Random(&ShuffleSeed, i - NumPorts + 1);
+      t = NetMap[i];
+      NetMap[i] = NetMap[j];
+      NetMap[j] = t;
+   }
+}
+
+/*----------------------------------------------------------------------*/
+/* Inject mismatches by reconnecting instance pins to other nets.	*/
+/*----------------------------------------------------------------------*/
+
+static void Mismatch(int count)
+{
+   int i, p, net;
+   struct instance *inst;
+
+   if ((NumInsts == 0) || (NumNets < 2)) return;
+   for (i = 0; i < count; i++) {
+      inst = &Insts[Random(&ShuffleSeed, NumInsts)];
+      p = Random(&ShuffleSeed, inst->npins);
+      do {
+	 net = Random(&ShuffleSeed, NumNets);
+      } while (net == inst->pins[p]);
+      inst->pins[p] = net;
+   }
+}
+
+static void WriteNet(FILE *f, int net, char *prefix)
+{
+   if (net < NumPorts)
+      fprintf(f, " %s", PortNames[net]);
+   else
+      fprintf(f, " %s%d", prefix, NetMap[net]);
+}
+
+static void WriteNetlist(FILE *f, char *design, int size, char *cells,
+	int shuffle, int mismatch)
+{
+   int i, p;
+   char *prefix = (shuffle) ? "m" : "n";
+   struct instance *inst;
+
+   fprintf(f, "* %s %d generated by spicegen", design, size);
+   if (shuffle) fprintf(f, " (shuffled)");
+   if (mismatch > 0) fprintf(f, " (%d mismatches)", mismatch);
+   fprintf(f, "\n* %d instances, %d nets\n\n", NumInsts, NumNets);
+   fprintf(f, "%s\n", cells);
+
+   fprintf(f, ".subckt top");
+   for (i = 0; i < NumPorts; i++) {
+      fprintf(f, " %s", PortNames[i]);
+      if ((i % 16) == 15) fprintf(f, "\n+");
+   }
+   fprintf(f, "\n");
+
+   for (i = 0; i < NumInsts; i++) {
+      inst = &Insts[i];
+      fprintf(f, "%c%d", inst->type, i);
+      for (p = 0; p < inst->npins; p++)
+	 WriteNet(f, inst->pins[p], prefix);
+      if (inst->model) fprintf(f, " %s", inst->model);
+      if (inst->value) fprintf(f, " %s", inst->value);
+      fprintf(f, "\n");
+   }
+   fprintf(f, ".ends\n.end\n");
+}
+
+int main(int argc, char *argv[])
+{
+   char *design, *cells, *outname = NULL;
+   int i, size, shuffle = 0, mismatch = 0;
+   unsigned long seed = 1;
+   FILE *f;
+
+   if (argc < 3) {
+      fprintf(stderr, "usage: spicegen <inv|sram|logic|rmesh|dac> <size> "
+		"[-seed n] [-shuffle] [-mismatch n] [-o file]\n");
+      return 1;
+   }
+   design = argv[1];
+   size = atoi(argv[2]);
+   if (size < 1) {
+      fprintf(stderr, "spicegen:  Size must be a positive integer.\n");
+      return 1;
+   }
+   for (i = 3; i < argc; i++) {
+      if (!strcmp(argv[i], "-seed") && (i + 1 < argc))
+	 seed = strtoul(argv[++i], NULL, 10);
+      else if (!strcmp(argv[i], "-shuffle"))
+	 shuffle = 1;
+      else if (!strcmp(argv[i], "-mismatch") && (i + 1 < argc))
+	 mismatch = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-o") && (i + 1 < argc))
+	 outname = argv[++i];
+      else {
+	 fprintf(stderr, "spicegen:  Unknown option \"%s\".\n", argv[i]);
+	 return 1;
+      }
+   }
+   DesignSeed = seed;
+   ShuffleSeed = seed ^ 0x5a5a5a5aul;
+
+   if (!strcmp(design, "inv"))
+      cells = GenInverterChain(size);
+   else if (!strcmp(design, "sram"))
+      cells = GenSram(size);
+   else if (!strcmp(design, "logic"))
+      cells = GenLogic(size);
+   else if (!strcmp(design, "rmesh"))
+      cells = GenResistorMesh(size);
+   else if (!strcmp(design, "dac")) {
+      if (size > 20) {
+	 fprintf(stderr, "spicegen:  DAC size is limited to 20 bits.\n");
+	 return 1;
+      }
+      cells = GenDac(size);
+   }
+   else {
+      fprintf(stderr, "spicegen:  Unknown design \"%s\".\n", design);
+      return 1;
+   }
+
+   NetMap = (int *)Alloc((NumNets + 1) * sizeof(int));
+   for (i = 0; i < NumNets; i++) NetMap[i] = i;
+   if (shuffle) Shuffle();
+   if (mismatch > 0) Mismatch(mismatch);
+
+   if (outname != NULL) {
+      f = fopen(outname, "w");
+      if (f == NULL) {
+	 fprintf(stderr, "spicegen:  Cannot open \"%s\" for writing.\n", outname);
+	 return 1;
+      }
+   }
+   else
+      f = stdout;
+
+   WriteNetlist(f, design, size, cells, shuffle, mismatch);
+   if (f != stdout) fclose(f);
+   return 0;
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+#--------------------------------------------------------
+# Client for netgen server mode
+#
+# Start a server with:
+#
+#    netgen -batch server /tmp/netgen.sock
+#
+# Each command sent to the server is run by its Tcl interpreter and
+# answered with one line of JSON giving the status and the Tcl result.
+# Netlists read while a client is connected are discarded when it
+# disconnects;  libraries read before the server was started, kept
+# with "netgen::server keep", or read with "netgen::readlib" stay loaded
+# for every client.
+#
+# Command-line use:
+#
+#    netgen_client.py <socket> <command> [<command> ...]
+#
+# runs each command in turn and prints its result.
+#--------------------------------------------------------
+
+import sys
+import json
+import socket
+
+class NetgenError(Exception):
+    pass
+
+class NetgenClient(object):
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.rfile = self.sock.makefile('r')
+
+    def close(self):
+        self.rfile.close()
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    # Run one Tcl command and return its result.  Raise NetgenError
+    # if the command fails.
+
+    def command(self, cmd):
+        self.sock.sendall((cmd.strip() + '\n').encode())
+        line = self.rfile.readline()
+        if not line:
+            raise NetgenError('netgen server closed the connection')
+        reply = json.loads(line)
+        if reply['status'] != 'ok':
+            raise NetgenError(reply['result'])
+        return reply['result']
+
+    # Run an LVS comparison in directory "cwd".  Arguments are as for
+    # the "lvs" command;  each netlist is a file name or a list of
+    # {file cell}.
+
+    def lvs(self, netlist1, netlist2, setup='', output='comp.out',
+		options=[], cwd=None):
+        if cwd:
+            self.command('cd ' + tclquote(cwd))
+        args = [tclquote(netlist1), tclquote(netlist2), tclquote(setup),
+		tclquote(output)] + options
+        return self.command('lvs ' + ' '.join(args))
+
+# Quote a string for use as a single Tcl word.  Every character that
+# is special to Tcl is escaped with a backslash, so that any text
+# (including unbalanced braces) is passed through unchanged.  A list
+# or tuple is quoted as a Tcl list of its items.
+
+def tclquote(text):
+    if isinstance(text, (list, tuple)):
+        text = ' '.join(tclquote(item) for item in text)
+    if text == '':
+        return '{}'
+    quoted = ''
+    for c in text:
+        if c == '\n':
+            quoted += '\\n'
+        elif c == '\t':
+            quoted += '\\t'
+        elif c in ' \\{}[]$";#':
+            quoted += '\\' + c
+        else:
+            quoted += c
+    return quoted
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3:
+        print('Usage:  netgen_client.py <socket> <command> [<command> ...]')
+        sys.exit(1)
+
+    with NetgenClient(sys.argv[1]) as client:
+        for cmd in sys.argv[2:]:
+            try:
+                result = client.command(cmd)
+            except NetgenError as err:
+                print('Error:  ' + str(err), file=sys.stderr)
+                sys.exit(1)
+            if result:
+                print(result)
@@ -23,6 +23,12 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include <string.h>
 #include <strings.h>
 #include <stdarg.h>	/* for va_list */
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>	/* for the server command */
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include <tcl.h>
 
@@ -37,6 +43,9 @@ the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA. */
 #include "xilinx.h"
 #include "tech.h"
 #include "flatten.h"
+#include "timing.h"
+#include "memstats.h"
+#include "netfile.h"	/* for NextFileNumber() */
 
 #ifndef TRUE
 #define TRUE 1
@@ -81,9 +90,9 @@ int _netgen_leaves(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netgen_quit(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netgen_reinit(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netgen_log(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
-#ifdef HAVE_MALLINFO
 int _netgen_printmem(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
-#endif
+int _netgen_stats(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
+int _netgen_server(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netgen_help(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_matching(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_compare(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
@@ -99,6 +108,7 @@ int _netcmp_ignore(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_permute(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_property(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_exhaustive(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
+int _netcmp_progress(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_symmetry(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_restart(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
 int _netcmp_global(ClientData, Tcl_Interp *, int, Tcl_Obj *const objv[]);
@@ -119,14 +129,15 @@ Command netgen_cmds[] = {
 		"[<format>] <file> [<filenum>]\n   "
 		"read a netlist file (default format=auto)"},
 	{"readlib",		_netgen_readlib,
-		"<format> [<file>]\n   "
-		"read a format library"},
+		"<format> [<file>] [<filenum>]\n   "
+		"read a format library (read-only unless <filenum> is given\n   "
+		"and is not the file of a library)"},
 	{"canonical",		_netgen_canonical,
 		"<valid_cellname>\n   "
 		"return top-level cellname and file number"},
 	{"writenet", 		_netgen_writenet,
-		"<format> <file>\n   "
-		"write a netlist file"},
+		"<format> <file> [<filenum>] [-gzip]\n   "
+		"write a netlist file (gzip-compressed with -gzip)"},
 	{"flatten",		_netgen_flatten,
 		"[class] [<parent>] <cell>\n   "
 		"flatten a hierarchical cell"},
@@ -174,11 +185,23 @@ Command netgen_cmds[] = {
 	{"log",			_netgen_log,
 		"[file <name>|start|end|reset|suspend|resume|echo]\n   "
 		"enable or disable output log to file"},
-#ifdef HAVE_MALLINFO
 	{"memory",		_netgen_printmem,
-		"\n   "
-		"print memory statistics"},
-#endif
+		"[reset|list]\n   "
+		"print current and peak memory use by category and file\n   "
+		"reset: reset peak values to current use\n   "
+		"list: return memory use as a Tcl list\n   "
+		"(requires configuring with --enable-memstats)"},
+	{"stats",		_netgen_stats,
+		"[reset|list|json [<file>]]\n   "
+		"print time and peak memory of each phase of comparison\n   "
+		"reset: clear all counters\n   "
+		"list: return counters as a Tcl list\n   "
+		"json: return counters as JSON, or write them to <file>"},
+	{"server",		_netgen_server,
+		"<socket>|keep|shutdown\n   "
+		"accept commands on a UNIX-domain socket until shut down\n   "
+		"keep: keep netlists read so far by this client\n   "
+		"shutdown: stop the server after the current client"},
 	{"help",		_netgen_help,
 		"\n   "
 		"print this help information"},
@@ -242,6 +265,8 @@ Command netcmp_cmds[] = {
 		"(none): enable transistor and resistor permutations"},
 	{"property",		_netcmp_property,
 		"default: apply property defaults\n   "
+		"threads [<n>]: check properties and find parallel devices\n   "
+		"	on <n> threads (0 = one per processor)\n   "
 		"<device>|<model> <property_key> [...]\n   "
 		"<device>: name of a device type (capacitor, etc.)\n  "
 		"<model>: name of a device model\n   "
@@ -250,6 +275,17 @@ Command netcmp_cmds[] = {
 	{"exhaustive",		_netcmp_exhaustive,
 		"\n   "
 		"toggle exhaustive subdivision"},
+	{"progress",		_netcmp_progress,
+		"[-interval <sec>] [-command <cmd>] [-file <name>]\n   "
+		"[-timeout <sec>] [-iterations <n>] [-deadline <sec>]\n   "
+		"report progress of comparisons, and limit their run time\n   "
+		"-interval: seconds between reports (0 to disable)\n   "
+		"-command: call <cmd> with each report as a key-value list\n   "
+		"-file: rewrite file <name> with each report in JSON\n   "
+		"-timeout: stop each comparison after <sec> seconds (0: never)\n   "
+		"-iterations: stop each comparison after <n> iterations\n   "
+		"-deadline: stop all comparisons <sec> seconds from now (0: never)\n   "
+		"(none): return current settings"},
 	{"symmetry",		_netcmp_symmetry,
 		"(deprecated)"},
 	{"restart",		_netcmp_restart,
@@ -756,6 +792,15 @@ _netgen_readnet(ClientData clientData,
       }
    }
 
+   /* Library cells are read-only and may be shared by later netlists	*/
+   /* (and server clients), so a netlist cannot be read into the file	*/
+   /* of a library.  Netlists that use the library copy its cells.	*/
+   if ((filenum >= 0) && CellFileIsLibrary(filenum)) {
+      Tcl_SetResult(interp, "Cannot read a netlist into the file of a "
+		"library.", NULL);
+      return TCL_ERROR;
+   }
+
    switch (index) {
       case ACTEL_IDX:
       case XILINX_IDX:
@@ -912,7 +957,15 @@ _netgen_readlib(ClientData clientData,
          break;
       case SPICE_IDX:
 	 repstr = Tcl_GetString(objv[2]);
-         ReadSpiceLib(repstr, &fnum);
+	 if ((fnum == -1) || CellFileIsLibrary(fnum)) {
+	    /* A library read into its own file (or added to another	*/
+	    /* library) is read-only, and netlists read later copy	*/
+	    /* the cells that they use.					*/
+	    ReadSpiceLib(repstr, &fnum);
+	    if (fnum >= 0) CellSetLibrary(fnum, TRUE);
+	 }
+	 else
+	    ReadSpiceLib(repstr, &fnum);
          break;
       case XILINX_IDX:
          XilinxLib();
@@ -926,6 +979,7 @@ _netgen_readlib(ClientData clientData,
 /*------------------------------------------------------*/
 /* Function name: _netgen_writenet			*/
 /* Syntax: netgen::write format cellname [filenum]	*/
+/*		[-gzip]					*/
 /* Formerly: k, x, z, w, o, g, s, E, and C		*/
 /* Results:						*/
 /* Side Effects:					*/
@@ -948,8 +1002,19 @@ _netgen_writenet(ClientData clientData,
    int result, index, filenum;
    char *repstr;
 
+   CompressOutput = 0;
+   if (objc > 3 && !strcmp(Tcl_GetString(objv[objc - 1]), "-gzip")) {
+#ifdef HAVE_ZLIB
+      CompressOutput = 1;
+      objc--;
+#else
+      Tcl_SetResult(interp, "netgen was compiled without zlib.", NULL);
+      return TCL_ERROR;
+#endif
+   }
+
    if (objc != 3 && objc != 4) {
-      Tcl_WrongNumArgs(interp, 1, objv, "format file");
+      Tcl_WrongNumArgs(interp, 1, objv, "format file ?filenum? ?-gzip?");
       return TCL_ERROR;
    }
    if (Tcl_GetIndexFromObj(interp, objv[1], (const char **)formats,
@@ -1007,6 +1072,7 @@ _netgen_writenet(ClientData clientData,
          Xilinx(repstr,"");
          break;
    }
+   CompressOutput = 0;
    return TCL_OK;
 }
 
@@ -1096,7 +1162,7 @@ int
 _netgen_nodes(ClientData clientData,
     Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
 {
-   char *estr = NULL, *istr = NULL, *cstr, *fstr;
+   char *estr = NULL, *cstr, *fstr;
    char *optstart;
    int dolist = 0;
    int fnum, result;
@@ -1134,59 +1200,69 @@ _netgen_nodes(ClientData clientData,
       if (objc == 3) estr = Tcl_GetString(objv[objc - 2]);
    }
 
-   if (estr) {
-      if (*estr != '/') {
-	 istr = (char *)Tcl_Alloc(strlen(estr) + 2);
-	 sprintf(istr, "/%s", estr);
-	 estr = istr;
-      }
-   }
+   /* Element names are stored without a leading "/" (see ElementNodes) */
+   if (estr && (*estr == '/')) estr++;
 
    if (estr) {
       if (dolist) {
-	 struct objlist *ob, *nob;
+	 struct objlist *ob, *nob, *inst;
+	 struct connindex *ci;
 	 Tcl_Obj *lobj, *pobj;
+	 char *obname;
 	 int ckto;
 
 	 if (np == NULL) np = LookupCellFile(cstr, fnum);
 
 	 if (np == NULL) {
 	    Tcl_SetResult(interp, "No such cell.", NULL);
-	    if (istr) Tcl_Free(istr);
 	    return TCL_ERROR;
 	 }
 
+	 /* An instance name leads directly to its pins */
 	 ckto = strlen(estr);
-	 for (ob = np->cell; ob != NULL; ob = ob->next) {
-	    if (!strncmp(estr, ob->name, ckto)) {
-	       if (*(ob->name + ckto) == '/' || *(ob->name + ckto) == '\0')
-		  break;
+	 inst = LookupInstance(estr, np);
+	 if (inst != NULL && inst->type == FIRSTPIN)
+	    ob = inst;
+	 else {
+	    inst = NULL;
+	    for (ob = np->cell; ob != NULL; ob = ob->next) {
+	       obname = ob->name;
+	       if (*obname == '/') obname++;
+	       if (!strncmp(estr, obname, ckto)) {
+		  if (*(obname + ckto) == '/' || *(obname + ckto) == '\0')
+		     break;
+	       }
 	    }
 	 }
 	 if (ob == NULL) {
 	    Tcl_SetResult(interp, "No such element.", NULL);
-	    if (istr) Tcl_Free(istr);
 	    return TCL_ERROR;
 	 }
+	 ci = ConnIndex(np);
 	 lobj = Tcl_NewListObj(0, NULL);
 	 for (; ob != NULL; ob = ob->next) {
-	    if (!strncmp(estr, ob->name, ckto)) {
-	       if (*(ob->name + ckto) != '/' && *(ob->name + ckto) != '\0')
+	    if (inst != NULL && ob != inst && ob->type <= FIRSTPIN) break;
+	    obname = ob->name;
+	    if (*obname == '/') obname++;
+	    if (!strncmp(estr, obname, ckto)) {
+	       if (*(obname + ckto) != '/' && *(obname + ckto) != '\0')
 		  continue;
 
 	       pobj = Tcl_NewListObj(0, NULL);
-               Tcl_ListObjAppendElement(interp, pobj,
-			Tcl_NewStringObj(ob->name + ckto + 1, -1));
+               Tcl_ListObjAppendElement(interp, pobj, Tcl_NewStringObj(
+			(*(obname + ckto) == '/') ? obname + ckto + 1 : obname,
+			-1));
 
-	       for (nob = np->cell; nob != NULL; nob = nob->next) {
-		  if (nob->node == ob->node) {
-		     if (nob->type < FIRSTPIN) {
-                        Tcl_ListObjAppendElement(interp, pobj,
-				Tcl_NewStringObj(nob->name, -1));
-		        break;
-		     }
-		  }
+	       if (ci != NULL && ob->node >= 0 && ob->node <= ci->maxnode)
+		  nob = ci->named[ob->node];
+	       else {
+		  for (nob = np->cell; nob != NULL; nob = nob->next)
+		     if (nob->node == ob->node && nob->type < FIRSTPIN)
+			break;
 	       }
+	       if (nob != NULL)
+                  Tcl_ListObjAppendElement(interp, pobj,
+				Tcl_NewStringObj(nob->name, -1));
                Tcl_ListObjAppendElement(interp, lobj, pobj);
 	    }
 	 }
@@ -1198,7 +1274,6 @@ _netgen_nodes(ClientData clientData,
    else
       PrintNodes(cstr, fnum);
   
-   if (istr) Tcl_Free(istr);
    return TCL_OK;
 }
 
@@ -1232,7 +1307,7 @@ _netgen_elements(ClientData clientData,
       }
    }
     
-   if (objc < 1 || objc > 2) {
+   if (objc < 1 || objc > 3) {
       Tcl_WrongNumArgs(interp, 1, objv, "?node? valid_cellname");
       return TCL_ERROR;
    }
@@ -1243,6 +1318,7 @@ _netgen_elements(ClientData clientData,
 	 return TCL_ERROR;
       }
       cstr = CurrentCell->name;
+      fnum = CurrentCell->file;
    }
    else {
       result = CommonParseCell(interp, objv[objc - 1], &np, &fnum);
@@ -1256,8 +1332,9 @@ _netgen_elements(ClientData clientData,
    if (nstr) {
       if (dolist) {
 	 struct objlist *ob;
+	 struct connindex *ci;
 	 Tcl_Obj *lobj;
-	 int nodenum;
+	 int nodenum, i;
 
 	 if (np == NULL) np = LookupCellFile(cstr, fnum);
 
@@ -1266,29 +1343,43 @@ _netgen_elements(ClientData clientData,
 	    return TCL_ERROR;
 	 }
 
-	 for (ob = np->cell; ob != NULL; ob = ob->next) {
-	    if (match(nstr, ob->name)) {
-	       nodenum = ob->node;
-	       break;
-	    }
+	 ob = LookupObject(nstr, np);
+	 if (ob == NULL) {
+	    for (ob = np->cell; ob != NULL; ob = ob->next)
+	       if (match(nstr, ob->name)) break;
 	 }
 	 if (ob == NULL) {
 	    Tcl_SetResult(interp, "No such node.", NULL);
 	    return TCL_ERROR;
 	 }
+	 nodenum = ob->node;
 	 lobj = Tcl_NewListObj(0, NULL);
-	 for (ob = np->cell; ob != NULL; ob = ob->next) {
-	    if (ob->node == nodenum && ob->type >= FIRSTPIN) {
-	       char *obname = ob->name;
-	       if (*obname == '/') obname++;
-               Tcl_ListObjAppendElement(interp, lobj,
+	 ci = ConnIndex(np);
+	 if (ci != NULL && nodenum >= 0 && nodenum <= ci->maxnode) {
+	    for (i = ci->start[nodenum]; i < ci->start[nodenum + 1]; i++) {
+	       ob = ci->obj[i];
+	       if (ob->type >= FIRSTPIN) {
+		  char *obname = ob->name;
+		  if (*obname == '/') obname++;
+		  Tcl_ListObjAppendElement(interp, lobj,
 			Tcl_NewStringObj(obname, -1));
+	       }
+	    }
+	 }
+	 else {
+	    for (ob = np->cell; ob != NULL; ob = ob->next) {
+	       if (ob->node == nodenum && ob->type >= FIRSTPIN) {
+		  char *obname = ob->name;
+		  if (*obname == '/') obname++;
+		  Tcl_ListObjAppendElement(interp, lobj,
+			Tcl_NewStringObj(obname, -1));
+	       }
 	    }
 	 }
 	 Tcl_SetObjResult(interp, lobj);
       }
       else
-         Fanout(cstr, nstr, ALLELEMENTS);
+         Fanout(cstr, nstr, ALLELEMENTS, fnum);
    }
    else {
       PrintAllElements(cstr, fnum);
@@ -2021,27 +2112,580 @@ _netgen_log(ClientData clientData,
    return TCL_OK;
 }
 
-#ifdef HAVE_MALLINFO
 /*------------------------------------------------------*/
 /* Function name: _netgen_printmem			*/
-/* Syntax: netgen::memory				*/
+/* Syntax: netgen::memory [reset|list]			*/
 /* Formerly: m						*/
 /* Results:						*/
+/*    "list" returns a list of {name blocks current	*/
+/*    peak} for each category and for each file, named	*/
+/*    "file <n>".  The list is empty unless netgen was	*/
+/*    configured with --enable-memstats.		*/
 /* Side Effects:					*/
+/*    "reset" sets all peak values to current values.	*/
 /*------------------------------------------------------*/
 
 int
 _netgen_printmem(ClientData clientData,
     Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
 {
-   if (objc != 1) {
-      Tcl_WrongNumArgs(interp, 1, objv, "(no arguments)");
+   char *options[] = {
+      "reset", "list", NULL
+   };
+   enum OptionIdx {
+      RESET_IDX, LIST_IDX
+   };
+   int index, i;
+   char fname[32];
+   Tcl_Obj *mlist, *mitem;
+   struct memstat *ms;
+
+   if (objc > 2) {
+      Tcl_WrongNumArgs(interp, 1, objv, "[reset|list]");
+      return TCL_ERROR;
+   }
+   if (objc == 1) {
+      PrintMemoryStats();
+      return TCL_OK;
+   }
+   if (Tcl_GetIndexFromObj(interp, objv[1], (const char **)options,
+		"option", 0, &index) != TCL_OK)
       return TCL_ERROR;
+
+   switch (index) {
+      case RESET_IDX:
+	 MemResetPeaks();
+	 break;
+
+      case LIST_IDX:
+	 mlist = Tcl_NewListObj(0, NULL);
+#ifdef MEMSTATS
+	 for (i = -MEM_NUMCLASSES; i < MemMaxFile(); i++) {
+	    if (i < 0) {
+	       ms = &MemClassStats[i + MEM_NUMCLASSES];
+	       strcpy(fname, MemClassNames[i + MEM_NUMCLASSES]);
+	    }
+	    else {
+	       ms = MemFileStats(i);
+	       if (ms->peak == 0) continue;
+	       sprintf(fname, "file %d", i);
+	    }
+	    mitem = Tcl_NewListObj(0, NULL);
+	    Tcl_ListObjAppendElement(interp, mitem, Tcl_NewStringObj(fname, -1));
+	    Tcl_ListObjAppendElement(interp, mitem,
+			Tcl_NewWideIntObj((Tcl_WideInt)ms->blocks));
+	    Tcl_ListObjAppendElement(interp, mitem,
+			Tcl_NewWideIntObj((Tcl_WideInt)ms->current));
+	    Tcl_ListObjAppendElement(interp, mitem,
+			Tcl_NewWideIntObj((Tcl_WideInt)ms->peak));
+	    Tcl_ListObjAppendElement(interp, mlist, mitem);
+	 }
+#endif
+	 Tcl_SetObjResult(interp, mlist);
+	 break;
    }
-   PrintMemoryStats();
    return TCL_OK;
 }
+
+/*------------------------------------------------------*/
+/* Function name: _netgen_stats				*/
+/* Syntax: netgen::stats [reset|list|json [<file>]]	*/
+/* Formerly: (none)					*/
+/* Results:						*/
+/*    "list" returns a list of {name calls count wall	*/
+/*    cpu peak} for each phase;  "json" returns the same as	*/
+/*    a JSON object unless a file name is given.  Peak	*/
+/*    memory is zero unless netgen was configured with	*/
+/*    --enable-memstats.				*/
+/* Side Effects:					*/
+/*    "reset" clears all phase counters.		*/
+/*------------------------------------------------------*/
+
+int
+_netgen_stats(ClientData clientData,
+    Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+   char *options[] = {
+      "reset", "list", "json", NULL
+   };
+   enum OptionIdx {
+      RESET_IDX, LIST_IDX, JSON_IDX
+   };
+   int index, i;
+   char *json;
+   FILE *file;
+   Tcl_Obj *slist, *sitem;
+   struct netgenstat *ns;
+
+   if (objc == 1) {
+      StatsPrint();
+      return TCL_OK;
+   }
+   if (Tcl_GetIndexFromObj(interp, objv[1], (const char **)options,
+		"option", 0, &index) != TCL_OK)
+      return TCL_ERROR;
+
+   if ((index != JSON_IDX && objc > 2) || objc > 3) {
+      Tcl_WrongNumArgs(interp, 1, objv, "[reset|list|json [<file>]]");
+      return TCL_ERROR;
+   }
+
+   switch (index) {
+      case RESET_IDX:
+	 StatsReset();
+	 break;
+
+      case LIST_IDX:
+	 slist = Tcl_NewListObj(0, NULL);
+	 for (i = 0; i < STAT_NUMSTATS; i++) {
+	    ns = &NetgenStats[i];
+	    sitem = Tcl_NewListObj(0, NULL);
+	    Tcl_ListObjAppendElement(interp, sitem, Tcl_NewStringObj(ns->name, -1));
+	    Tcl_ListObjAppendElement(interp, sitem, Tcl_NewWideIntObj(ns->calls));
+	    Tcl_ListObjAppendElement(interp, sitem, Tcl_NewWideIntObj(ns->count));
+	    Tcl_ListObjAppendElement(interp, sitem, Tcl_NewDoubleObj(ns->wall));
+	    Tcl_ListObjAppendElement(interp, sitem, Tcl_NewDoubleObj(ns->cpu));
+	    Tcl_ListObjAppendElement(interp, sitem,
+			Tcl_NewWideIntObj((Tcl_WideInt)ns->mempeak));
+	    Tcl_ListObjAppendElement(interp, slist, sitem);
+	 }
+	 Tcl_SetObjResult(interp, slist);
+	 break;
+
+      case JSON_IDX:
+	 json = StatsJSON();
+	 if (objc == 3) {
+	    file = fopen(Tcl_GetString(objv[2]), "w");
+	    if (file == NULL) {
+	       FREE(json);
+	       Tcl_SetResult(interp, "Could not open stats file.", NULL);
+	       return TCL_ERROR;
+	    }
+	    fprintf(file, "%s\n", json);
+	    fclose(file);
+	 }
+	 else
+	    Tcl_SetObjResult(interp, Tcl_NewStringObj(json, -1));
+	 FREE(json);
+	 break;
+   }
+   return TCL_OK;
+}
+
+/*------------------------------------------------------*/
+/* Server mode.  Clients connect to a UNIX-domain	*/
+/* socket and send Tcl commands, one per line (a	*/
+/* command may continue over several lines until it is	*/
+/* complete).  Each command is answered with one line	*/
+/* of JSON:  {"status": "ok"|"error", "result": "...",	*/
+/* "output": "..."}, where "output" is whatever the	*/
+/* command wrote to stdout.  When a client disconnects,	*/
+/* every netlist read while it was connected is		*/
+/* discarded, so libraries read before the server	*/
+/* started, kept with "server keep", or read with	*/
+/* "readlib", are shared by all later clients.  The	*/
+/* working directory, logging, and the global settings	*/
+/* of the comparison (see ServerSettings) are also put	*/
+/* back as they were when the server started.		*/
+/* The socket is accessible to its owner only, since a	*/
+/* client can run any Tcl command.			*/
+/*------------------------------------------------------*/
+
+static int ServerActive = 0;	/* inside "server <socket>" */
+static int ServerStop = 0;	/* "server shutdown" was given */
+static int ServerFileBase = 0;	/* first file number of this client */
+
+/* Global settings that a client may change, saved when the server	*/
+/* starts and restored after each client disconnects.		*/
+
+static struct {
+   int debug;
+   int parallelnone;
+   int parallelopen;
+   int exacttopology;
+   int propertythreads;
+   int leftcol;
+   int rightcol;
+   double interval;
+   double timeout;
+   double deadline;
+   int iterations;
+   char *progressfile;
+   char *progresscommand;
+} ServerSettings;
+
+static void
+ServerSaveSettings(void)
+{
+   ServerSettings.debug = Debug;
+   ServerSettings.parallelnone = GlobalParallelNone;
+   ServerSettings.parallelopen = GlobalParallelOpen;
+   ServerSettings.exacttopology = ExactTopology;
+   ServerSettings.propertythreads = PropertyThreads;
+   ServerSettings.leftcol = left_col_end;
+   ServerSettings.rightcol = right_col_end;
+   ServerSettings.interval = ProgressInterval;
+   ServerSettings.timeout = CompareTimeout;
+   ServerSettings.deadline = JobDeadline;
+   ServerSettings.iterations = IterationBudget;
+   ServerSettings.progressfile = (ProgressFile) ? STRDUP(ProgressFile) : NULL;
+   ServerSettings.progresscommand = (ProgressCommand) ?
+		STRDUP(ProgressCommand) : NULL;
+}
+
+static void
+ServerRestoreSettings(void)
+{
+   Debug = ServerSettings.debug;
+   GlobalParallelNone = ServerSettings.parallelnone;
+   GlobalParallelOpen = ServerSettings.parallelopen;
+   ExactTopology = ServerSettings.exacttopology;
+   PropertyThreads = ServerSettings.propertythreads;
+   left_col_end = ServerSettings.leftcol;
+   right_col_end = ServerSettings.rightcol;
+   ProgressInterval = ServerSettings.interval;
+   CompareTimeout = ServerSettings.timeout;
+   JobDeadline = ServerSettings.deadline;
+   IterationBudget = ServerSettings.iterations;
+   if (ProgressFile) FREE(ProgressFile);
+   ProgressFile = (ServerSettings.progressfile) ?
+		STRDUP(ServerSettings.progressfile) : NULL;
+   if (ProgressCommand) FREE(ProgressCommand);
+   ProgressCommand = (ServerSettings.progresscommand) ?
+		STRDUP(ServerSettings.progresscommand) : NULL;
+}
+
+static void
+ServerFreeSettings(void)
+{
+   if (ServerSettings.progressfile) FREE(ServerSettings.progressfile);
+   if (ServerSettings.progresscommand) FREE(ServerSettings.progresscommand);
+   ServerSettings.progressfile = ServerSettings.progresscommand = NULL;
+}
+
+/* While a client command runs, a channel is stacked on stdout to	*/
+/* collect everything written there, both by Tcl "puts" and by	*/
+/* netgen's own output, so that it can be returned to the client.	*/
+
+static int
+ServerOutputClose(ClientData instanceData, Tcl_Interp *interp)
+{
+   return 0;
+}
+
+static int
+ServerOutputInput(ClientData instanceData, char *buf, int toRead,
+	int *errorCodePtr)
+{
+   *errorCodePtr = EINVAL;
+   return -1;
+}
+
+static int
+ServerOutputWrite(ClientData instanceData, const char *buf, int toWrite,
+	int *errorCodePtr)
+{
+   Tcl_DStringAppend((Tcl_DString *)instanceData, buf, toWrite);
+   return toWrite;
+}
+
+static void
+ServerOutputWatch(ClientData instanceData, int mask)
+{
+}
+
+static int
+ServerOutputHandle(ClientData instanceData, int direction,
+	ClientData *handlePtr)
+{
+   return TCL_ERROR;
+}
+
+static Tcl_ChannelType ServerOutputType = {
+   "netgenoutput", TCL_CHANNEL_VERSION_5, ServerOutputClose,
+   ServerOutputInput, ServerOutputWrite, NULL, NULL, NULL,
+   ServerOutputWatch, ServerOutputHandle, NULL, NULL, NULL, NULL,
+   NULL, NULL, NULL
+};
+
+/* Write all of a buffer to the client socket */
+
+static int
+ServerWrite(int fd, const char *buf, size_t len)
+{
+   ssize_t n;
+   int flags = 0;
+
+#ifdef MSG_NOSIGNAL
+   flags = MSG_NOSIGNAL;	/* a closed client must not kill the server */
 #endif
+   while (len > 0) {
+      n = send(fd, buf, len, flags);
+      if (n < 0) {
+	 if (errno == EINTR) continue;
+	 return -1;
+      }
+      buf += n;
+      len -= n;
+   }
+   return 0;
+}
+
+/* Append a string to a reply, escaped for JSON */
+
+static void
+ServerAppendString(Tcl_DString *reply, const char *str)
+{
+   const char *c;
+   char esc[8];
+
+   for (c = str; *c != '\0'; c++) {
+      switch (*c) {
+	 case '"':  Tcl_DStringAppend(reply, "\\\"", 2); break;
+	 case '\\': Tcl_DStringAppend(reply, "\\\\", 2); break;
+	 case '\n': Tcl_DStringAppend(reply, "\\n", 2); break;
+	 case '\r': Tcl_DStringAppend(reply, "\\r", 2); break;
+	 case '\t': Tcl_DStringAppend(reply, "\\t", 2); break;
+	 default:
+	    if ((unsigned char)*c < 0x20) {
+	       sprintf(esc, "\\u%04x", (unsigned char)*c);
+	       Tcl_DStringAppend(reply, esc, -1);
+	    }
+	    else
+	       Tcl_DStringAppend(reply, c, 1);
+	    break;
+      }
+   }
+}
+
+/* Send one JSON reply line to the client */
+
+static int
+ServerReply(int fd, int status, const char *result, const char *output)
+{
+   Tcl_DString reply;
+   int rval;
+
+   Tcl_DStringInit(&reply);
+   Tcl_DStringAppend(&reply, "{\"status\": \"", -1);
+   Tcl_DStringAppend(&reply, (status == TCL_OK) ? "ok" : "error", -1);
+   Tcl_DStringAppend(&reply, "\", \"result\": \"", -1);
+   ServerAppendString(&reply, result);
+   Tcl_DStringAppend(&reply, "\", \"output\": \"", -1);
+   ServerAppendString(&reply, output);
+   Tcl_DStringAppend(&reply, "\"}\n", 3);
+   rval = ServerWrite(fd, Tcl_DStringValue(&reply), Tcl_DStringLength(&reply));
+   Tcl_DStringFree(&reply);
+   return rval;
+}
+
+/* Run one client command, collecting what it writes to stdout */
+
+static int
+ServerEval(Tcl_Interp *interp, char *command, Tcl_DString *output)
+{
+   Tcl_Channel out, chan;
+   int status;
+
+   Tcl_DStringSetLength(output, 0);
+   chan = NULL;
+   out = Tcl_GetStdChannel(TCL_STDOUT);
+   if (out != NULL) {
+      Tcl_Flush(out);
+      chan = Tcl_StackChannel(NULL, &ServerOutputType, (ClientData)output,
+		TCL_WRITABLE, out);
+   }
+   status = Tcl_EvalEx(interp, command, -1, TCL_EVAL_GLOBAL);
+   if (chan != NULL) Tcl_UnstackChannel(NULL, chan);
+   return status;
+}
+
+/* Read and run commands from one client until it disconnects */
+
+static void
+ServerClient(Tcl_Interp *interp, int fd)
+{
+   Tcl_DString command, output;
+   char buf[4096];
+   char *line, *nl;
+   ssize_t n;
+   int status, start, len, connected;
+
+   Tcl_DStringInit(&command);
+   Tcl_DStringInit(&output);
+   start = 0;
+   connected = 1;
+   while (connected && !ServerStop) {
+      n = recv(fd, buf, sizeof(buf), 0);
+      if (n < 0) {
+	 if (errno == EINTR) continue;
+	 break;
+      }
+      if (n == 0) break;
+      Tcl_DStringAppend(&command, buf, n);
+
+      /* Run each complete command in the buffer */
+      while (!ServerStop) {
+	 line = Tcl_DStringValue(&command);
+	 nl = strchr(line + start, '\n');
+	 if (nl == NULL) break;
+	 start = nl - line + 1;
+	 *nl = '\0';
+	 if (!Tcl_CommandComplete(line)) {
+	    *nl = '\n';
+	    continue;
+	 }
+	 status = ServerEval(interp, line, &output);
+	 if (ServerReply(fd, status, Tcl_GetStringResult(interp),
+			Tcl_DStringValue(&output)) < 0)
+	    connected = 0;	/* client went away */
+	 Tcl_ResetResult(interp);
+	 if (!connected) break;
+
+	 /* Remove the command from the buffer */
+	 len = Tcl_DStringLength(&command) - start;
+	 line = Tcl_DStringValue(&command);
+	 memmove(line, line + start, len);
+	 Tcl_DStringSetLength(&command, len);
+	 start = 0;
+      }
+   }
+   Tcl_DStringFree(&command);
+   Tcl_DStringFree(&output);
+}
+
+/* Discard everything a client left behind */
+
+static void
+ServerCleanup(Tcl_Obj *cwd, int nooutput)
+{
+   if (LoggingFile) {
+      fclose(LoggingFile);
+      LoggingFile = NULL;
+   }
+   NoOutput = nooutput;
+   if (cwd != NULL) Tcl_FSChdir(cwd);
+   ServerRestoreSettings();
+
+   RemoveCompareQueue();
+   ResetState();
+   CellDeleteFiles(ServerFileBase);
+   FreeGarbageList();
+   FreeExpressionCache();
+}
+
+/*------------------------------------------------------*/
+/* Function name: _netgen_server			*/
+/* Syntax: netgen::server <socket>|keep|shutdown	*/
+/* Formerly: (none)					*/
+/* Results:						*/
+/*    none						*/
+/* Side Effects:					*/
+/*    "server <socket>" runs client commands until a	*/
+/*    client gives "server shutdown".  Netlists read by	*/
+/*    a client are deleted when it disconnects, unless	*/
+/*    it gave "server keep" after reading them.		*/
+/*------------------------------------------------------*/
+
+int
+_netgen_server(ClientData clientData,
+    Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+   struct sockaddr_un addr;
+   struct stat sbuf;
+   Tcl_Obj *cwd;
+   char *path;
+   int sock, fd, nooutput;
+   mode_t oldmask;
+
+   if (objc != 2) {
+      Tcl_WrongNumArgs(interp, 1, objv, "<socket>|keep|shutdown");
+      return TCL_ERROR;
+   }
+   path = Tcl_GetString(objv[1]);
+
+   if (!strcmp(path, "keep") || !strcmp(path, "shutdown")) {
+      if (!ServerActive) {
+	 Tcl_SetResult(interp, "Not running as a server.", NULL);
+	 return TCL_ERROR;
+      }
+      if (path[0] == 'k')
+	 ServerFileBase = NextFileNumber();
+      else
+	 ServerStop = 1;
+      return TCL_OK;
+   }
+   if (ServerActive) {
+      Tcl_SetResult(interp, "Server is already running.", NULL);
+      return TCL_ERROR;
+   }
+   if (strlen(path) >= sizeof(addr.sun_path)) {
+      Tcl_SetResult(interp, "Socket path is too long.", NULL);
+      return TCL_ERROR;
+   }
+
+   sock = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (sock < 0) {
+      Tcl_SetResult(interp, "Could not create socket.", NULL);
+      return TCL_ERROR;
+   }
+   /* Commands run with "exec" must not hold the socket open */
+   fcntl(sock, F_SETFD, FD_CLOEXEC);
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, path);
+
+   /* Replace a socket left by an earlier server, but nothing else */
+   if (lstat(path, &sbuf) == 0) {
+      if (!S_ISSOCK(sbuf.st_mode)) {
+	 close(sock);
+	 Tcl_SetResult(interp, "Socket path exists and is not a socket.", NULL);
+	 return TCL_ERROR;
+      }
+      unlink(path);
+   }
+
+   /* Create the socket with owner-only permissions */
+   oldmask = umask(077);
+   if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      umask(oldmask);
+      close(sock);
+      Tcl_SetResult(interp, "Could not bind socket.", NULL);
+      return TCL_ERROR;
+   }
+   umask(oldmask);
+   if ((chmod(path, S_IRUSR | S_IWUSR) < 0) || (listen(sock, 8) < 0)) {
+      close(sock);
+      unlink(path);
+      Tcl_SetResult(interp, "Could not listen on socket.", NULL);
+      return TCL_ERROR;
+   }
+   Printf("Netgen server listening on %s\n", path);
+
+   cwd = Tcl_FSGetCwd(interp);	/* returned with a reference count */
+   nooutput = NoOutput;
+   ServerSaveSettings();
+   ServerActive = 1;
+   ServerStop = 0;
+   while (!ServerStop) {
+      fd = accept(sock, NULL, NULL);
+      if (fd < 0) {
+	 if (errno == EINTR) continue;
+	 break;
+      }
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+      ServerFileBase = NextFileNumber();
+      ServerClient(interp, fd);
+      close(fd);
+      ServerCleanup(cwd, nooutput);
+   }
+   ServerActive = 0;
+   ServerFreeSettings();
+   if (cwd != NULL) Tcl_DecrRefCount(cwd);
+   close(sock);
+   unlink(path);
+   return TCL_OK;
+}
 
 /*------------------------------------------------------*/
 /* Function name: _netcmp_format			*/
@@ -2511,6 +3155,11 @@ _netcmp_run(ClientData clientData,
 	    while (!Iterate() && !InterruptPending);
 	    ExhaustiveSubdivision = 1;
 	    while (!Iterate() && !InterruptPending);
+	    if (BudgetExceeded) {
+	       Fprintf(stdout, "Netlists not resolved:  comparison incomplete.\n");
+	       disable_interrupt();
+	       break;
+	    }
 	    automorphisms = VerifyMatching();
 	    if (automorphisms > 0) {
 	       // First try to resolve automorphisms uniquely using
@@ -2529,11 +3178,13 @@ _netcmp_run(ClientData clientData,
 	       }
 	       if (automorphisms > 0) {
 	          // Anything left is truly indistinguishable
-		  while (ResolveAutomorphisms() > 0);
+		  while (!BudgetExceeded && ResolveAutomorphisms() > 0);
 	       }
 	    }
 
-	    if (automorphisms == -1)
+	    if (BudgetExceeded)
+	       Fprintf(stdout, "Netlists not resolved:  comparison incomplete.\n");
+	    else if (automorphisms == -1)
 	       Fprintf(stdout, "Netlists do not match.\n");
 	    else if (automorphisms == -2) {
 	       Fprintf(stdout, "Netlists match uniquely with port");
@@ -2640,10 +3291,34 @@ _netcmp_verify(ClientData clientData,
 	 Fprintf(stdout, "Verify:  no current cell to verify.\n");
       return TCL_OK;
    }
+   else if (BudgetExceeded) {
+      /* Refinement stopped early, so any match would be false.	*/
+      /* Report only what was found before it stopped.		*/
+      if (index == EQUIV_IDX || index == UNIQUE_IDX) {
+	 Tcl_SetObjResult(interp, Tcl_NewBooleanObj(0));
+	 return TCL_OK;
+      }
+      Fprintf(stdout, "Verify:  comparison of %s and %s is incomplete.\n",
+		Circuit1->name, Circuit2->name);
+      if (PrintPartialResult()) {
+	 StatStart(STAT_REPORT);
+	 if (objc == 1 || index == NODE_IDX || index == ALL_IDX) {
+	    FormatIllegalNodeClasses();
+	    if (dolist) nbad = ListNodeClasses(FALSE);
+	 }
+	 if (objc == 1 || index == ELEM_IDX || index == ALL_IDX) {
+	    FormatIllegalElementClasses();
+	    if (dolist) ebad = ListElementClasses(FALSE);
+	 }
+	 StatStop(STAT_REPORT);
+	 Fprintf(stdout, "Netlists do not match.\n");
+      }
+   }
    else {
       automorphisms = VerifyMatching();
       if (automorphisms == -1) {
 	 enable_interrupt();
+	 StatStart(STAT_REPORT);
 	 if (objc == 1 || index == NODE_IDX || index == ALL_IDX) {
 	     if (Debug == TRUE)
 	        PrintIllegalNodeClasses();	// Old style
@@ -2670,6 +3345,7 @@ _netcmp_verify(ClientData clientData,
 		}
 	     }
 	 }
+	 StatStop(STAT_REPORT);
 	 disable_interrupt();
 	 if (index == EQUIV_IDX || index == UNIQUE_IDX)
 	     Tcl_SetObjResult(interp, Tcl_NewBooleanObj(0));
@@ -3405,6 +4081,9 @@ _netcmp_equate(ClientData clientData,
 /*	tolerance --- set property tolerance		*/
 /*	associate --- associate property with a pin	*/
 /*	topology  --- set exact/relaxed matching	*/
+/*	threads   --- threads checking properties and	*/
+/*		      finding parallel devices		*/
+/*		      (0 = one per processor)		*/
 /*	merge	  --- (deprecated)			*/
 /* or							*/
 /*	netgen::property default			*/
@@ -3443,11 +4122,11 @@ _netcmp_property(ClientData clientData,
     int ival, argstart;
 
     char *topoptions[] = {
-	"default", "series", "serial", "parallel", "topology", NULL
+	"default", "series", "serial", "parallel", "topology", "threads", NULL
     };
     enum TopOptionIdx {
 	TOP_DEFAULT_IDX, TOP_SERIES_IDX, TOP_SERIAL_IDX, TOP_PARALLEL_IDX,
-	TOP_TOPOLOGY_IDX
+	TOP_TOPOLOGY_IDX, TOP_THREADS_IDX
     };
 
     char *options[] = {
@@ -3632,6 +4311,21 @@ _netcmp_property(ClientData clientData,
 	}
 	return TCL_OK;
     }
+    else if ((objc > 1) && (index == TOP_THREADS_IDX)) {
+	if (objc == 2) {
+	    Tcl_SetObjResult(interp, Tcl_NewIntObj(PropertyThreads));
+	}
+	else if (objc == 3) {
+	    if (Tcl_GetIntFromObj(interp, objv[2], &ival) != TCL_OK)
+		return TCL_ERROR;
+	    PropertyThreads = (ival < 0) ? 0 : ival;
+	}
+	else {
+	    Tcl_WrongNumArgs(interp, 1, objv, "threads ?number?");
+	    return TCL_ERROR;
+	}
+	return TCL_OK;
+    }
 
     result = CommonParseCell(interp, objv[1], &tp, &fnum);
     if (result != TCL_OK) return result;
@@ -3918,6 +4612,7 @@ _netcmp_property(ClientData clientData,
 		    RecurseHashTable(&(tp->propdict), freeprop);
 		    HashKill(&(tp->propdict));
 		    InitializeHashTable(&(tp->propdict), OBJHASHSIZE);
+		    FreePropertyIndex(tp);
 		}
 		else {
 		    for (i = 3; i < objc; i++)
@@ -4282,6 +4977,125 @@ _netcmp_exhaustive(ClientData clientData,
    return TCL_OK;
 }
 
+/*------------------------------------------------------*/
+/* Function name: _netcmp_progress			*/
+/* Syntax: netgen::progress [-interval <seconds>]	*/
+/*	[-command <cmd>] [-file <name>]			*/
+/*	[-timeout <seconds>] [-iterations <n>]		*/
+/*	[-deadline <seconds>]				*/
+/* Formerly: (none)					*/
+/* Results:						*/
+/*    With no options, returns the current settings	*/
+/*    (with the time left before the deadline), whether	*/
+/*    the last comparison ran out of its budget, and	*/
+/*    whether the deadline has passed.			*/
+/* Side Effects:					*/
+/*    Sets progress reporting and the iteration budget	*/
+/*    for all following comparisons.  The timeout and	*/
+/*    the iteration limit apply to each pair of cells	*/
+/*    compared, starting when the comparison starts.	*/
+/*    The deadline covers every comparison, and is	*/
+/*    measured from the time this command is run.	*/
+/*------------------------------------------------------*/
+
+int
+_netcmp_progress(ClientData clientData,
+    Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+   char *options[] = {
+      "-interval", "-command", "-file", "-timeout", "-iterations",
+      "-deadline", NULL
+   };
+   enum OptionIdx {
+      INTERVAL_IDX, COMMAND_IDX, FILE_IDX, TIMEOUT_IDX, ITERATIONS_IDX,
+      DEADLINE_IDX
+   };
+   int i, index, ival;
+   double dval, now;
+   char *sval;
+   Tcl_Obj *slist;
+
+   if (objc == 1) {
+      now = WallTime();
+      slist = Tcl_NewListObj(0, NULL);
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-interval", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewDoubleObj(ProgressInterval));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-command", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj((ProgressCommand)
+		? ProgressCommand : "", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-file", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj((ProgressFile)
+		? ProgressFile : "", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-timeout", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewDoubleObj(CompareTimeout));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-iterations", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewIntObj(IterationBudget));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("-deadline", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewDoubleObj((JobDeadline
+		> now) ? JobDeadline - now : 0.0));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("exceeded", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewBooleanObj(BudgetExceeded));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewStringObj("expired", -1));
+      Tcl_ListObjAppendElement(interp, slist, Tcl_NewBooleanObj((JobDeadline
+		> 0.0) && (now >= JobDeadline)));
+      Tcl_SetObjResult(interp, slist);
+      return TCL_OK;
+   }
+   if ((objc & 1) == 0) {
+      Tcl_WrongNumArgs(interp, 1, objv, "[-option value ...]");
+      return TCL_ERROR;
+   }
+
+   for (i = 1; i < objc; i += 2) {
+      if (Tcl_GetIndexFromObj(interp, objv[i], (const char **)options,
+		"option", 0, &index) != TCL_OK)
+	 return TCL_ERROR;
+
+      switch (index) {
+	 case INTERVAL_IDX:
+	 case TIMEOUT_IDX:
+	 case DEADLINE_IDX:
+	    if (Tcl_GetDoubleFromObj(interp, objv[i + 1], &dval) != TCL_OK)
+	       return TCL_ERROR;
+	    if (dval < 0.0) {
+	       Tcl_SetResult(interp, "Value must not be negative.", NULL);
+	       return TCL_ERROR;
+	    }
+	    if (index == INTERVAL_IDX)
+	       ProgressInterval = dval;
+	    else if (index == TIMEOUT_IDX)
+	       CompareTimeout = dval;
+	    else
+	       JobDeadline = (dval > 0.0) ? WallTime() + dval : 0.0;
+	    break;
+
+	 case ITERATIONS_IDX:
+	    if (Tcl_GetIntFromObj(interp, objv[i + 1], &ival) != TCL_OK)
+	       return TCL_ERROR;
+	    if (ival < 0) {
+	       Tcl_SetResult(interp, "Value must not be negative.", NULL);
+	       return TCL_ERROR;
+	    }
+	    IterationBudget = ival;
+	    break;
+
+	 case COMMAND_IDX:
+	 case FILE_IDX:
+	    sval = Tcl_GetString(objv[i + 1]);
+	    if (index == COMMAND_IDX) {
+	       if (ProgressCommand) FREE(ProgressCommand);
+	       ProgressCommand = (*sval == '\0') ? NULL : STRDUP(sval);
+	    }
+	    else {
+	       if (ProgressFile) FREE(ProgressFile);
+	       ProgressFile = (*sval == '\0') ? NULL : STRDUP(sval);
+	    }
+	    break;
+      }
+   }
+   return TCL_OK;
+}
+
 /*------------------------------------------------------*/
 /* Function name: _netcmp_restart			*/
 /* Syntax: netgen::restart				*/
@@ -4407,18 +5221,6 @@ _netcmp_matching(ClientData clientData,
 }
 
 
-/*------------------------------------------------------*/
-/* Define a calloc() function for Tcl			*/
-/*------------------------------------------------------*/
-
-char *tcl_calloc(size_t asize, size_t nbytes)
-{
-   size_t tsize = asize * nbytes;
-   char *cp = Tcl_Alloc((int)tsize);
-   bzero((void *)cp, tsize);
-   return cp;
-}
-
 /*------------------------------------------------------*/
 /* Redefine the printf() functions for use with tkcon	*/
 /*------------------------------------------------------*/
@@ -4504,26 +5306,6 @@ void tcl_stdflush(FILE *f)
    Tcl_RestoreInterpState(netgeninterp, state);
 }
 
-/*------------------------------------------------------*/
-/* Define a version of strdup() that uses Tcl_Alloc	*/
-/* to match the use of Tcl_Free() for calls to FREE()	*/
-/* Note objlist.h and config.h definitions for		*/
-/* strsave() and STRDUP().				*/
-/*------------------------------------------------------*/
-
-char *Tcl_Strdup(const char *s)
-{
-   char *snew;
-   int slen;
-
-   slen = 1 + strlen(s);
-   snew = Tcl_Alloc(slen);
-   if (snew != NULL)
-      memcpy(snew, s, slen);
-
-   return snew;
-}
-
 /*------------------------------------------------------*/
 /* Experimental---generate an interrupt condition	*/
 /* from a Control-C in the console window.		*/